@@ -48,35 +48,26 @@ class _MyAppState extends State<MyApp> {
     String outputFile = join(filePath, "${key}.csv");
     var dataFile = File(join(outputFile));
     await dataFile.create(recursive: true);
+    // samples are decoded and formatted in native code, written in large blocks
+    var exporter = UncompressExporter(outputFile);
+    if (!exporter.isOpen) {
+      print("$key cannot open $outputFile \n");
+      return;
+    }
 
     int currentIndex = 0 ;
-    int numberOfMissingData = 0 ;
-    int numberOfSyncData = 0 ;
-    int numberOfData = 0 ;
+    int numberOfWrongTemps = 0 ;
+    int numberOfWrongTime = 0 ;
       while (true) {
         List<int> values = await Future.delayed(
             Duration(milliseconds: 500), () => listData[currentIndex]);
 
-        // List<int> values = listData[currentIndex] ;
-
         try {
-          // var messages = UncompressUtil.uncompress(values);
-          //estimate the time here  ;
-          List<UncompressedRecord> messages = UncompressUtil.uncompress(values) ;
-          // var messages = await Future.delayed(Duration(milliseconds: 50) , () => UncompressUtil.uncompress(values));
-          await Future.delayed(Duration(milliseconds: 500));
-          String messageString = "";
-        messages.forEach((element) {
-          numberOfData++;
-          if (element.temp < 0 || element.temp > 10000) {
-            numberOfMissingData++;
-          }
-          if (element.time < 0 || element.time > 1999999999) {
-            numberOfSyncData++;
-          }
-          messageString+="${element.time};${element.temp}\n";
-        });
-          dataFile.writeAsStringSync(messageString, mode: FileMode.append);
+          exporter.add(values);
+          // diagnostics, on the samples of the frame decoded alone
+          UncompressStats stats = UncompressUtil.statistics(values);
+          numberOfWrongTemps += stats.nbInvalidTemp + stats.nbUnreceived;
+          numberOfWrongTime += stats.nbInvalidTime;
 
           if (currentIndex + 1 < listData.length) {
             currentIndex++;
@@ -87,7 +78,9 @@ class _MyAppState extends State<MyApp> {
           print(e) ;
         }
       }
-    print("$key numberOfData $numberOfData numberOfWrongTemps $numberOfMissingData / numberOfWrongTime $numberOfSyncData \n");
+    int numberOfData = exporter.length;
+    exporter.close();
+    print("$key numberOfData $numberOfData numberOfWrongTemps $numberOfWrongTemps / numberOfWrongTime $numberOfWrongTime \n");
 
   }
 
@@ -53,25 +53,38 @@ enum {
     C9_DEC_DIRECT,
     C_NB_DEC
 };
+#define BYTES2BITS(val)                 ((val) << 3)
 #define MAX_VALUE(n)                    ((1<<n)-1)
 #define NUMBER_BITS_AND_MAX_VALUE(n)     n, MAX_VALUE(n)
+// Samples without a valid time accepted after a resync anchor before the sample confirming it
+#define RESYNC_MAX_UNCONFIRMED          CT_UNRECEIVED_COUNTER_MAX
 
 //****************************************************************************
 // static Structures typedef
 //****************************************************************************
 
+// Context given to the handlers while decoding a frame
+typedef struct {
+    samples_t           *p_samples;     // where to store uncompressed samples
+    uncompress_state_t  *p_state;       // decoder state, updated by the handlers
+    uint8_t             corrupted;      // set by the handlers on a code that cannot be in a sound frame
+    uncompress_writer_t *p_writer;      // if set, samples are written there instead of p_samples
+    record_t            record;         // sample being decoded when p_writer is set
+    uint32_t            nbWritten;      // samples given to p_writer
+} def_uncompress_ctx_t;
+
 // Structure to describe each timestamp/temperature decoder for CT/C9 compressed data
 typedef struct {
     uint8_t nbBits;      // number of bits to use
     uint8_t max_value;   // the high value (using all the bits at 1), telling that the next decoder should be used (current bits are consumed)
-    uint8_t (*handler)(samples_t *p_samples, uint32_t parameter);  // handler to call if we get there
+    uint8_t (*handler)(def_uncompress_ctx_t *p_ctx, uint32_t parameter);  // handler to call if we get there
 
     // If diff is 1, it's a diff value, then decode values through diff_values, otherwise we will try handlers.
     uint16_t nbDiff;
     int16_t diff_values[C_DIFF_MAX_NB];
 
     struct {
-        uint8_t (*handler)(samples_t *p_samples, uint32_t parameter);    // Function to call to handle this value. Return the next index to handle
+        uint8_t (*handler)(def_uncompress_ctx_t *p_ctx, uint32_t parameter);    // Function to call to handle this value. Return the next index to handle
         uint8_t nbBitsParam;                                            // mandatory nb bits for the parameter of the handler, to be read from stream by called of handler
                                                                         // handler won't be called if these bits are not available from the stream
     } handlers[C_HANDLERS_MAX_NB];
@@ -81,19 +94,30 @@ typedef struct {
 //****************************************************************************
 // static Functions prototypes
 //****************************************************************************
-static void ct_handler_add_value(samples_t *p_samples, uint32_t value, uint8_t addPeriod, uint8_t invalidValue);
-static uint8_t ct_handler_differential(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_minus_one(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_plus_one(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_unexpected(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_unreceived(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_direct(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_invalid(samples_t *p_samples, uint32_t parameter);
-static uint8_t ct_handler_new_period(samples_t *p_samples, uint32_t parameter);
-
-static void c9_handler_add_value(samples_t *p_samples, uint32_t value);
-static uint8_t c9_handler_differential(samples_t *p_samples, uint32_t parameter);
-static uint8_t c9_handler_direct(samples_t *p_samples, uint32_t parameter);
+static record_t *uncompress_current(def_uncompress_ctx_t *p_ctx);
+static void uncompress_sample_done(def_uncompress_ctx_t *p_ctx);
+static void uncompress_period_changed(def_uncompress_ctx_t *p_ctx);
+static void ct_handler_add_value(def_uncompress_ctx_t *p_ctx, uint32_t value, uint8_t addPeriod, uint8_t invalidValue);
+static uint8_t ct_handler_differential(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_minus_one(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_plus_one(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_unexpected(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_unreceived(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_direct(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_invalid(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t ct_handler_new_period(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+
+static void c9_handler_add_value(def_uncompress_ctx_t *p_ctx, uint32_t value);
+static uint8_t c9_handler_differential(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+static uint8_t c9_handler_direct(def_uncompress_ctx_t *p_ctx, uint32_t parameter);
+
+static uint8_t uncompress_run(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state,
+                              const uncompress_resync_config_t *p_config, uncompress_resync_report_t *p_report,
+                              uncompress_writer_t *p_writer);
+static uint8_t uncompress_time_is_plausible(const uncompress_resync_config_t *p_config, uint32_t time, uint32_t refTime);
+static uint16_t uncompress_find_anchor(const uint8_t *buffer, uint8_t len, uint16_t fromBit,
+                                       const uncompress_resync_config_t *p_config, uint32_t refTime, uint32_t *p_time);
+static void uncompress_report_skip(uncompress_resync_report_t *p_report, uint16_t firstBit, uint16_t nbBits);
 
 
 //****************************************************************************
@@ -158,150 +182,289 @@ static const def_C_decode_t C_dec[C_NB_DEC] = {
     }
 };
 
-static uint32_t lastValidTime = UINT32_MAX;
-static uint16_t currentPeriod = UINT16_MAX;
-static uint16_t nbPeriodToAdd = 0;
+// Decoder state used by lib_uncompress_data
+static uncompress_state_t state = {
+    .lastValidTime = UINT32_MAX,
+    .currentPeriod = UINT16_MAX,
+    .nbPeriodToAdd = 0,
+    .lastValidTempe = INVALID_TEMPERATURE,
+};
 
 //****************************************************************************
 // Functions
 //****************************************************************************
 
 //****************************************************************************
-static void ct_handler_add_value(samples_t *p_samples, uint32_t value, uint8_t addPeriod, uint8_t invalidValue)
+// The sample being decoded
+static record_t *uncompress_current(def_uncompress_ctx_t *p_ctx)
+{
+    if (p_ctx->p_writer) {
+        return &p_ctx->record;
+    }
+    return &p_ctx->p_samples->samples[p_ctx->p_samples->nbSamples];
+}
+
+//****************************************************************************
+// The time and temperature of the current sample are set, move to the next one
+static void uncompress_sample_done(def_uncompress_ctx_t *p_ctx)
+{
+    if (p_ctx->p_writer) {
+        lib_uncompress_writer_add_one(p_ctx->p_writer, &p_ctx->record);
+        p_ctx->nbWritten++;
+    } else {
+        p_ctx->p_samples->nbSamples++;
+    }
+}
+
+//****************************************************************************
+// The period is changed from the sample being decoded on, report it with the samples
+static void uncompress_period_changed(def_uncompress_ctx_t *p_ctx)
 {
+    samples_t *p_samples = p_ctx->p_samples;
+    uncompress_period_t *p_last;
+
+    if (p_ctx->p_writer) {
+        return;     // no samples_t, the writer only needs the times
+    }
+    p_last = &p_samples->periods[p_samples->nbPeriods - 1];
+    // several changes before a sample: only the last one is used
+    if ((p_last->firstSample != p_samples->nbSamples) && (p_samples->nbPeriods < UNCOMPRESS_NB_MAX_PERIODS)) {
+        p_last++;
+        p_last->firstSample = p_samples->nbSamples;
+        p_samples->nbPeriods++;
+    }
+    p_last->period = p_ctx->p_state->currentPeriod;
+}
+
+//****************************************************************************
+static void ct_handler_add_value(def_uncompress_ctx_t *p_ctx, uint32_t value, uint8_t addPeriod, uint8_t invalidValue)
+{
+    record_t *p_record = uncompress_current(p_ctx);
     NRF_LOG_DEBUG("  ct_handler_add_value %u, addPeriod %u", value, addPeriod);
-    p_samples->samples[p_samples->nbSamples].time = value;
+    p_record->time = value;
     if (!invalidValue) {
-        if (addPeriod && (currentPeriod != UINT16_MAX)) {
-            NRF_LOG_DEBUG("      Adding %u periods %u to ref %u", nbPeriodToAdd+1, currentPeriod, p_samples->samples[p_samples->nbSamples].time);
-            p_samples->samples[p_samples->nbSamples].time += (nbPeriodToAdd+1) * currentPeriod;
-            nbPeriodToAdd = 0;
+        if (addPeriod && (p_ctx->p_state->currentPeriod != UINT16_MAX)) {
+            NRF_LOG_DEBUG("      Adding %u periods %u to ref %u", p_ctx->p_state->nbPeriodToAdd+1, p_ctx->p_state->currentPeriod, p_record->time);
+            p_record->time += (p_ctx->p_state->nbPeriodToAdd+1) * p_ctx->p_state->currentPeriod;
+            p_ctx->p_state->nbPeriodToAdd = 0;
         }
-        lastValidTime = p_samples->samples[p_samples->nbSamples].time;
-        NRF_LOG_DEBUG("      New time ref is %u", lastValidTime);
+        p_ctx->p_state->lastValidTime = p_record->time;
+        NRF_LOG_DEBUG("      New time ref is %u", p_ctx->p_state->lastValidTime);
     } else {
-        nbPeriodToAdd++;
+        p_ctx->p_state->nbPeriodToAdd++;
     }
 }
 
 //****************************************************************************
-static uint8_t ct_handler_minus_one(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_minus_one(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_minus_one %u", parameter);
-    ct_handler_add_value(p_samples, lastValidTime-1, 1, 0);
+    ct_handler_add_value(p_ctx, p_ctx->p_state->lastValidTime-1, 1, 0);
     return C9_START_DEC_3;
 }
 
 //****************************************************************************
-static uint8_t ct_handler_plus_one(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_plus_one(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_plus_one %u", parameter);
-    ct_handler_add_value(p_samples, lastValidTime+1, 1, 0);
+    ct_handler_add_value(p_ctx, p_ctx->p_state->lastValidTime+1, 1, 0);
     return C9_START_DEC_3;
 }
 
 //****************************************************************************
-static uint8_t ct_handler_unexpected(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_unexpected(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_WARNING("  ct_handler_unexpected %u", parameter);
     // Here we got a code which is not expected in the frame. Only ignore it
+    p_ctx->corrupted = 1;
     return CT_START_DEC_1;  // keep timestamp uncoding
 }
 
 //****************************************************************************
-static uint8_t ct_handler_unreceived(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_unreceived(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_unreceived %u", parameter);
     // we need the next 6 bits to add the coded unreceived samples in the output data
     for(uint8_t i=0;i<parameter;i++) {
-        ct_handler_add_value(p_samples, UINT32_MAX, 0, 1);
+        ct_handler_add_value(p_ctx, UINT32_MAX, 0, 1);
         // do not use c9_handler_add_value to store temperature, the value -1 would be used as next reference.
-        p_samples->samples[p_samples->nbSamples].tempe = UINT16_MAX;
-        NRF_LOG_DEBUG("    SAMPLE #%u: unreceived", p_samples->nbSamples+1);
-        p_samples->nbSamples++;
-        //c9_handler_add_value(p_samples, UINT16_MAX);
+        uncompress_current(p_ctx)->tempe = UINT16_MAX;
+        NRF_LOG_DEBUG("    SAMPLE: unreceived");
+        uncompress_sample_done(p_ctx);
+        //c9_handler_add_value(p_ctx, UINT16_MAX);
     }
 
     return CT_START_DEC_1;
 }
 
 //****************************************************************************
-static uint8_t ct_handler_direct(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_direct(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_direct %u", parameter);
     // we need the next 32 bits to add the raw timestamp
-    ct_handler_add_value(p_samples, parameter, 0, 0); // we may have called this handler directly
-    nbPeriodToAdd = 0; // ignore previous added periods for a direct value
+    ct_handler_add_value(p_ctx, parameter, 0, 0); // we may have called this handler directly
+    p_ctx->p_state->nbPeriodToAdd = 0; // ignore previous added periods for a direct value
     return C9_START_DEC_3;
 }
 
 //****************************************************************************
-static uint8_t ct_handler_differential(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_differential(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_differential %d", parameter);
     // we need the next 32 bits to add the raw timestamp
-    ct_handler_add_value(p_samples, lastValidTime+parameter, 1, 0);
+    ct_handler_add_value(p_ctx, p_ctx->p_state->lastValidTime+parameter, 1, 0);
     return C9_START_DEC_3;
 }
 
 //****************************************************************************
-static uint8_t ct_handler_invalid(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_invalid(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_invalid %u", parameter);
     // Add an invalid timestamp
-    ct_handler_add_value(p_samples, UINT32_MAX, 0, 1);
+    ct_handler_add_value(p_ctx, UINT32_MAX, 0, 1);
     // the temperature follows, do not update nbSamples
     return C9_START_DEC_3;
 }
 
 //****************************************************************************
-static uint8_t ct_handler_new_period(samples_t *p_samples, uint32_t parameter)
+static uint8_t ct_handler_new_period(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  ct_handler_new_period %u", parameter);
     // we need the next 16 bits to set the new period
-    currentPeriod = (uint16_t)parameter;
+    p_ctx->p_state->currentPeriod = (uint16_t)parameter;
+    uncompress_period_changed(p_ctx);
     return CT_START_DEC_1;  // next data are timestamp
 }
 
-static int16_t  lastValidTempe = INVALID_TEMPERATURE;
-
 //****************************************************************************
-static void c9_handler_add_value(samples_t *p_samples, uint32_t value)
+static void c9_handler_add_value(def_uncompress_ctx_t *p_ctx, uint32_t value)
 {
+    record_t *p_record = uncompress_current(p_ctx);
     NRF_LOG_DEBUG("  c9_handler_add_value %d", (int16_t)value);
     if (value == C9_INVALID_TEMPERATURE) {
         value = INVALID_TEMPERATURE;
     } else {
-        lastValidTempe = value;
-        NRF_LOG_DEBUG("      New tempe ref is %d", lastValidTempe);
+        p_ctx->p_state->lastValidTempe = value;
+        NRF_LOG_DEBUG("      New tempe ref is %d", p_ctx->p_state->lastValidTempe);
     }
-    p_samples->samples[p_samples->nbSamples].tempe = (int16_t)value;
-    NRF_LOG_DEBUG("    SAMPLE #%u: %u, %d", p_samples->nbSamples+1, p_samples->samples[p_samples->nbSamples].time, p_samples->samples[p_samples->nbSamples].tempe);
-    p_samples->nbSamples++;
+    p_record->tempe = (int16_t)value;
+    NRF_LOG_DEBUG("    SAMPLE: %u, %d", p_record->time, p_record->tempe);
+    uncompress_sample_done(p_ctx);
 }
 
 //****************************************************************************
-static uint8_t c9_handler_differential(samples_t *p_samples, uint32_t parameter)
+static uint8_t c9_handler_differential(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  c9_handler_differential %d", parameter);
-    if (lastValidTempe == INVALID_TEMPERATURE) {
+    if (p_ctx->p_state->lastValidTempe == INVALID_TEMPERATURE) {
         // error we have no reference
         NRF_LOG_WARNING("    Trying to add a differential temperature but previous temperature is invalid!");
+        p_ctx->corrupted = 1;
     } else {
-        c9_handler_add_value(p_samples, lastValidTempe+parameter);
+        c9_handler_add_value(p_ctx, p_ctx->p_state->lastValidTempe+parameter);
     }
     return CT_START_DEC_1;
 }
 
 //****************************************************************************
-static uint8_t c9_handler_direct(samples_t *p_samples, uint32_t parameter)
+static uint8_t c9_handler_direct(def_uncompress_ctx_t *p_ctx, uint32_t parameter)
 {
     NRF_LOG_DEBUG("  c9_handler_direct %u", parameter);
     // we need the next 13 bits to add the raw temperature
-        c9_handler_add_value(p_samples, parameter);
+        c9_handler_add_value(p_ctx, parameter);
     return CT_START_DEC_1;
 }
 
+//****************************************************************************
+void lib_uncompress_get_state(uncompress_state_t *p_state)
+{
+    ASSERT(p_state);
+    *p_state = state;
+}
+
+//****************************************************************************
+void lib_uncompress_set_state(const uncompress_state_t *p_state)
+{
+    ASSERT(p_state);
+    state = *p_state;
+}
+
+//****************************************************************************
+void lib_uncompress_state_init(uncompress_state_t *p_state)
+{
+    ASSERT(p_state);
+    memset(p_state, 0, sizeof(uncompress_state_t));
+    p_state->lastValidTime = UINT32_MAX;
+    p_state->currentPeriod = UINT16_MAX;
+    p_state->nbPeriodToAdd = 0;
+    p_state->lastValidTempe = INVALID_TEMPERATURE;
+}
+
+//****************************************************************************
+void lib_uncompress_state_new_frame(uncompress_state_t *p_state)
+{
+    ASSERT(p_state);
+    // the temperature reference is kept from the previous frame
+    p_state->lastValidTime = UINT32_MAX;
+    p_state->currentPeriod = UINT16_MAX;
+    p_state->nbPeriodToAdd = 0;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_state_save(const uncompress_state_t *p_state, uint8_t *blob, uint8_t size)
+{
+    uint8_t checksum = 0;
+
+    if (!p_state || !blob || (size < UNCOMPRESS_STATE_BLOB_SIZE)) {
+        return 0;
+    }
+    // little endian, whatever the platform
+    blob[0] = UNCOMPRESS_STATE_BLOB_MAGIC;
+    blob[1] = UNCOMPRESS_STATE_BLOB_VERSION;
+    blob[2] = (uint8_t)(p_state->lastValidTime);
+    blob[3] = (uint8_t)(p_state->lastValidTime >> 8);
+    blob[4] = (uint8_t)(p_state->lastValidTime >> 16);
+    blob[5] = (uint8_t)(p_state->lastValidTime >> 24);
+    blob[6] = (uint8_t)(p_state->currentPeriod);
+    blob[7] = (uint8_t)(p_state->currentPeriod >> 8);
+    blob[8] = (uint8_t)(p_state->nbPeriodToAdd);
+    blob[9] = (uint8_t)(p_state->nbPeriodToAdd >> 8);
+    blob[10] = (uint8_t)((uint16_t)p_state->lastValidTempe);
+    blob[11] = (uint8_t)((uint16_t)p_state->lastValidTempe >> 8);
+    for (uint8_t i = 0; i < UNCOMPRESS_STATE_BLOB_SIZE - 1; i++) {
+        checksum ^= blob[i];
+    }
+    blob[UNCOMPRESS_STATE_BLOB_SIZE - 1] = checksum;
+    return UNCOMPRESS_STATE_BLOB_SIZE;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_state_restore(uncompress_state_t *p_state, const uint8_t *blob, uint8_t len)
+{
+    uint8_t checksum = 0;
+
+    if (!p_state || !blob || (len < UNCOMPRESS_STATE_BLOB_SIZE)) {
+        return 0;
+    }
+    if ((blob[0] != UNCOMPRESS_STATE_BLOB_MAGIC) || (blob[1] != UNCOMPRESS_STATE_BLOB_VERSION)) {
+        NRF_LOG_WARNING("Unknown state blob %02x version %u", blob[0], blob[1]);
+        return 0;
+    }
+    for (uint8_t i = 0; i < UNCOMPRESS_STATE_BLOB_SIZE; i++) {
+        checksum ^= blob[i];
+    }
+    if (checksum) {
+        NRF_LOG_WARNING("Corrupted state blob");
+        return 0;
+    }
+    lib_uncompress_state_init(p_state);
+    p_state->lastValidTime = (uint32_t)blob[2] | ((uint32_t)blob[3] << 8) | ((uint32_t)blob[4] << 16) | ((uint32_t)blob[5] << 24);
+    p_state->currentPeriod = (uint16_t)(blob[6] | (blob[7] << 8));
+    p_state->nbPeriodToAdd = (uint16_t)(blob[8] | (blob[9] << 8));
+    p_state->lastValidTempe = (int16_t)(uint16_t)(blob[10] | (blob[11] << 8));
+    return 1;
+}
+
 uint16_t uncompress_data(uint8_t *buffer,uint16_t size,record_t *records){
 
     samples_t data;
@@ -324,22 +487,55 @@ uint16_t uncompress_data(uint8_t *buffer,uint16_t size,record_t *records){
 * XXX data are currently uncompressed in a local buffer; we may want to use a callback because we do not know how many samples we will have.
 */
 uint8_t lib_uncompress_data(uint8_t *buffer, uint8_t len, samples_t *p_samples)
+{
+    // reset some internal data
+    lib_uncompress_state_new_frame(&state);
+    return lib_uncompress_data_with_state(buffer, len, p_samples, &state);
+}
+
+//****************************************************************************
+/**
+ * Main decoding loop. If p_config is set, each sample is checked and the decoding restarts from the next
+ * direct timestamp when it is corrupted (see lib_uncompress_data_resync). This anchor is on probation until
+ * a sample with a valid time follows it: a corruption before drops it with the samples decoded from it, and
+ * the next anchor is searched from the bit after it.
+ * If p_writer is set, samples are written there as they are decoded and p_samples is not used; a sample
+ * cannot be removed then, so p_config must be NULL.
+ */
+static uint8_t uncompress_run(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state,
+                              const uncompress_resync_config_t *p_config, uncompress_resync_report_t *p_report,
+                              uncompress_writer_t *p_writer)
 {
     ASSERT(buffer);
-    ASSERT(p_samples);
+    ASSERT(p_samples || p_writer);
+    ASSERT(!p_writer || !p_config);
+    ASSERT(p_state);
+    def_uncompress_ctx_t ctx = { p_samples, p_state, 0, p_writer, { 0 }, 0 };
     uint32_t val;         // current bits value, read from the frame
     uint32_t param;
     uint8_t dec_index;   // the number of the decoder to use in C9_dec array
+    uint8_t handled_index; // the decoder whose handler was called in this loop turn, C_NB_DEC if none
     uint8_t more_data = 1; // when not set in the while loop, the while will stop
     uint8_t ret = 0;  // by default error
 
+    // Checkpoint at the beginning of the current sample, used to drop it when it is corrupted
+    uint16_t unitBit = 0;
+    uint32_t unitNbSamples = 0;
+    uint16_t unitNbPeriods = 1;
+    uncompress_period_t unitLastPeriod = { 0, p_state->currentPeriod };
+    uncompress_state_t unitState = *p_state;
+    // Checkpoint at the first corrupted sample, kept while the anchor found after it is on probation
+    uint16_t skipBit = 0;
+    uint16_t anchorBit = 0;
+    uint8_t onProbation = 0;
+    uint32_t skipNbSamples = 0;
+    uint16_t skipNbPeriods = 1;
+    uncompress_period_t skipLastPeriod = unitLastPeriod;
+    uncompress_state_t skipState = unitState;
+
     def_bitStream_t bs;
     lib_bitStream_define(&bs, buffer, len);
 
-    // reset some internal data
-    lastValidTime = UINT32_MAX;
-    currentPeriod = UINT16_MAX;
-    nbPeriodToAdd = 0;
     ALOG("This message comes from uncompress at line %d.", __LINE__);
 
     // First step is to know where the start bit is
@@ -354,13 +550,26 @@ uint8_t lib_uncompress_data(uint8_t *buffer, uint8_t len, samples_t *p_samples)
    4.  return to 1, while more bits to handle ion bit stream
  */
     ALOG("This message comes from memset at line %d.", p_samples);
-    p_samples->nbSamples = 0 ;
+    if (p_samples) {
+        p_samples->nbSamples = 0 ;
+        p_samples->nbPeriods = 1;
+        p_samples->periods[0] = unitLastPeriod;
+    }
     //memset(p_samples, 0, sizeof(samples_t));
     dec_index = CT_START_DEC_1;
     ALOG("This message comes from memset at line %d.", __LINE__);
     while((more_data)) {
         ALOG("  * dec_index = %u", dec_index);
         ASSERT(dec_index < C_NB_DEC);
+        if (p_config && (dec_index == CT_START_DEC_1)) {
+            // a new sample begins here
+            unitBit = bs.currentIdx;
+            unitNbSamples = p_samples->nbSamples;
+            unitNbPeriods = p_samples->nbPeriods;
+            unitLastPeriod = p_samples->periods[unitNbPeriods - 1];
+            unitState = *p_state;
+        }
+        handled_index = C_NB_DEC;
         // Within this loop we parse a group of bits
         // step 1.
         more_data = lib_bitStream_get_bits(&bs, C_dec[dec_index].nbBits, &val);
@@ -377,7 +586,8 @@ uint8_t lib_uncompress_data(uint8_t *buffer, uint8_t len, samples_t *p_samples)
                     } else {
                         param = val;
                     }
-                    dec_index = (*C_dec[dec_index].handler)(p_samples, param);   // call handler with supposed diff value as parameter
+                    handled_index = dec_index;
+                    dec_index = (*C_dec[dec_index].handler)(&ctx, param);   // call handler with supposed diff value as parameter
                 } else {
                     // Step 3c.
                     if (C_dec[dec_index].handlers[val].handler) {
@@ -389,20 +599,203 @@ uint8_t lib_uncompress_data(uint8_t *buffer, uint8_t len, samples_t *p_samples)
                             more_data = lib_bitStream_get_bits(&bs, C_dec[dec_index].handlers[val].nbBitsParam, &param);
                         }
                         if (more_data) {
-                            dec_index = (*C_dec[dec_index].handlers[val].handler)(p_samples, param);
+                            handled_index = dec_index;
+                            dec_index = (*C_dec[dec_index].handlers[val].handler)(&ctx, param);
                         }
                     } else {
                         // Step 3d. ignore entry but move to next entry
+                        ctx.corrupted = 1;
                         dec_index = CT_START_DEC_1;
                         ALOG("Ignored value %u, dec_index=%u", val ,dec_index);
                     }
                 }
             }
         }
+        if (p_config && (more_data || onProbation)) {
+            // Check the sample being decoded
+            if (more_data && !ctx.corrupted && (handled_index < C9_START_DEC_3) && (p_state->lastValidTime != unitState.lastValidTime)) {
+                ctx.corrupted = !uncompress_time_is_plausible(p_config, p_state->lastValidTime, unitState.lastValidTime);
+            }
+            if (more_data && !ctx.corrupted && (handled_index >= C9_START_DEC_3) && (handled_index < C_NB_DEC)) {
+                int16_t tempe = p_samples->samples[p_samples->nbSamples-1].tempe;
+                if ((tempe != INVALID_TEMPERATURE) && ((tempe < p_config->minTempe) || (tempe > p_config->maxTempe))) {
+                    ctx.corrupted = 1;
+                }
+            }
+            if (!ctx.corrupted && onProbation) {
+                // samples completed from the anchor, itself included
+                uint32_t nbFromAnchor = p_samples->nbSamples - skipNbSamples;
+                if (!more_data) {
+                    // end of the frame: the anchor stands if its own sample is complete
+                    ctx.corrupted = !nbFromAnchor;
+                } else if ((handled_index >= C9_START_DEC_3) && (handled_index < C_NB_DEC) && (nbFromAnchor == 1)) {
+                    ctx.corrupted = (p_samples->samples[skipNbSamples].tempe == INVALID_TEMPERATURE);
+                } else if ((handled_index >= C9_START_DEC_3) && (handled_index < C_NB_DEC)
+                           && (p_samples->samples[p_samples->nbSamples-1].time != UINT32_MAX)) {
+                    // a complete sample with a plausible time follows
+                    onProbation = 0;
+                } else if (nbFromAnchor > RESYNC_MAX_UNCONFIRMED + 1) {
+                    ctx.corrupted = 1;
+                }
+                if (!ctx.corrupted && (!more_data || !onProbation)) {
+                    onProbation = 0;
+                    uncompress_report_skip(p_report, skipBit, anchorBit - skipBit);
+                }
+            }
+            if (ctx.corrupted) {
+                uint16_t fromBit;
+                ctx.corrupted = 0;
+                if (onProbation) {
+                    // false anchor, search again after it
+                    NRF_LOG_WARNING("False resync anchor at bit %u", anchorBit);
+                    fromBit = anchorBit + 1;
+                } else {
+                    NRF_LOG_WARNING("Corrupted sample at bit %u, resync", unitBit);
+                    if (p_report) {
+                        p_report->nbResyncs++;
+                    }
+                    skipBit = unitBit;
+                    skipNbSamples = unitNbSamples;
+                    skipNbPeriods = unitNbPeriods;
+                    skipLastPeriod = unitLastPeriod;
+                    skipState = unitState;
+                    fromBit = unitBit + 1;
+                }
+                if (p_report) {
+                    p_report->nbDroppedSamples += p_samples->nbSamples - skipNbSamples;
+                }
+                p_samples->nbSamples = unitNbSamples = skipNbSamples;
+                p_samples->nbPeriods = unitNbPeriods = skipNbPeriods;
+                p_samples->periods[skipNbPeriods - 1] = unitLastPeriod = skipLastPeriod;
+                *p_state = unitState = skipState;
+                anchorBit = uncompress_find_anchor(buffer, len, fromBit, p_config, skipState.lastValidTime, &val);
+                if (anchorBit >= BYTES2BITS((uint16_t)len)) {
+                    onProbation = 0;
+                    uncompress_report_skip(p_report, skipBit, anchorBit - skipBit);
+                    more_data = 0;
+                } else {
+                    // restart with the direct timestamp found, as a new sample
+                    onProbation = 1;
+                    bs.currentIdx = anchorBit + CT_DIRECT_PREFIX_NB_BITS + CT_DIRECT_NB_BITS;
+                    unitBit = anchorBit;
+                    dec_index = ct_handler_direct(&ctx, val);
+                    more_data = 1;
+                }
+            }
+        }
     }   // main while
-    if (p_samples->nbSamples) {
+    if (p_writer) {
+        ret = ctx.nbWritten && !p_writer->error;
+    } else if (p_samples->nbSamples) {
         ret = 1;
     }
 
     return (ret);
 }
+
+//****************************************************************************
+uint8_t lib_uncompress_data_with_state(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state)
+{
+    return uncompress_run(buffer, len, p_samples, p_state, NULL, NULL, NULL);
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_data_to_writer(uint8_t *buffer, uint8_t len, uncompress_state_t *p_state, uncompress_writer_t *p_writer)
+{
+    ASSERT(p_writer);
+    return uncompress_run(buffer, len, NULL, p_state, NULL, NULL, p_writer);
+}
+
+//****************************************************************************
+void lib_uncompress_resync_config_default(uncompress_resync_config_t *p_config)
+{
+    ASSERT(p_config);
+    p_config->minTime = UNCOMPRESS_RESYNC_DEFAULT_MIN_TIME;
+    p_config->maxTime = UINT32_MAX - 1;
+    p_config->maxTimeJump = UNCOMPRESS_RESYNC_DEFAULT_MAX_JUMP;
+    p_config->minTempe = UNCOMPRESS_RESYNC_DEFAULT_MIN_TEMPE;
+    p_config->maxTempe = UNCOMPRESS_RESYNC_DEFAULT_MAX_TEMPE;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_data_resync(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state,
+                                   const uncompress_resync_config_t *p_config, uncompress_resync_report_t *p_report)
+{
+    uncompress_resync_config_t config;
+
+    if (!p_config) {
+        lib_uncompress_resync_config_default(&config);
+        p_config = &config;
+    }
+    if (p_report) {
+        memset(p_report, 0, sizeof(uncompress_resync_report_t));
+    }
+    return uncompress_run(buffer, len, p_samples, p_state, p_config, p_report, NULL);
+}
+
+//****************************************************************************
+static uint8_t uncompress_time_is_plausible(const uncompress_resync_config_t *p_config, uint32_t time, uint32_t refTime)
+{
+    if ((time < p_config->minTime) || (time > p_config->maxTime)) {
+        return 0;
+    }
+    if (refTime != UINT32_MAX) {
+        uint32_t jump = (time > refTime) ? time - refTime : refTime - time;
+        if (jump > p_config->maxTimeJump) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//****************************************************************************
+/**
+ * Look for the next CT_DIRECT prefix followed by a plausible timestamp, starting at fromBit.
+ * The frame is read 64 bits at a time; the prefixes starting in the first byte of the word are found
+ * with a mask, then their timestamp (the 32 following bits are in the same word) is checked.
+ * Returns the bit offset of the prefix, the frame size in bits if there is none.
+ */
+static uint16_t uncompress_find_anchor(const uint8_t *buffer, uint8_t len, uint16_t fromBit,
+                                       const uncompress_resync_config_t *p_config, uint32_t refTime, uint32_t *p_time)
+{
+    const uint16_t nbBits = BYTES2BITS((uint16_t)len);
+    const uint8_t anchorBits = CT_DIRECT_PREFIX_NB_BITS + CT_DIRECT_NB_BITS;
+
+    for (uint16_t byteIdx = fromBit >> 3; BYTES2BITS(byteIdx) + anchorBits <= nbBits; byteIdx++) {
+        uint64_t word = 0;
+        uint64_t prefixes;
+        for (uint8_t i = 0; i < 8; i++) {
+            word = (word << 8) | ((byteIdx + i < len) ? buffer[byteIdx + i] : 0);
+        }
+        // bit n of prefixes is set when bits n to n-3 of word are 1010
+        prefixes = (word & ~(word << 1) & (word << 2) & ~(word << 3)) >> 56;
+        for (uint8_t k = 0; prefixes && (k < 8); k++) {
+            uint16_t bit = BYTES2BITS(byteIdx) + k;
+            if (!(prefixes & (0x80 >> k)) || (bit < fromBit)) {
+                continue;
+            }
+            if (bit + anchorBits > nbBits) {
+                break;
+            }
+            *p_time = (uint32_t)(word >> (64 - anchorBits - k));
+            if (uncompress_time_is_plausible(p_config, *p_time, refTime)) {
+                return bit;
+            }
+        }
+    }
+    return nbBits;
+}
+
+//****************************************************************************
+static void uncompress_report_skip(uncompress_resync_report_t *p_report, uint16_t firstBit, uint16_t nbBits)
+{
+    if (!p_report) {
+        return;
+    }
+    p_report->nbSkippedBits += nbBits;
+    if (p_report->nbRanges < UNCOMPRESS_RESYNC_MAX_RANGES) {
+        p_report->ranges[p_report->nbRanges].firstBit = firstBit;
+        p_report->ranges[p_report->nbRanges].nbBits = nbBits;
+        p_report->nbRanges++;
+    }
+}
@@ -16,20 +16,74 @@
 // Project include files
 //****************************************************************************
 #include "lib_compress_defines.h"
+#include "lib_uncompress_writer.h"
 
 //****************************************************************************
 // extern Defines and enum typedef
 //****************************************************************************
 #define SRV_UNCOMPRESS_NB_MAX_SAMPLES   50000
+// The period before the frame, then at most one change per CT_NEW_PERIOD code of a frame
+#define UNCOMPRESS_NB_MAX_PERIODS       (((UINT8_MAX * 8) / (CT_NEW_PERIOD_PREFIX_NB_BITS + CT_NEW_PERIOD_NB_BITS)) + 1)
+
+// Serialized decoder state, see lib_uncompress_state_save
+#define UNCOMPRESS_STATE_BLOB_MAGIC     0xBC
+#define UNCOMPRESS_STATE_BLOB_VERSION   1
+#define UNCOMPRESS_STATE_BLOB_SIZE      13
+
+// Resilient decoding, see lib_uncompress_data_resync
+#define UNCOMPRESS_RESYNC_MAX_RANGES        16          // skipped ranges kept in the report
+#define UNCOMPRESS_RESYNC_DEFAULT_MIN_TIME  1577836800  // 2020-01-01
+#define UNCOMPRESS_RESYNC_DEFAULT_MAX_JUMP  (30UL * 24 * 3600)
+#define UNCOMPRESS_RESYNC_DEFAULT_MIN_TEMPE (-2000)     // 1/100 degree
+#define UNCOMPRESS_RESYNC_DEFAULT_MAX_TEMPE 6000
 
 //****************************************************************************
 // extern Structures typedef
 //****************************************************************************
+// Sampling period of the samples decoded from firstSample on
+typedef struct {
+    uint32_t    firstSample;        // index in samples_t of the first sample decoded with this period
+    uint16_t    period;             // sampling period in seconds, UINT16_MAX if unknown
+} uncompress_period_t;
+
 typedef struct {
     uint32_t    nbSamples;
     record_t    samples[SRV_UNCOMPRESS_NB_MAX_SAMPLES];
+    uint16_t    nbPeriods;          // at least 1 after a decoding
+    uncompress_period_t periods[UNCOMPRESS_NB_MAX_PERIODS];     // periods[0] starts at sample 0, then by increasing firstSample
 } samples_t;
 
+// State of the decoder, kept from one frame to the next one
+typedef struct {
+    uint32_t    lastValidTime;      // reference for differential timestamps, UINT32_MAX if none
+    uint16_t    currentPeriod;      // sampling period in seconds, UINT16_MAX if unknown
+    uint16_t    nbPeriodToAdd;      // number of invalid timestamps since lastValidTime
+    int16_t     lastValidTempe;     // reference for differential temperatures, INVALID_TEMPERATURE if none
+} uncompress_state_t;
+
+// Plausibility limits used by lib_uncompress_data_resync to detect a corrupted frame
+typedef struct {
+    uint32_t    minTime;            // valid timestamps before are rejected
+    uint32_t    maxTime;            // valid timestamps after are rejected
+    uint32_t    maxTimeJump;        // max gap, in seconds, between a valid timestamp and the previous one
+    int16_t     minTempe;           // temperatures outside [minTempe, maxTempe] are rejected
+    int16_t     maxTempe;
+} uncompress_resync_config_t;
+
+// Bits of a frame ignored by lib_uncompress_data_resync
+typedef struct {
+    uint16_t    firstBit;           // offset from the beginning of the frame
+    uint16_t    nbBits;
+} uncompress_skipped_range_t;
+
+typedef struct {
+    uint16_t    nbResyncs;          // number of corruptions detected
+    uint16_t    nbRanges;           // ranges stored, at most UNCOMPRESS_RESYNC_MAX_RANGES
+    uint32_t    nbSkippedBits;      // total, including the ranges not stored
+    uint32_t    nbDroppedSamples;   // samples decoded then removed, part of a corrupted sample or after a false anchor
+    uncompress_skipped_range_t ranges[UNCOMPRESS_RESYNC_MAX_RANGES];
+} uncompress_resync_report_t;
+
 //****************************************************************************
 // extern Variables
 //****************************************************************************
@@ -55,7 +109,108 @@ uint16_t uncompress_data(uint8_t *buffer,uint16_t size,record_t *records);
  * \param[out] p_samples a struct where to store uncompressed samples.
  * \retval 1 on success, 0 on error
  * Warning: unreceived samples may generate many samples in a single frame (unreceived samples are highly compressed).
+ * The sampling period of each sample is given by p_samples->periods: the period before the frame, then the
+ * changes made by the frame, with the index of the first sample they apply to.
  */
 uint8_t lib_uncompress_data(uint8_t *buffer, uint8_t len, samples_t *p_samples);
+//****************************************************************************
+/**
+ * \brief Get the current state of the decoder.
+ * \param[out] p_state filled with the state left by the last call of lib_uncompress_data.
+ * This is used to know the sampling period of the decoded data.
+ */
+void lib_uncompress_get_state(uncompress_state_t *p_state);
+//****************************************************************************
+/**
+ * \brief Set the state of the decoder.
+ * \param[in] p_state the state to restore, as given by lib_uncompress_get_state.
+ * Note that lib_uncompress_data resets the timestamp part of the state, only lastValidTempe is used by the next call.
+ */
+void lib_uncompress_set_state(const uncompress_state_t *p_state);
+//****************************************************************************
+/**
+ * \brief Initialize a decoder state, as before the first frame.
+ * \param[out] p_state the state.
+ */
+void lib_uncompress_state_init(uncompress_state_t *p_state);
+//****************************************************************************
+/**
+ * \brief Reset the timestamp part of a state, as lib_uncompress_data does before each frame.
+ * \param[in,out] p_state the state, lastValidTempe is kept.
+ */
+void lib_uncompress_state_new_frame(uncompress_state_t *p_state);
+//****************************************************************************
+/**
+ * \brief Serialize a decoder state in a small versioned blob.
+ * \param[in] p_state the state.
+ * \param[out] blob where to store the blob.
+ * \param[in] size size of blob, at least UNCOMPRESS_STATE_BLOB_SIZE.
+ * \retval the len of the blob, 0 on error.
+ * Blob: magic, version, then the fields in little endian, and a xor checksum.
+ */
+uint8_t lib_uncompress_state_save(const uncompress_state_t *p_state, uint8_t *blob, uint8_t size);
+//****************************************************************************
+/**
+ * \brief Read a decoder state from a blob written by lib_uncompress_state_save.
+ * \param[out] p_state the state.
+ * \param[in] blob the blob.
+ * \param[in] len len of the blob.
+ * \retval 1 on success, 0 if the blob is unknown or corrupted (p_state is unchanged).
+ */
+uint8_t lib_uncompress_state_restore(uncompress_state_t *p_state, const uint8_t *blob, uint8_t len);
+//****************************************************************************
+/**
+ * \brief Uncompress a frame starting from a given decoder state.
+ * \param[in] buffer the buffer contains the compressed data.
+ * \param[in] len len of data, in bytes.
+ * \param[out] p_samples a struct where to store uncompressed samples.
+ * \param[in,out] p_state the state before the frame, updated with the state after the frame.
+ * \retval 1 on success, 0 on error
+ * Unlike lib_uncompress_data, nothing is reset and the global state is not used, so the result only depends
+ * on the frame and on p_state. Call lib_uncompress_state_new_frame before to get the lib_uncompress_data behaviour.
+ * This function can be called from several threads with different states.
+ */
+uint8_t lib_uncompress_data_with_state(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state);
+
+//****************************************************************************
+/**
+ * \brief Uncompress a frame straight to a writer, without storing the samples.
+ * \param[in] buffer the buffer contains the compressed data.
+ * \param[in] len len of data, in bytes.
+ * \param[in,out] p_state the state before the frame, updated with the state after the frame.
+ * \param[in] p_writer where to format the samples, as they are decoded.
+ * \retval 1 on success, 0 on error (no sample, or write error)
+ * Same as lib_uncompress_data_with_state followed by lib_uncompress_writer_add, in a single pass.
+ */
+uint8_t lib_uncompress_data_to_writer(uint8_t *buffer, uint8_t len, uncompress_state_t *p_state, uncompress_writer_t *p_writer);
+
+//****************************************************************************
+/**
+ * \brief Fill a resync config with the default limits.
+ * \param[out] p_config the config.
+ */
+void lib_uncompress_resync_config_default(uncompress_resync_config_t *p_config);
+
+//****************************************************************************
+/**
+ * \brief Same as lib_uncompress_data_with_state, recovering from corrupted data.
+ * \param[in] buffer the buffer contains the compressed data.
+ * \param[in] len len of data, in bytes.
+ * \param[out] p_samples a struct where to store uncompressed samples.
+ * \param[in,out] p_state the state before the frame, updated with the state after the frame.
+ * \param[in] p_config plausibility limits, NULL for the defaults.
+ * \param[out] p_report the skipped bits, may be NULL.
+ * \retval 1 on success, 0 on error
+ * A sample is corrupted when it uses a reserved code, a differential temperature without reference, or when its
+ * timestamp or temperature is out of the limits. Its partial output is removed, then the frame is scanned for the
+ * next direct timestamp (CT_DIRECT prefix followed by a plausible timestamp) and decoding resumes there.
+ * Random bits often look like such an anchor, so it is only accepted when its temperature is valid and a
+ * sample with a plausible time follows (up to CT_UNRECEIVED_COUNTER_MAX samples without time may come
+ * between), or when the frame ends after its temperature. Otherwise the samples decoded from it are removed
+ * too and the scan goes on from the bit after it; the skipped range ends at the accepted anchor.
+ * On a sound frame the output is the same as lib_uncompress_data_with_state.
+ */
+uint8_t lib_uncompress_data_resync(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state,
+                                   const uncompress_resync_config_t *p_config, uncompress_resync_report_t *p_report);
 
 #endif // _LIB_UNCOMPRESS_H
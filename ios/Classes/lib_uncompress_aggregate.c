@@ -0,0 +1,303 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_aggregate.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Reduce uncompressed samples before sending them to the UI.
+  *       Fixed time buckets (min/max/mean/count) and M4 downsampling
+  *       (first/last/min/max per pixel column).
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_aggregate.h"
+#include "lib_uncompress_stats.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_aggregate
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define M4_NB_KEPT  4   // first, last, min, max
+#define M4_MIN_CAPACITY     1024
+#define IS_VALID_TEMPE(t)   (((t) != INVALID_TEMPERATURE) && ((t) != UNCOMPRESS_UNRECEIVED_TEMPERATURE))
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+struct uncompress_m4_s {
+    record_t    *records;       // valid samples added so far
+    uint32_t    nbRecords;
+    uint32_t    capacity;
+};
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static void aggregate_set_origin(uncompress_aggregate_t *p_agg, uint32_t origin);
+static uint32_t m4_flush(const record_t *records, uint32_t kept[M4_NB_KEPT], record_t *output);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+static void aggregate_set_origin(uncompress_aggregate_t *p_agg, uint32_t origin)
+{
+    p_agg->origin = origin;
+    for (uint32_t i = 0; i < p_agg->nbBuckets; i++) {
+        uint64_t start = (uint64_t)origin + (uint64_t)i * p_agg->width;
+        p_agg->buckets[i].startTime = (start < UINT32_MAX) ? (uint32_t)start : UINT32_MAX;
+    }
+}
+
+//****************************************************************************
+void lib_uncompress_aggregate_init(uncompress_aggregate_t *p_agg, uncompress_bucket_t *buckets, uint32_t nbBuckets, uint32_t origin, uint32_t width)
+{
+    ASSERT(p_agg);
+    ASSERT(buckets || !nbBuckets);
+    memset(p_agg, 0, sizeof(uncompress_aggregate_t));
+    p_agg->buckets = buckets;
+    p_agg->nbBuckets = nbBuckets;
+    p_agg->width = width ? width : 1;
+    p_agg->lastTime = UNCOMPRESS_INVALID_TIME;
+    for (uint32_t i = 0; i < nbBuckets; i++) {
+        memset(&buckets[i], 0, sizeof(uncompress_bucket_t));
+        buckets[i].minTempe = INVALID_TEMPERATURE;
+        buckets[i].maxTempe = INVALID_TEMPERATURE;
+    }
+    aggregate_set_origin(p_agg, origin);
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_aggregate_width_from_periods(uint16_t period, uint32_t nbPeriods)
+{
+    if ((period == UINT16_MAX) || (period == 0)) {
+        return 0;   // no period received yet
+    }
+    return (uint32_t)period * nbPeriods;
+}
+
+//****************************************************************************
+void lib_uncompress_aggregate_add(uncompress_aggregate_t *p_agg, const record_t *records, uint32_t nbRecords,
+                                  const uncompress_period_t *periods, uint16_t nbPeriods)
+{
+    ASSERT(p_agg);
+    ASSERT(periods || !nbPeriods);
+    uint16_t next = 0;          // next change of period
+    uint16_t period = UINT16_MAX;
+
+    for (uint32_t i = 0; i < nbRecords; i++) {
+        uint64_t time = records[i].time;
+        int16_t tempe = records[i].tempe;
+
+        while ((next < nbPeriods) && (periods[next].firstSample <= i)) {
+            period = periods[next++].period;
+        }
+        if (time != UNCOMPRESS_INVALID_TIME) {
+            p_agg->lastTime = (uint32_t)time;
+        } else {
+            // place it the same way the decoder computes the next valid timestamp
+            if ((period == UINT16_MAX) || (period == 0) || (p_agg->lastTime == UNCOMPRESS_INVALID_TIME) ||
+                ((uint64_t)p_agg->lastTime + period >= UNCOMPRESS_INVALID_TIME)) {
+                p_agg->lastTime = UNCOMPRESS_INVALID_TIME;
+                p_agg->nbDropped++;
+                continue;
+            }
+            time = (uint64_t)p_agg->lastTime + period;
+            p_agg->lastTime = (uint32_t)time;
+        }
+
+        if (p_agg->origin == UNCOMPRESS_AGGREGATE_AUTO_ORIGIN) {
+            aggregate_set_origin(p_agg, (uint32_t)(time - (time % p_agg->width)));
+        }
+        if (time < p_agg->origin) {
+            p_agg->nbDropped++;
+            continue;
+        }
+        uint64_t idx = (time - p_agg->origin) / p_agg->width;
+        if (idx >= p_agg->nbBuckets) {
+            p_agg->nbDropped++;
+            continue;
+        }
+
+        uncompress_bucket_t *p_bucket = &p_agg->buckets[idx];
+        if (IS_VALID_TEMPE(tempe)) {
+            if (!p_bucket->count || (tempe < p_bucket->minTempe)) {
+                p_bucket->minTempe = tempe;
+            }
+            if (!p_bucket->count || (tempe > p_bucket->maxTempe)) {
+                p_bucket->maxTempe = tempe;
+            }
+            p_bucket->sumTempe += tempe;
+            p_bucket->count++;
+        } else {
+            p_bucket->nbGaps++;
+        }
+    }
+}
+
+//****************************************************************************
+void lib_uncompress_aggregate_add_samples(uncompress_aggregate_t *p_agg, const samples_t *p_samples)
+{
+    ASSERT(p_samples);
+    lib_uncompress_aggregate_add(p_agg, p_samples->samples, p_samples->nbSamples, p_samples->periods, p_samples->nbPeriods);
+}
+
+//****************************************************************************
+void lib_uncompress_aggregate_finish(uncompress_aggregate_t *p_agg)
+{
+    ASSERT(p_agg);
+    for (uint32_t i = 0; i < p_agg->nbBuckets; i++) {
+        uncompress_bucket_t *p_bucket = &p_agg->buckets[i];
+        p_bucket->meanTempe = p_bucket->count ? (float)((double)p_bucket->sumTempe / p_bucket->count) : 0;
+    }
+    NRF_LOG_DEBUG("aggregate: %u buckets, %u dropped samples", p_agg->nbBuckets, p_agg->nbDropped);
+}
+
+//****************************************************************************
+static uint32_t m4_flush(const record_t *records, uint32_t kept[M4_NB_KEPT], record_t *output)
+{
+    uint32_t nb = 0;
+    // sort the (at most 4) indexes so that samples keep their original order
+    for (uint8_t i = 1; i < M4_NB_KEPT; i++) {
+        for (uint8_t j = i; (j > 0) && (kept[j-1] > kept[j]); j--) {
+            uint32_t tmp = kept[j];
+            kept[j] = kept[j-1];
+            kept[j-1] = tmp;
+        }
+    }
+    for (uint8_t i = 0; i < M4_NB_KEPT; i++) {
+        if ((i == 0) || (kept[i] != kept[i-1])) {
+            output[nb++] = records[kept[i]];
+        }
+    }
+    return nb;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_downsample_m4(const record_t *records, uint32_t nbRecords, uint32_t nbPixels, record_t *output)
+{
+    uint32_t tMin = UINT32_MAX, tMax = 0;
+    uint32_t nbOutput = 0;
+    uint64_t currentCol = UINT64_MAX;
+    uint32_t kept[M4_NB_KEPT] = { 0 };   // first, last, min, max
+
+    if (!records || !output || !nbPixels) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < nbRecords; i++) {
+        if ((records[i].time != UNCOMPRESS_INVALID_TIME) && IS_VALID_TEMPE(records[i].tempe)) {
+            tMin = (records[i].time < tMin) ? records[i].time : tMin;
+            tMax = (records[i].time > tMax) ? records[i].time : tMax;
+        }
+    }
+    if (tMin > tMax) {
+        return 0;   // no valid sample
+    }
+    uint64_t span = (uint64_t)tMax - tMin + 1;
+
+    for (uint32_t i = 0; i < nbRecords; i++) {
+        if ((records[i].time == UNCOMPRESS_INVALID_TIME) || !IS_VALID_TEMPE(records[i].tempe)) {
+            continue;
+        }
+        uint64_t col = ((uint64_t)(records[i].time - tMin) * nbPixels) / span;
+        if (col != currentCol) {
+            // a column is only flushed when left, samples going back in time start a new group
+            if (currentCol != UINT64_MAX) {
+                nbOutput += m4_flush(records, kept, &output[nbOutput]);
+                if (nbOutput + M4_NB_KEPT > UNCOMPRESS_M4_MAX_RECORDS(nbPixels)) {
+                    NRF_LOG_WARNING("M4: unsorted samples, output truncated");
+                    return nbOutput;
+                }
+            }
+            currentCol = col;
+            kept[0] = kept[1] = kept[2] = kept[3] = i;
+        } else {
+            kept[1] = i;
+            if (records[i].tempe < records[kept[2]].tempe) {
+                kept[2] = i;
+            }
+            if (records[i].tempe > records[kept[3]].tempe) {
+                kept[3] = i;
+            }
+        }
+    }
+    if (currentCol != UINT64_MAX) {
+        nbOutput += m4_flush(records, kept, &output[nbOutput]);
+    }
+    return nbOutput;
+}
+
+//****************************************************************************
+uncompress_m4_t *lib_uncompress_m4_create(void)
+{
+    return calloc(1, sizeof(uncompress_m4_t));
+}
+
+//****************************************************************************
+void lib_uncompress_m4_free(uncompress_m4_t *p_m4)
+{
+    if (!p_m4) {
+        return;
+    }
+    free(p_m4->records);
+    free(p_m4);
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_m4_add_samples(uncompress_m4_t *p_m4, const samples_t *p_samples)
+{
+    ASSERT(p_m4);
+    ASSERT(p_samples);
+    uint32_t nbValid = 0;
+
+    for (uint32_t i = 0; i < p_samples->nbSamples; i++) {
+        nbValid += (p_samples->samples[i].time != UNCOMPRESS_INVALID_TIME) && IS_VALID_TEMPE(p_samples->samples[i].tempe);
+    }
+    if ((uint64_t)p_m4->nbRecords + nbValid > p_m4->capacity) {
+        uint64_t capacity = ((uint64_t)p_m4->nbRecords + nbValid) * 2;
+        capacity = (capacity < M4_MIN_CAPACITY) ? M4_MIN_CAPACITY : capacity;
+        capacity = (capacity > UINT32_MAX) ? UINT32_MAX : capacity;
+        if ((uint64_t)p_m4->nbRecords + nbValid > capacity) {
+            return 0;
+        }
+        record_t *records = realloc(p_m4->records, (size_t)capacity * sizeof(record_t));
+        if (!records) {
+            return 0;
+        }
+        p_m4->records = records;
+        p_m4->capacity = (uint32_t)capacity;
+    }
+    for (uint32_t i = 0; i < p_samples->nbSamples; i++) {
+        if ((p_samples->samples[i].time != UNCOMPRESS_INVALID_TIME) && IS_VALID_TEMPE(p_samples->samples[i].tempe)) {
+            p_m4->records[p_m4->nbRecords++] = p_samples->samples[i];
+        }
+    }
+    return 1;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_m4_finish(const uncompress_m4_t *p_m4, uint32_t nbPixels, record_t *output)
+{
+    ASSERT(p_m4);
+    return lib_uncompress_downsample_m4(p_m4->records, p_m4->nbRecords, nbPixels, output);
+}
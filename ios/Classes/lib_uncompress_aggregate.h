@@ -0,0 +1,160 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_aggregate.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Time buckets and downsampling of uncompressed samples, for charts.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_AGGREGATE_H
+#define _LIB_UNCOMPRESS_AGGREGATE_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+#include "lib_uncompress.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_AGGREGATE_AUTO_ORIGIN    UINT32_MAX  // origin taken from the first placed sample
+
+// Max number of records written by lib_uncompress_downsample_m4 for nbPixels columns
+#define UNCOMPRESS_M4_MAX_RECORDS(nbPixels) (4 * (nbPixels))
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+typedef struct {
+    uint32_t    startTime;      // time of the beginning of the bucket
+    uint32_t    count;          // number of valid temperatures in the bucket
+    uint32_t    nbGaps;         // unreceived samples or invalid temperatures placed in the bucket
+    int16_t     minTempe;       // INVALID_TEMPERATURE if count is 0
+    int16_t     maxTempe;       // INVALID_TEMPERATURE if count is 0
+    int64_t     sumTempe;
+    float       meanTempe;      // set by lib_uncompress_aggregate_finish, 0 if count is 0
+} uncompress_bucket_t;
+
+typedef struct {
+    uncompress_bucket_t *buckets;   // allocated by caller
+    uint32_t    nbBuckets;
+    uint32_t    origin;             // start time of the first bucket
+    uint32_t    width;              // width of a bucket, in seconds
+    uint32_t    nbDropped;          // samples which could not be placed (no time reference, out of the buckets)
+    uint32_t    lastTime;           // time of the previous sample, decoded or expected, UNCOMPRESS_INVALID_TIME if unknown
+} uncompress_aggregate_t;
+
+typedef struct uncompress_m4_s uncompress_m4_t;  // opaque, allocated by lib_uncompress_m4_create
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Initialize an aggregation in fixed time buckets.
+ * \param[out] p_agg the aggregation to initialize.
+ * \param[in] buckets array of nbBuckets buckets, allocated by caller.
+ * \param[in] nbBuckets number of buckets.
+ * \param[in] origin start time of the first bucket, or UNCOMPRESS_AGGREGATE_AUTO_ORIGIN to use the
+ *            first placed sample (aligned on width).
+ * \param[in] width width of a bucket in seconds, see lib_uncompress_aggregate_width_from_periods.
+ */
+void lib_uncompress_aggregate_init(uncompress_aggregate_t *p_agg, uncompress_bucket_t *buckets, uint32_t nbBuckets, uint32_t origin, uint32_t width);
+
+//****************************************************************************
+/**
+ * \brief Width of a bucket holding nbPeriods sampling periods.
+ * \param[in] period the sampling period (currentPeriod of the decoder state).
+ * \param[in] nbPeriods number of periods per bucket.
+ * \retval the width in seconds, 0 if the period is unknown.
+ */
+uint32_t lib_uncompress_aggregate_width_from_periods(uint16_t period, uint32_t nbPeriods);
+
+//****************************************************************************
+/**
+ * \brief Add uncompressed samples to the buckets.
+ * \param[in] p_agg the aggregation.
+ * \param[in] records the samples, as filled by lib_uncompress_data. Frames must be added in order.
+ * \param[in] nbRecords number of samples.
+ * \param[in] periods the sampling periods of these samples, as given in samples_t (periods[0].firstSample is 0).
+ * \param[in] nbPeriods number of periods, at least 1.
+ * A sample with an invalid time is placed one period after the previous sample, using the period it was
+ * decoded with: the k-th sample of a gap is at lastValidTime + k * period when the period does not change,
+ * as the decoder computes the next valid timestamp. Samples are dropped while the period or the time
+ * reference are unknown.
+ */
+void lib_uncompress_aggregate_add(uncompress_aggregate_t *p_agg, const record_t *records, uint32_t nbRecords,
+                                  const uncompress_period_t *periods, uint16_t nbPeriods);
+
+//****************************************************************************
+/**
+ * \brief Add the samples of a frame to the buckets, see lib_uncompress_aggregate_add.
+ * \param[in] p_agg the aggregation.
+ * \param[in] p_samples the samples, as filled by lib_uncompress_data.
+ */
+void lib_uncompress_aggregate_add_samples(uncompress_aggregate_t *p_agg, const samples_t *p_samples);
+
+//****************************************************************************
+/**
+ * \brief Compute the mean of each bucket, once all the samples were added.
+ * \param[in] p_agg the aggregation.
+ */
+void lib_uncompress_aggregate_finish(uncompress_aggregate_t *p_agg);
+
+//****************************************************************************
+/**
+ * \brief Downsample samples to a number of pixel columns, keeping min and max (M4 algorithm).
+ * \param[in] records the samples, sorted by time.
+ * \param[in] nbRecords number of samples.
+ * \param[in] nbPixels number of columns of the chart.
+ * \param[out] output at least UNCOMPRESS_M4_MAX_RECORDS(nbPixels) records, allocated by caller.
+ * \retval the number of records written in output.
+ * For each column, the first, last, min and max samples are kept, in their original order.
+ * Samples without a valid time or temperature are ignored.
+ */
+uint32_t lib_uncompress_downsample_m4(const record_t *records, uint32_t nbRecords, uint32_t nbPixels, record_t *output);
+
+//****************************************************************************
+/**
+ * \brief Create an empty M4 downsampling, the frames are added one by one.
+ * \retval the downsampling, NULL on error.
+ */
+uncompress_m4_t *lib_uncompress_m4_create(void);
+
+//****************************************************************************
+/**
+ * \brief Free a downsampling created by lib_uncompress_m4_create.
+ * \param[in] p_m4 the downsampling, may be NULL.
+ */
+void lib_uncompress_m4_free(uncompress_m4_t *p_m4);
+
+//****************************************************************************
+/**
+ * \brief Add the samples of a frame, in order. Only the samples with a valid time and temperature are kept.
+ * \param[in] p_m4 the downsampling.
+ * \param[in] p_samples the samples, as filled by lib_uncompress_data.
+ * \retval 1 on success, 0 if out of memory (the samples are not added).
+ */
+uint8_t lib_uncompress_m4_add_samples(uncompress_m4_t *p_m4, const samples_t *p_samples);
+
+//****************************************************************************
+/**
+ * \brief Downsample the samples added so far, see lib_uncompress_downsample_m4.
+ * \param[in] p_m4 the downsampling.
+ * \param[in] nbPixels number of columns of the chart.
+ * \param[out] output at least UNCOMPRESS_M4_MAX_RECORDS(nbPixels) records, allocated by caller.
+ * \retval the number of records written in output.
+ */
+uint32_t lib_uncompress_m4_finish(const uncompress_m4_t *p_m4, uint32_t nbPixels, record_t *output);
+
+#endif // _LIB_UNCOMPRESS_AGGREGATE_H
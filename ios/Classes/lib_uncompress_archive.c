@@ -0,0 +1,789 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_archive.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Archive codec for uncompressed samples. The pill codes (1/4/12 bits
+  *       time differences, 3/4/13 bits temperature differences) are made for
+  *       the firmware; on the archive the period is stable for hours and the
+  *       temperature drifts slowly.
+  *       Times are predicted from the previous period, invalid times taking
+  *       their place in the period as for the decoder. Temperatures are
+  *       predicted from the previous value or from the trend, whichever was
+  *       the best on the last samples.
+  *       Records are cut in blocks coded independently. Each block holds a
+  *       time column and a temperature column, each one a bit stream (LSB
+  *       first) which is decoded alone, with runs filled by simple loops.
+  *       A hash of the columns and of the number of records of the block is
+  *       checked before decoding it, so that a damaged archive is rejected.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <string.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_archive.h"
+#include "lib_uncompress_stats.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_archive
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define ARCHIVE_BLOCK_HEADER_SIZE   12      // len of the time column, len of the temperature column, hash
+#define ARCHIVE_HASH_BASIS          2166136261U     // FNV-1a, any change of a single byte changes the hash
+#define ARCHIVE_HASH_PRIME          16777619U
+
+// Time column codes, first bit in bit 0
+#define TIME_REGULAR_RUN            0b0     // + exp-Golomb(n-1): n times, each one previous time + previous delta
+#define TIME_REGULAR_RUN_NB_BITS    1
+#define TIME_NEW_DELTA              0b01    // + exp-Golomb(zigzag(delta of delta)-1): one time
+#define TIME_NEW_DELTA_NB_BITS      2
+#define TIME_INVALID_RUN            0b11    // + exp-Golomb(n-1): n UNCOMPRESS_INVALID_TIME
+#define TIME_INVALID_RUN_NB_BITS    2
+#define TIME_MAX_BITS               65      // worst case for one record: TIME_NEW_DELTA of a 32 bits value
+
+// Temperature column: Rice code of zigzag(prediction error)+1, 0 is followed by a run
+#define TEMPE_RUN_SYMBOL            0
+#define TEMPE_RUN_NB_BITS           2       // + exp-Golomb(n-1)
+#define TEMPE_RUN_INVALID           0       // n INVALID_TEMPERATURE
+#define TEMPE_RUN_UNRECEIVED        1       // n UNCOMPRESS_UNRECEIVED_TEMPERATURE
+#define TEMPE_RUN_UNCHANGED         2       // n times the previous temperature
+#define TEMPE_MIN_UNCHANGED_RUN     3       // shorter runs are coded as differences
+#define TEMPE_MAX_SYMBOL            (UINT16_MAX + 1)
+
+#define RICE_MAX_K                  16
+#define RICE_MAX_Q                  24      // longer quotients are replaced by the symbol on RICE_ESCAPE_NB_BITS
+#define RICE_ESCAPE_NB_BITS         17
+#define RICE_INIT_SUM               8
+#define RICE_RESET_COUNT            32      // halve the statistics to follow the changes
+#define TEMPE_MAX_BITS              (RICE_MAX_Q + RICE_ESCAPE_NB_BITS)
+
+#define PREDICT_TREND_NUM           3       // trend prediction: previous + 3/4 of the last difference
+#define PREDICT_TREND_DEN           4
+#define PREDICT_ERROR_SHIFT         4       // errors are averaged on about 16 samples
+
+#define EXP_GOLOMB_MAX_PREFIX       31
+
+#define MASK32(n)                   ((uint32_t)((1ULL << (n)) - 1))
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+typedef struct {
+    uint8_t     *data;
+    uint32_t    size;           // bytes allocated in data
+    uint32_t    idx;            // bytes written
+    uint64_t    acc;            // bits not written yet
+    uint8_t     nbBits;         // number of bits in acc, less than 8 between two calls
+    uint8_t     overflow;
+} def_archive_writer_t;
+
+typedef struct {
+    const uint8_t *data;        // next byte to load
+    const uint8_t *p_end;
+    uint64_t    acc;            // loaded bits, the bits above nbBits are the next bytes or 0
+    uint8_t     nbBits;
+} def_archive_reader_t;
+
+// Adaptive Rice parameter, from the mean of the last symbols
+typedef struct {
+    uint32_t    sum;
+    uint32_t    count;
+} def_archive_rice_t;
+
+// Temperature prediction, from the valid temperatures only
+typedef struct {
+    int16_t     last;
+    int16_t     beforeLast;
+    uint32_t    errorFlat;      // recent errors of the prediction by last
+    uint32_t    errorTrend;     // recent errors of the prediction by the trend
+} def_archive_predictor_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static uint8_t archive_bit_len(uint32_t value);
+static uint8_t archive_trailing_ones(uint64_t value);
+static uint32_t archive_zigzag(uint32_t value);
+static uint32_t archive_unzigzag(uint32_t value);
+static uint32_t archive_get_u32(const uint8_t *p_data);
+static void archive_set_u32(uint8_t *p_data, uint32_t value);
+static uint32_t archive_hash(const uint8_t *data, uint32_t len, uint32_t nbRecords);
+
+static void writer_init(def_archive_writer_t *p_writer, uint8_t *data, uint32_t size);
+static void writer_put(def_archive_writer_t *p_writer, uint32_t value, uint8_t nbBits);
+static void writer_put_exp_golomb(def_archive_writer_t *p_writer, uint32_t value);
+static uint32_t writer_flush(def_archive_writer_t *p_writer);
+
+static void reader_init(def_archive_reader_t *p_reader, const uint8_t *data, uint32_t len);
+static void reader_refill(def_archive_reader_t *p_reader);
+static uint8_t reader_get(def_archive_reader_t *p_reader, uint8_t nbBits, uint32_t *p_value);
+static uint8_t reader_get_unary(def_archive_reader_t *p_reader, uint8_t max, uint8_t *p_count);
+static uint8_t reader_get_exp_golomb(def_archive_reader_t *p_reader, uint32_t *p_value);
+
+static void rice_init(def_archive_rice_t *p_rice);
+static uint8_t rice_get_k(const def_archive_rice_t *p_rice);
+static void rice_update(def_archive_rice_t *p_rice, uint32_t symbol);
+static void rice_put(def_archive_writer_t *p_writer, def_archive_rice_t *p_rice, uint32_t symbol);
+static uint8_t rice_get(def_archive_reader_t *p_reader, def_archive_rice_t *p_rice, uint32_t *p_symbol);
+
+static void predictor_init(def_archive_predictor_t *p_predictor);
+static int32_t predictor_trend(const def_archive_predictor_t *p_predictor);
+static int16_t predictor_get(const def_archive_predictor_t *p_predictor);
+static void predictor_update(def_archive_predictor_t *p_predictor, int16_t tempe);
+static void predictor_repeat(def_archive_predictor_t *p_predictor);
+
+static void archive_encode_time(def_archive_writer_t *p_writer, const record_t *records, uint32_t nbRecords);
+static void archive_put_tempe(def_archive_writer_t *p_writer, def_archive_rice_t *p_rice, def_archive_predictor_t *p_predictor, int16_t tempe);
+static void archive_encode_tempe(def_archive_writer_t *p_writer, const record_t *records, uint32_t nbRecords);
+static uint8_t archive_decode_time(def_archive_reader_t *p_reader, record_t *records, uint32_t nbRecords);
+static uint8_t archive_decode_tempe(def_archive_reader_t *p_reader, record_t *records, uint32_t nbRecords);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+// Number of significant bits, value > 0
+static uint8_t archive_bit_len(uint32_t value)
+{
+#if defined(__GNUC__)
+    return (uint8_t)(32 - __builtin_clz(value));
+#else
+    uint8_t len = 0;
+    while (value) {
+        len++;
+        value >>= 1;
+    }
+    return len;
+#endif
+}
+
+//****************************************************************************
+static uint8_t archive_trailing_ones(uint64_t value)
+{
+    if (value == UINT64_MAX) {
+        return 64;
+    }
+#if defined(__GNUC__)
+    return (uint8_t)__builtin_ctzll(~value);
+#else
+    uint8_t count = 0;
+    while (value & 1) {
+        count++;
+        value >>= 1;
+    }
+    return count;
+#endif
+}
+
+//****************************************************************************
+// 0, -1, 1, -2... -> 0, 1, 2, 3...
+static uint32_t archive_zigzag(uint32_t value)
+{
+    return (value << 1) ^ (0U - (value >> 31));
+}
+
+//****************************************************************************
+static uint32_t archive_unzigzag(uint32_t value)
+{
+    return (value >> 1) ^ (0U - (value & 1));
+}
+
+//****************************************************************************
+static uint32_t archive_get_u32(const uint8_t *p_data)
+{
+    return (uint32_t)p_data[0] | ((uint32_t)p_data[1] << 8) | ((uint32_t)p_data[2] << 16) | ((uint32_t)p_data[3] << 24);
+}
+
+//****************************************************************************
+static void archive_set_u32(uint8_t *p_data, uint32_t value)
+{
+    p_data[0] = (uint8_t)value;
+    p_data[1] = (uint8_t)(value >> 8);
+    p_data[2] = (uint8_t)(value >> 16);
+    p_data[3] = (uint8_t)(value >> 24);
+}
+
+//****************************************************************************
+// Hash of the columns of a block, seeded with its number of records
+static uint32_t archive_hash(const uint8_t *data, uint32_t len, uint32_t nbRecords)
+{
+    uint32_t hash = ARCHIVE_HASH_BASIS ^ nbRecords;
+
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * ARCHIVE_HASH_PRIME;
+    }
+    return hash;
+}
+
+//****************************************************************************
+static void writer_init(def_archive_writer_t *p_writer, uint8_t *data, uint32_t size)
+{
+    memset(p_writer, 0, sizeof(def_archive_writer_t));
+    p_writer->data = data;
+    p_writer->size = size;
+}
+
+//****************************************************************************
+// value must not have bits set above nbBits, nbBits <= 32
+static void writer_put(def_archive_writer_t *p_writer, uint32_t value, uint8_t nbBits)
+{
+    p_writer->acc |= (uint64_t)value << p_writer->nbBits;
+    p_writer->nbBits += nbBits;
+    while (p_writer->nbBits >= 8) {
+        if (p_writer->idx < p_writer->size) {
+            p_writer->data[p_writer->idx++] = (uint8_t)p_writer->acc;
+        } else {
+            p_writer->overflow = 1;
+        }
+        p_writer->acc >>= 8;
+        p_writer->nbBits -= 8;
+    }
+}
+
+//****************************************************************************
+// n ones, a zero, then the n low bits of value+1 (2^n <= value+1 < 2^(n+1)), value < UINT32_MAX
+static void writer_put_exp_golomb(def_archive_writer_t *p_writer, uint32_t value)
+{
+    uint32_t code = value + 1;
+    uint8_t n = archive_bit_len(code) - 1;
+
+    writer_put(p_writer, MASK32(n), n);
+    writer_put(p_writer, 0, 1);
+    writer_put(p_writer, code & MASK32(n), n);
+}
+
+//****************************************************************************
+// Write the last byte, completed with 0, and return the number of bytes written (0 on overflow)
+static uint32_t writer_flush(def_archive_writer_t *p_writer)
+{
+    if (p_writer->nbBits) {
+        writer_put(p_writer, 0, 8 - p_writer->nbBits);
+    }
+    return p_writer->overflow ? 0 : p_writer->idx;
+}
+
+//****************************************************************************
+static void reader_init(def_archive_reader_t *p_reader, const uint8_t *data, uint32_t len)
+{
+    p_reader->data = data;
+    p_reader->p_end = data + len;
+    p_reader->acc = 0;
+    p_reader->nbBits = 0;
+    reader_refill(p_reader);
+}
+
+//****************************************************************************
+// Load at least 57 bits, unless the end of the data is reached
+static void reader_refill(def_archive_reader_t *p_reader)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    if (p_reader->p_end - p_reader->data >= 8) {
+        // load 8 bytes and keep the whole ones; the bytes loaded partially are loaded again
+        // at the same place next time, so the bits above nbBits stay consistent
+        uint64_t word;
+        memcpy(&word, p_reader->data, sizeof(word));
+        p_reader->acc |= word << p_reader->nbBits;
+        p_reader->data += (63 - p_reader->nbBits) >> 3;
+        p_reader->nbBits |= 56;
+        return;
+    }
+#endif
+    while ((p_reader->nbBits <= 56) && (p_reader->data < p_reader->p_end)) {
+        p_reader->acc |= (uint64_t)*p_reader->data++ << p_reader->nbBits;
+        p_reader->nbBits += 8;
+    }
+}
+
+//****************************************************************************
+static uint8_t reader_get(def_archive_reader_t *p_reader, uint8_t nbBits, uint32_t *p_value)
+{
+    if (p_reader->nbBits < nbBits) {
+        reader_refill(p_reader);
+        if (p_reader->nbBits < nbBits) {
+            return 0;
+        }
+    }
+    *p_value = (uint32_t)(p_reader->acc & ((1ULL << nbBits) - 1));
+    p_reader->acc >>= nbBits;
+    p_reader->nbBits -= nbBits;
+    return 1;
+}
+
+//****************************************************************************
+// Count the ones up to max; the terminating zero is read only if there are less than max ones
+static uint8_t reader_get_unary(def_archive_reader_t *p_reader, uint8_t max, uint8_t *p_count)
+{
+    uint8_t count;
+
+    if (p_reader->nbBits <= max) {
+        reader_refill(p_reader);
+    }
+    count = archive_trailing_ones(p_reader->acc);
+    if (count >= max) {
+        if (p_reader->nbBits < max) {
+            return 0;
+        }
+        count = max;
+        p_reader->acc >>= count;
+        p_reader->nbBits -= count;
+    } else {
+        if (count >= p_reader->nbBits) {
+            return 0;
+        }
+        p_reader->acc >>= count + 1;
+        p_reader->nbBits -= count + 1;
+    }
+    *p_count = count;
+    return 1;
+}
+
+//****************************************************************************
+static uint8_t reader_get_exp_golomb(def_archive_reader_t *p_reader, uint32_t *p_value)
+{
+    uint8_t n;
+    uint32_t low;
+
+    if (!reader_get_unary(p_reader, EXP_GOLOMB_MAX_PREFIX + 1, &n) || (n > EXP_GOLOMB_MAX_PREFIX)) {
+        return 0;
+    }
+    if (!reader_get(p_reader, n, &low)) {
+        return 0;
+    }
+    *p_value = ((1U << n) | low) - 1;
+    return 1;
+}
+
+//****************************************************************************
+static void rice_init(def_archive_rice_t *p_rice)
+{
+    p_rice->sum = RICE_INIT_SUM;
+    p_rice->count = 1;
+}
+
+//****************************************************************************
+// Smallest k such as the mean of the symbols is below 2^k
+static uint8_t rice_get_k(const def_archive_rice_t *p_rice)
+{
+    uint8_t k = 0;
+
+    while (((p_rice->count << k) < p_rice->sum) && (k < RICE_MAX_K)) {
+        k++;
+    }
+    return k;
+}
+
+//****************************************************************************
+static void rice_update(def_archive_rice_t *p_rice, uint32_t symbol)
+{
+    p_rice->sum += symbol;
+    p_rice->count++;
+    if (p_rice->count >= RICE_RESET_COUNT) {
+        p_rice->sum = (p_rice->sum + 1) >> 1;
+        p_rice->count >>= 1;
+    }
+}
+
+//****************************************************************************
+static void rice_put(def_archive_writer_t *p_writer, def_archive_rice_t *p_rice, uint32_t symbol)
+{
+    uint8_t k = rice_get_k(p_rice);
+    uint32_t q = symbol >> k;
+
+    if (q < RICE_MAX_Q) {
+        writer_put(p_writer, MASK32(q), (uint8_t)q);
+        writer_put(p_writer, 0, 1);
+        writer_put(p_writer, symbol & MASK32(k), k);
+    } else {
+        writer_put(p_writer, MASK32(RICE_MAX_Q), RICE_MAX_Q);
+        writer_put(p_writer, symbol, RICE_ESCAPE_NB_BITS);
+    }
+    rice_update(p_rice, symbol);
+}
+
+//****************************************************************************
+static uint8_t rice_get(def_archive_reader_t *p_reader, def_archive_rice_t *p_rice, uint32_t *p_symbol)
+{
+    uint8_t k = rice_get_k(p_rice);
+    uint8_t q;
+    uint32_t low;
+
+    if (!reader_get_unary(p_reader, RICE_MAX_Q, &q)) {
+        return 0;
+    }
+    if (q < RICE_MAX_Q) {
+        if (!reader_get(p_reader, k, &low)) {
+            return 0;
+        }
+        *p_symbol = ((uint32_t)q << k) | low;
+    } else if (!reader_get(p_reader, RICE_ESCAPE_NB_BITS, p_symbol)) {
+        return 0;
+    }
+    if (*p_symbol > TEMPE_MAX_SYMBOL) {
+        return 0;
+    }
+    rice_update(p_rice, *p_symbol);
+    return 1;
+}
+
+//****************************************************************************
+static void predictor_init(def_archive_predictor_t *p_predictor)
+{
+    memset(p_predictor, 0, sizeof(def_archive_predictor_t));
+}
+
+//****************************************************************************
+static int32_t predictor_trend(const def_archive_predictor_t *p_predictor)
+{
+    return p_predictor->last + ((int32_t)p_predictor->last - p_predictor->beforeLast) * PREDICT_TREND_NUM / PREDICT_TREND_DEN;
+}
+
+//****************************************************************************
+// The prediction is taken modulo 2^16, as the errors
+static int16_t predictor_get(const def_archive_predictor_t *p_predictor)
+{
+    if (p_predictor->errorTrend < p_predictor->errorFlat) {
+        return (int16_t)(uint16_t)predictor_trend(p_predictor);
+    }
+    return p_predictor->last;
+}
+
+//****************************************************************************
+static void predictor_update(def_archive_predictor_t *p_predictor, int16_t tempe)
+{
+    int32_t errorFlat = tempe - p_predictor->last;
+    int32_t errorTrend = tempe - predictor_trend(p_predictor);
+
+    p_predictor->errorFlat += (uint32_t)((errorFlat < 0) ? -errorFlat : errorFlat) - (p_predictor->errorFlat >> PREDICT_ERROR_SHIFT);
+    p_predictor->errorTrend += (uint32_t)((errorTrend < 0) ? -errorTrend : errorTrend) - (p_predictor->errorTrend >> PREDICT_ERROR_SHIFT);
+    p_predictor->beforeLast = p_predictor->last;
+    p_predictor->last = tempe;
+}
+
+//****************************************************************************
+// After a run of unchanged temperatures, there is no trend
+static void predictor_repeat(def_archive_predictor_t *p_predictor)
+{
+    p_predictor->beforeLast = p_predictor->last;
+}
+
+//****************************************************************************
+// Differences are computed modulo 2^32, so that any time is coded
+static void archive_encode_time(def_archive_writer_t *p_writer, const record_t *records, uint32_t nbRecords)
+{
+    uint32_t prevTime = 0;
+    uint32_t prevDelta = 0;
+    uint32_t i = 0;
+
+    while (i < nbRecords) {
+        uint32_t n = 1;
+        if (records[i].time == UNCOMPRESS_INVALID_TIME) {
+            while ((i + n < nbRecords) && (records[i + n].time == UNCOMPRESS_INVALID_TIME)) {
+                n++;
+            }
+            writer_put(p_writer, TIME_INVALID_RUN, TIME_INVALID_RUN_NB_BITS);
+            writer_put_exp_golomb(p_writer, n - 1);
+            prevTime += n * prevDelta;
+        } else {
+            uint32_t delta = records[i].time - prevTime;
+            if (delta == prevDelta) {
+                while ((i + n < nbRecords) && (records[i + n].time != UNCOMPRESS_INVALID_TIME)
+                       && (records[i + n].time - records[i + n - 1].time == delta)) {
+                    n++;
+                }
+                writer_put(p_writer, TIME_REGULAR_RUN, TIME_REGULAR_RUN_NB_BITS);
+                writer_put_exp_golomb(p_writer, n - 1);
+            } else {
+                writer_put(p_writer, TIME_NEW_DELTA, TIME_NEW_DELTA_NB_BITS);
+                writer_put_exp_golomb(p_writer, archive_zigzag(delta - prevDelta) - 1);
+                prevDelta = delta;
+            }
+            prevTime = records[i + n - 1].time;
+        }
+        i += n;
+    }
+}
+
+//****************************************************************************
+static void archive_put_tempe(def_archive_writer_t *p_writer, def_archive_rice_t *p_rice, def_archive_predictor_t *p_predictor, int16_t tempe)
+{
+    uint16_t error = (uint16_t)tempe - (uint16_t)predictor_get(p_predictor);
+
+    rice_put(p_writer, p_rice, archive_zigzag((uint32_t)(int32_t)(int16_t)error) + 1);
+    predictor_update(p_predictor, tempe);
+}
+
+//****************************************************************************
+static void archive_encode_tempe(def_archive_writer_t *p_writer, const record_t *records, uint32_t nbRecords)
+{
+    def_archive_rice_t rice;
+    def_archive_predictor_t predictor;
+    uint32_t i = 0;
+
+    rice_init(&rice);
+    predictor_init(&predictor);
+    while (i < nbRecords) {
+        int16_t tempe = records[i].tempe;
+        uint32_t n = 1;
+        while ((i + n < nbRecords) && (records[i + n].tempe == tempe)) {
+            n++;
+        }
+        if ((tempe == INVALID_TEMPERATURE) || (tempe == UNCOMPRESS_UNRECEIVED_TEMPERATURE)) {
+            rice_put(p_writer, &rice, TEMPE_RUN_SYMBOL);
+            writer_put(p_writer, (tempe == INVALID_TEMPERATURE) ? TEMPE_RUN_INVALID : TEMPE_RUN_UNRECEIVED, TEMPE_RUN_NB_BITS);
+            writer_put_exp_golomb(p_writer, n - 1);
+            i += n;
+            continue;
+        }
+        if (tempe != predictor.last) {
+            archive_put_tempe(p_writer, &rice, &predictor, tempe);
+            i++;
+            n--;
+        }
+        if (n >= TEMPE_MIN_UNCHANGED_RUN) {
+            rice_put(p_writer, &rice, TEMPE_RUN_SYMBOL);
+            writer_put(p_writer, TEMPE_RUN_UNCHANGED, TEMPE_RUN_NB_BITS);
+            writer_put_exp_golomb(p_writer, n - 1);
+            predictor_repeat(&predictor);
+        } else {
+            for (uint32_t j = 0; j < n; j++) {
+                archive_put_tempe(p_writer, &rice, &predictor, tempe);
+            }
+        }
+        i += n;
+    }
+}
+
+//****************************************************************************
+static uint8_t archive_decode_time(def_archive_reader_t *p_reader, record_t *records, uint32_t nbRecords)
+{
+    uint32_t prevTime = 0;
+    uint32_t prevDelta = 0;
+    uint32_t i = 0;
+    uint32_t value;
+
+    while (i < nbRecords) {
+        if (!reader_get(p_reader, TIME_REGULAR_RUN_NB_BITS, &value)) {
+            return 0;
+        }
+        if (value == TIME_REGULAR_RUN) {
+            if (!reader_get_exp_golomb(p_reader, &value) || (value >= nbRecords - i)) {
+                return 0;
+            }
+            for (uint32_t k = 0; k <= value; k++) {
+                records[i + k].time = prevTime + (k + 1) * prevDelta;
+            }
+            prevTime += (value + 1) * prevDelta;
+            i += value + 1;
+            continue;
+        }
+        // second bit of TIME_NEW_DELTA or TIME_INVALID_RUN
+        if (!reader_get(p_reader, 1, &value)) {
+            return 0;
+        }
+        if (value == (TIME_INVALID_RUN >> 1)) {
+            if (!reader_get_exp_golomb(p_reader, &value) || (value >= nbRecords - i)) {
+                return 0;
+            }
+            for (uint32_t k = 0; k <= value; k++) {
+                records[i + k].time = UNCOMPRESS_INVALID_TIME;
+            }
+            prevTime += (value + 1) * prevDelta;
+            i += value + 1;
+        } else {
+            if (!reader_get_exp_golomb(p_reader, &value)) {
+                return 0;
+            }
+            prevDelta += archive_unzigzag(value + 1);
+            prevTime += prevDelta;
+            records[i++].time = prevTime;
+        }
+    }
+    return 1;
+}
+
+//****************************************************************************
+static uint8_t archive_decode_tempe(def_archive_reader_t *p_reader, record_t *records, uint32_t nbRecords)
+{
+    def_archive_rice_t rice;
+    def_archive_predictor_t predictor;
+    uint32_t i = 0;
+    uint32_t symbol;
+    uint32_t kind;
+    uint32_t n;
+
+    rice_init(&rice);
+    predictor_init(&predictor);
+    while (i < nbRecords) {
+        if (!rice_get(p_reader, &rice, &symbol)) {
+            return 0;
+        }
+        if (symbol != TEMPE_RUN_SYMBOL) {
+            int16_t tempe = (int16_t)(uint16_t)((uint16_t)predictor_get(&predictor) + archive_unzigzag(symbol - 1));
+            predictor_update(&predictor, tempe);
+            records[i++].tempe = tempe;
+            continue;
+        }
+        if (!reader_get(p_reader, TEMPE_RUN_NB_BITS, &kind) || !reader_get_exp_golomb(p_reader, &n) || (n >= nbRecords - i)) {
+            return 0;
+        }
+        int16_t tempe;
+        switch (kind) {
+            case TEMPE_RUN_INVALID:     tempe = INVALID_TEMPERATURE;                break;
+            case TEMPE_RUN_UNRECEIVED:  tempe = UNCOMPRESS_UNRECEIVED_TEMPERATURE;  break;
+            case TEMPE_RUN_UNCHANGED:
+                tempe = predictor.last;
+                predictor_repeat(&predictor);
+                break;
+            default:
+                return 0;
+        }
+        for (uint32_t k = 0; k <= n; k++) {
+            records[i + k].tempe = tempe;
+        }
+        i += n + 1;
+    }
+    return 1;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_archive_max_size(uint32_t nbRecords)
+{
+    uint32_t nbBlocks = (nbRecords + UNCOMPRESS_ARCHIVE_BLOCK_RECORDS - 1) / UNCOMPRESS_ARCHIVE_BLOCK_RECORDS;
+
+    if (nbRecords > UNCOMPRESS_ARCHIVE_MAX_RECORDS) {
+        return 0;
+    }
+    // each column may end with an incomplete byte
+    return UNCOMPRESS_ARCHIVE_HEADER_SIZE + nbBlocks * (ARCHIVE_BLOCK_HEADER_SIZE + 2)
+           + (uint32_t)(((uint64_t)nbRecords * (TIME_MAX_BITS + TEMPE_MAX_BITS) + 7) / 8);
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_archive_encode(const record_t *records, uint32_t nbRecords, uint8_t *output, uint32_t size)
+{
+    def_archive_writer_t writer;
+    uint32_t idx = UNCOMPRESS_ARCHIVE_HEADER_SIZE;
+
+    ASSERT(records || !nbRecords);
+    ASSERT(output);
+    if ((nbRecords > UNCOMPRESS_ARCHIVE_MAX_RECORDS) || (size < UNCOMPRESS_ARCHIVE_HEADER_SIZE)) {
+        return 0;
+    }
+    output[0] = UNCOMPRESS_ARCHIVE_MAGIC;
+    output[1] = UNCOMPRESS_ARCHIVE_VERSION;
+    archive_set_u32(&output[2], nbRecords);
+
+    for (uint32_t first = 0; first < nbRecords; first += UNCOMPRESS_ARCHIVE_BLOCK_RECORDS) {
+        uint32_t nb = nbRecords - first;
+        uint32_t timeLen;
+        uint32_t tempeLen;
+        if (nb > UNCOMPRESS_ARCHIVE_BLOCK_RECORDS) {
+            nb = UNCOMPRESS_ARCHIVE_BLOCK_RECORDS;
+        }
+        if (size - idx < ARCHIVE_BLOCK_HEADER_SIZE) {
+            return 0;
+        }
+        writer_init(&writer, &output[idx + ARCHIVE_BLOCK_HEADER_SIZE], size - idx - ARCHIVE_BLOCK_HEADER_SIZE);
+        archive_encode_time(&writer, &records[first], nb);
+        timeLen = writer_flush(&writer);
+        if (!timeLen) {
+            return 0;
+        }
+        writer_init(&writer, &output[idx + ARCHIVE_BLOCK_HEADER_SIZE + timeLen], size - idx - ARCHIVE_BLOCK_HEADER_SIZE - timeLen);
+        archive_encode_tempe(&writer, &records[first], nb);
+        tempeLen = writer_flush(&writer);
+        if (!tempeLen) {
+            return 0;
+        }
+        archive_set_u32(&output[idx], timeLen);
+        archive_set_u32(&output[idx + 4], tempeLen);
+        archive_set_u32(&output[idx + 8], archive_hash(&output[idx + ARCHIVE_BLOCK_HEADER_SIZE], timeLen + tempeLen, nb));
+        idx += ARCHIVE_BLOCK_HEADER_SIZE + timeLen + tempeLen;
+    }
+    NRF_LOG_DEBUG("archive: %u records in %u bytes", nbRecords, idx);
+    return idx;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_archive_get_nb_records(const uint8_t *archive, uint32_t len, uint32_t *p_nbRecords)
+{
+    ASSERT(p_nbRecords);
+    if (!archive || (len < UNCOMPRESS_ARCHIVE_HEADER_SIZE) || (archive[0] != UNCOMPRESS_ARCHIVE_MAGIC)
+        || (archive[1] != UNCOMPRESS_ARCHIVE_VERSION)) {
+        return 0;
+    }
+    *p_nbRecords = archive_get_u32(&archive[2]);
+    return *p_nbRecords <= UNCOMPRESS_ARCHIVE_MAX_RECORDS;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_archive_decode(const uint8_t *archive, uint32_t len, record_t *records, uint32_t maxRecords)
+{
+    def_archive_reader_t reader;
+    uint32_t nbRecords;
+    uint32_t idx = UNCOMPRESS_ARCHIVE_HEADER_SIZE;
+
+    if (!lib_uncompress_archive_get_nb_records(archive, len, &nbRecords)) {
+        NRF_LOG_ERROR("archive: bad header");
+        return 0;
+    }
+    if (nbRecords > maxRecords) {
+        return 0;
+    }
+    ASSERT(records || !nbRecords);
+
+    for (uint32_t first = 0; first < nbRecords; first += UNCOMPRESS_ARCHIVE_BLOCK_RECORDS) {
+        uint32_t nb = nbRecords - first;
+        uint32_t timeLen;
+        uint32_t tempeLen;
+        uint32_t hash;
+        if (nb > UNCOMPRESS_ARCHIVE_BLOCK_RECORDS) {
+            nb = UNCOMPRESS_ARCHIVE_BLOCK_RECORDS;
+        }
+        if (len - idx < ARCHIVE_BLOCK_HEADER_SIZE) {
+            return 0;
+        }
+        timeLen = archive_get_u32(&archive[idx]);
+        tempeLen = archive_get_u32(&archive[idx + 4]);
+        hash = archive_get_u32(&archive[idx + 8]);
+        idx += ARCHIVE_BLOCK_HEADER_SIZE;
+        if ((timeLen > len - idx) || (tempeLen > len - idx - timeLen)) {
+            return 0;
+        }
+        if (archive_hash(&archive[idx], timeLen + tempeLen, nb) != hash) {
+            NRF_LOG_ERROR("archive: block %u corrupted", first / UNCOMPRESS_ARCHIVE_BLOCK_RECORDS);
+            return 0;
+        }
+        reader_init(&reader, &archive[idx], timeLen);
+        if (!archive_decode_time(&reader, &records[first], nb)) {
+            NRF_LOG_ERROR("archive: time column of block %u corrupted", first / UNCOMPRESS_ARCHIVE_BLOCK_RECORDS);
+            return 0;
+        }
+        idx += timeLen;
+        reader_init(&reader, &archive[idx], tempeLen);
+        if (!archive_decode_tempe(&reader, &records[first], nb)) {
+            NRF_LOG_ERROR("archive: temperature column of block %u corrupted", first / UNCOMPRESS_ARCHIVE_BLOCK_RECORDS);
+            return 0;
+        }
+        idx += tempeLen;
+    }
+    return idx == len;
+}
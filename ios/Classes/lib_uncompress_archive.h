@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_archive.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Compact storage of uncompressed samples, for the long term archive.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_ARCHIVE_H
+#define _LIB_UNCOMPRESS_ARCHIVE_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_ARCHIVE_MAGIC            0xBA
+#define UNCOMPRESS_ARCHIVE_VERSION          2           // 2: hash of each block
+#define UNCOMPRESS_ARCHIVE_HEADER_SIZE      6           // magic, version, number of records
+#define UNCOMPRESS_ARCHIVE_BLOCK_RECORDS    4096        // records per block, blocks are coded independently
+#define UNCOMPRESS_ARCHIVE_MAX_RECORDS      (1 << 28)   // so that lib_uncompress_archive_max_size fits 32 bits
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Size to allocate for the archive of nbRecords records, whatever their values.
+ * \param[in] nbRecords number of records, up to UNCOMPRESS_ARCHIVE_MAX_RECORDS.
+ * \retval the size in bytes, 0 if nbRecords is too large.
+ */
+uint32_t lib_uncompress_archive_max_size(uint32_t nbRecords);
+
+//****************************************************************************
+/**
+ * \brief Compress records for the archive.
+ * \param[in] records the records, as filled by lib_uncompress_data (any value is accepted).
+ * \param[in] nbRecords number of records, up to UNCOMPRESS_ARCHIVE_MAX_RECORDS.
+ * \param[out] output the archive, allocated by caller.
+ * \param[in] size size of output, lib_uncompress_archive_max_size is always enough.
+ * \retval the len of the archive in bytes, 0 if output is too small.
+ * Times are coded as runs of constant period and delta of delta, invalid times as runs.
+ * Temperatures are coded as differences with an adaptive Rice code, invalid and unreceived
+ * temperatures and unchanged values as runs. lib_uncompress_archive_decode gives back the same records.
+ */
+uint32_t lib_uncompress_archive_encode(const record_t *records, uint32_t nbRecords, uint8_t *output, uint32_t size);
+
+//****************************************************************************
+/**
+ * \brief Get the number of records stored in an archive.
+ * \param[in] archive the archive.
+ * \param[in] len len of the archive, in bytes.
+ * \param[out] p_nbRecords the number of records.
+ * \retval 1 on success, 0 if this is not an archive.
+ */
+uint8_t lib_uncompress_archive_get_nb_records(const uint8_t *archive, uint32_t len, uint32_t *p_nbRecords);
+
+//****************************************************************************
+/**
+ * \brief Decode an archive.
+ * \param[in] archive the archive, as filled by lib_uncompress_archive_encode.
+ * \param[in] len len of the archive, in bytes.
+ * \param[out] records the records, allocated by caller.
+ * \param[in] maxRecords size of records, see lib_uncompress_archive_get_nb_records.
+ * \retval 1 on success, 0 if the archive is corrupted or truncated, or records is too small.
+ * Each block is checked by a hash before being decoded: any change of a single byte of an archive is detected.
+ */
+uint8_t lib_uncompress_archive_decode(const uint8_t *archive, uint32_t len, record_t *records, uint32_t maxRecords);
+
+#endif // _LIB_UNCOMPRESS_ARCHIVE_H
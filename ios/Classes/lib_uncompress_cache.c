@@ -0,0 +1,542 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_cache.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Persistent cache of uncompressed frames, keyed by a hash of the
+  *       compressed frame and of the decoder state.
+  *       The file is append only and mapped in memory for reading. An index
+  *       (open addressing hash table) is rebuilt in memory when opening.
+  *       When the file is full, the most recently used entries are copied to
+  *       a new file (compaction), the others are evicted.
+  *       A cache must not be shared between threads.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_cache.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_cache
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define CACHE_FILE_MAGIC        0x43554342  // "BCUC"
+#define CACHE_ENTRY_MAGIC       0x59544E45  // "ENTY"
+#define CACHE_VERSION           2
+#define CACHE_INDEX_MIN_SIZE    256         // power of 2
+#define CACHE_ALIGN8(n)         (((n) + 7) & ~7UL)
+#define CACHE_COLUMNS_SIZE(n)   ((n) * (sizeof(uint32_t) + sizeof(int16_t)))
+#define CACHE_PAYLOAD_SIZE(nbSamples, nbPeriods)    CACHE_ALIGN8(CACHE_COLUMNS_SIZE(nbSamples) + CACHE_COLUMNS_SIZE(nbPeriods))
+#define CACHE_HASH_M            0xC6A4A7935BD1E995ULL
+#define CACHE_HASH_R            47
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+typedef struct {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    entryHeaderSize;
+    uint32_t    reserved[2];
+} def_cache_file_header_t;
+
+// Each entry is followed by the times column, the temperatures column, then the periods
+// (first samples column, then periods column), padded to 8 bytes
+typedef struct {
+    uint32_t    magic;
+    uint32_t    nbSamples;
+    uint64_t    key;
+    uncompress_state_t stateOut;
+    uint16_t    nbPeriods;
+    uint32_t    checksum;       // hash of the payload
+} def_cache_entry_header_t;
+
+typedef struct {
+    uint64_t    key;
+    uint32_t    offset;         // 0 for an empty slot (offset 0 is the file header)
+    uint32_t    lastUse;
+} def_cache_slot_t;
+
+struct uncompress_cache_s {
+    char        *path;
+    int         fd;
+    uint32_t    maxBytes;
+    uint32_t    fileSize;
+    uint8_t     *map;
+    uint32_t    mapSize;
+    def_cache_slot_t *index;
+    uint32_t    indexSize;      // power of 2
+    uint32_t    nbEntries;
+    uint32_t    useCounter;
+    uint8_t     *scratch;       // entry being written
+    uncompress_cache_stats_t stats;
+};
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static uint64_t cache_hash(const uint8_t *data, uint32_t len, uint64_t seed);
+static uint8_t cache_remap(uncompress_cache_t *p_cache);
+static def_cache_slot_t *cache_find_slot(uncompress_cache_t *p_cache, uint64_t key);
+static uint8_t cache_index_insert(uncompress_cache_t *p_cache, uint64_t key, uint32_t offset);
+static uint8_t cache_load(uncompress_cache_t *p_cache);
+static uint8_t cache_compact(uncompress_cache_t *p_cache, uint32_t neededBytes);
+static int cache_compare_slots(const void *a, const void *b);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+// 64 bits hash, 8 bytes at a time (MurmurHash64A)
+static uint64_t cache_hash(const uint8_t *data, uint32_t len, uint64_t seed)
+{
+    uint64_t h = seed ^ (len * CACHE_HASH_M);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        uint64_t k;
+        memcpy(&k, &data[i], sizeof(k));
+        k *= CACHE_HASH_M;
+        k ^= k >> CACHE_HASH_R;
+        k *= CACHE_HASH_M;
+        h ^= k;
+        h *= CACHE_HASH_M;
+    }
+    if (i < len) {
+        uint64_t k = 0;
+        for (uint32_t j = len; j > i; j--) {
+            k = (k << 8) | data[j-1];
+        }
+        h ^= k;
+        h *= CACHE_HASH_M;
+    }
+    h ^= h >> CACHE_HASH_R;
+    h *= CACHE_HASH_M;
+    h ^= h >> CACHE_HASH_R;
+    return h;
+}
+
+//****************************************************************************
+uint64_t lib_uncompress_cache_key(const uint8_t *buffer, uint16_t len, const uncompress_state_t *p_stateIn)
+{
+    ASSERT(p_stateIn);
+    uint8_t state[10];
+    // hash the fields only, not the padding of the struct
+    memcpy(&state[0], &p_stateIn->lastValidTime, 4);
+    memcpy(&state[4], &p_stateIn->currentPeriod, 2);
+    memcpy(&state[6], &p_stateIn->nbPeriodToAdd, 2);
+    memcpy(&state[8], &p_stateIn->lastValidTempe, 2);
+    return cache_hash(buffer, len, cache_hash(state, sizeof(state), 0));
+}
+
+//****************************************************************************
+static uint8_t cache_remap(uncompress_cache_t *p_cache)
+{
+    if (p_cache->map) {
+        munmap(p_cache->map, p_cache->mapSize);
+        p_cache->map = NULL;
+        p_cache->mapSize = 0;
+    }
+    if (!p_cache->fileSize) {
+        return 1;
+    }
+    void *map = mmap(NULL, p_cache->fileSize, PROT_READ, MAP_SHARED, p_cache->fd, 0);
+    if (map == MAP_FAILED) {
+        NRF_LOG_ERROR("cache: cannot map %s", p_cache->path);
+        return 0;
+    }
+    p_cache->map = map;
+    p_cache->mapSize = p_cache->fileSize;
+    return 1;
+}
+
+//****************************************************************************
+static def_cache_slot_t *cache_find_slot(uncompress_cache_t *p_cache, uint64_t key)
+{
+    uint32_t mask = p_cache->indexSize - 1;
+    uint32_t i = (uint32_t)key & mask;
+
+    // linear probing, the index is never full
+    while (p_cache->index[i].offset && (p_cache->index[i].key != key)) {
+        i = (i + 1) & mask;
+    }
+    return &p_cache->index[i];
+}
+
+//****************************************************************************
+static uint8_t cache_index_insert(uncompress_cache_t *p_cache, uint64_t key, uint32_t offset)
+{
+    if ((p_cache->nbEntries + 1) * 10 > p_cache->indexSize * 7) {
+        // grow the index to keep the load factor under 70%
+        def_cache_slot_t *old = p_cache->index;
+        uint32_t oldSize = p_cache->indexSize;
+        def_cache_slot_t *index = calloc(oldSize * 2, sizeof(def_cache_slot_t));
+        if (!index) {
+            return 0;
+        }
+        p_cache->index = index;
+        p_cache->indexSize = oldSize * 2;
+        for (uint32_t i = 0; i < oldSize; i++) {
+            if (old[i].offset) {
+                *cache_find_slot(p_cache, old[i].key) = old[i];
+            }
+        }
+        free(old);
+    }
+    def_cache_slot_t *p_slot = cache_find_slot(p_cache, key);
+    if (!p_slot->offset) {
+        p_cache->nbEntries++;
+    }
+    // a later entry with the same key replaces the previous one
+    p_slot->key = key;
+    p_slot->offset = offset;
+    p_slot->lastUse = ++p_cache->useCounter;
+    return 1;
+}
+
+//****************************************************************************
+// Read the file, check it, and build the index
+static uint8_t cache_load(uncompress_cache_t *p_cache)
+{
+    struct stat st;
+    def_cache_file_header_t header;
+
+    memset(p_cache->index, 0, p_cache->indexSize * sizeof(def_cache_slot_t));
+    p_cache->nbEntries = 0;
+    if (fstat(p_cache->fd, &st) != 0) {
+        return 0;
+    }
+    p_cache->fileSize = (uint32_t)st.st_size;
+    if (p_cache->fileSize < sizeof(header)) {
+        // new (or unusable) file, write the header
+        memset(&header, 0, sizeof(header));
+        header.magic = CACHE_FILE_MAGIC;
+        header.version = CACHE_VERSION;
+        header.entryHeaderSize = sizeof(def_cache_entry_header_t);
+        if ((ftruncate(p_cache->fd, 0) != 0) || (pwrite(p_cache->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))) {
+            return 0;
+        }
+        p_cache->fileSize = sizeof(header);
+        return cache_remap(p_cache);
+    }
+    if (!cache_remap(p_cache)) {
+        return 0;
+    }
+    memcpy(&header, p_cache->map, sizeof(header));
+    if ((header.magic != CACHE_FILE_MAGIC) || (header.version != CACHE_VERSION)
+        || (header.entryHeaderSize != sizeof(def_cache_entry_header_t))) {
+        NRF_LOG_WARNING("cache: %s has another format, reset", p_cache->path);
+        if (ftruncate(p_cache->fd, 0) != 0) {
+            return 0;
+        }
+        return cache_load(p_cache);
+    }
+
+    uint32_t offset = sizeof(header);
+    while (offset + sizeof(def_cache_entry_header_t) <= p_cache->fileSize) {
+        def_cache_entry_header_t entry;
+        memcpy(&entry, &p_cache->map[offset], sizeof(entry));
+        uint32_t payloadSize = CACHE_PAYLOAD_SIZE(entry.nbSamples, entry.nbPeriods);
+        if ((entry.magic != CACHE_ENTRY_MAGIC) || (entry.nbSamples > SRV_UNCOMPRESS_NB_MAX_SAMPLES)
+            || !entry.nbPeriods || (entry.nbPeriods > UNCOMPRESS_NB_MAX_PERIODS)
+            || (offset + sizeof(entry) + payloadSize > p_cache->fileSize)
+            || (entry.checksum != (uint32_t)cache_hash(&p_cache->map[offset + sizeof(entry)], payloadSize, entry.key))) {
+            break;
+        }
+        if (!cache_index_insert(p_cache, entry.key, offset)) {
+            return 0;
+        }
+        offset += sizeof(entry) + payloadSize;
+    }
+    if (offset != p_cache->fileSize) {
+        // drop a partially written entry
+        NRF_LOG_WARNING("cache: %s truncated from %u to %u bytes", p_cache->path, p_cache->fileSize, offset);
+        if (ftruncate(p_cache->fd, offset) != 0) {
+            return 0;
+        }
+        p_cache->fileSize = offset;
+        return cache_remap(p_cache);
+    }
+    return 1;
+}
+
+//****************************************************************************
+uncompress_cache_t *lib_uncompress_cache_open(const char *path, uint32_t maxBytes)
+{
+    uncompress_cache_t *p_cache;
+
+    if (!path) {
+        return NULL;
+    }
+    p_cache = calloc(1, sizeof(uncompress_cache_t));
+    if (!p_cache) {
+        return NULL;
+    }
+    p_cache->fd = -1;
+    p_cache->maxBytes = maxBytes ? maxBytes : UNCOMPRESS_CACHE_DEFAULT_MAX_BYTES;
+    p_cache->path = strdup(path);
+    p_cache->indexSize = CACHE_INDEX_MIN_SIZE;
+    p_cache->index = calloc(p_cache->indexSize, sizeof(def_cache_slot_t));
+    p_cache->scratch = malloc(sizeof(def_cache_entry_header_t) + CACHE_PAYLOAD_SIZE(SRV_UNCOMPRESS_NB_MAX_SAMPLES, UNCOMPRESS_NB_MAX_PERIODS));
+    if (p_cache->path && p_cache->index && p_cache->scratch) {
+        p_cache->fd = open(path, O_RDWR | O_CREAT, 0644);
+    }
+    if ((p_cache->fd < 0) || !cache_load(p_cache)) {
+        NRF_LOG_ERROR("cache: cannot open %s", path);
+        lib_uncompress_cache_close(p_cache);
+        return NULL;
+    }
+    NRF_LOG_INFO("cache: %s opened, %u entries", path, p_cache->nbEntries);
+    return p_cache;
+}
+
+//****************************************************************************
+void lib_uncompress_cache_close(uncompress_cache_t *p_cache)
+{
+    if (!p_cache) {
+        return;
+    }
+    if (p_cache->map) {
+        munmap(p_cache->map, p_cache->mapSize);
+    }
+    if (p_cache->fd >= 0) {
+        close(p_cache->fd);
+    }
+    free(p_cache->scratch);
+    free(p_cache->index);
+    free(p_cache->path);
+    free(p_cache);
+}
+
+//****************************************************************************
+static int cache_compare_slots(const void *a, const void *b)
+{
+    const def_cache_slot_t *p_a = a;
+    const def_cache_slot_t *p_b = b;
+    // most recently used first
+    return (p_a->lastUse < p_b->lastUse) - (p_a->lastUse > p_b->lastUse);
+}
+
+//****************************************************************************
+// Keep the most recently used entries in half of maxBytes, minus neededBytes
+static uint8_t cache_compact(uncompress_cache_t *p_cache, uint32_t neededBytes)
+{
+    uint32_t nbKept = 0;
+    uint32_t size = sizeof(def_cache_file_header_t);
+    uint32_t budget = p_cache->maxBytes / 2;
+    def_cache_slot_t *slots = malloc((p_cache->nbEntries + 1) * sizeof(def_cache_slot_t));
+    char *tmpPath = malloc(strlen(p_cache->path) + 5);
+    uint8_t ret = 0;
+    int fd = -1;
+
+    if (!slots || !tmpPath || ((p_cache->mapSize != p_cache->fileSize) && !cache_remap(p_cache))) {
+        goto end;
+    }
+    for (uint32_t i = 0; i < p_cache->indexSize; i++) {
+        if (p_cache->index[i].offset) {
+            slots[nbKept++] = p_cache->index[i];
+        }
+    }
+    qsort(slots, nbKept, sizeof(def_cache_slot_t), cache_compare_slots);
+    budget = (budget > neededBytes) ? budget - neededBytes : 0;
+    for (uint32_t i = 0; i < nbKept; i++) {
+        def_cache_entry_header_t entry;
+        memcpy(&entry, &p_cache->map[slots[i].offset], sizeof(entry));
+        uint32_t entrySize = sizeof(entry) + CACHE_PAYLOAD_SIZE(entry.nbSamples, entry.nbPeriods);
+        if (size + entrySize > budget) {
+            nbKept = i;
+            break;
+        }
+        size += entrySize;
+    }
+
+    // write the kept entries, least recently used first so that file order still gives recency
+    sprintf(tmpPath, "%s.tmp", p_cache->path);
+    fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        goto end;
+    }
+    if (write(fd, p_cache->map, sizeof(def_cache_file_header_t)) != (ssize_t)sizeof(def_cache_file_header_t)) {
+        goto end;
+    }
+    for (uint32_t i = nbKept; i > 0; i--) {
+        def_cache_entry_header_t entry;
+        memcpy(&entry, &p_cache->map[slots[i-1].offset], sizeof(entry));
+        uint32_t entrySize = sizeof(entry) + CACHE_PAYLOAD_SIZE(entry.nbSamples, entry.nbPeriods);
+        if (write(fd, &p_cache->map[slots[i-1].offset], entrySize) != (ssize_t)entrySize) {
+            goto end;
+        }
+    }
+    if (rename(tmpPath, p_cache->path) != 0) {
+        goto end;
+    }
+    close(p_cache->fd);
+    p_cache->fd = fd;
+    fd = -1;
+    ret = cache_load(p_cache);
+    p_cache->stats.nbCompactions++;
+    NRF_LOG_INFO("cache: compacted to %u entries", p_cache->nbEntries);
+
+end:
+    if (fd >= 0) {
+        close(fd);
+        unlink(tmpPath);
+    }
+    free(tmpPath);
+    free(slots);
+    return ret;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_cache_get(uncompress_cache_t *p_cache, uint64_t key, samples_t *p_samples, uncompress_state_t *p_stateOut)
+{
+    ASSERT(p_cache);
+    ASSERT(p_samples);
+    def_cache_entry_header_t entry;
+
+    def_cache_slot_t *p_slot = cache_find_slot(p_cache, key);
+    if (!p_slot->offset) {
+        p_cache->stats.nbMisses++;
+        return 0;
+    }
+    if ((p_cache->mapSize != p_cache->fileSize) && !cache_remap(p_cache)) {
+        return 0;
+    }
+    memcpy(&entry, &p_cache->map[p_slot->offset], sizeof(entry));
+    const uint8_t *p_times = &p_cache->map[p_slot->offset + sizeof(entry)];
+    const uint8_t *p_tempes = p_times + entry.nbSamples * sizeof(uint32_t);
+    const uint8_t *p_firsts = p_times + CACHE_COLUMNS_SIZE(entry.nbSamples);
+    const uint8_t *p_periods = p_firsts + entry.nbPeriods * sizeof(uint32_t);
+    for (uint32_t i = 0; i < entry.nbSamples; i++) {
+        memcpy(&p_samples->samples[i].time, &p_times[i * sizeof(uint32_t)], sizeof(uint32_t));
+        memcpy(&p_samples->samples[i].tempe, &p_tempes[i * sizeof(int16_t)], sizeof(int16_t));
+    }
+    for (uint16_t i = 0; i < entry.nbPeriods; i++) {
+        memcpy(&p_samples->periods[i].firstSample, &p_firsts[i * sizeof(uint32_t)], sizeof(uint32_t));
+        memcpy(&p_samples->periods[i].period, &p_periods[i * sizeof(uint16_t)], sizeof(uint16_t));
+    }
+    p_samples->nbSamples = entry.nbSamples;
+    p_samples->nbPeriods = entry.nbPeriods;
+    if (p_stateOut) {
+        *p_stateOut = entry.stateOut;
+    }
+    p_slot->lastUse = ++p_cache->useCounter;
+    p_cache->stats.nbHits++;
+    return 1;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_cache_put(uncompress_cache_t *p_cache, uint64_t key, const samples_t *p_samples, const uncompress_state_t *p_stateOut)
+{
+    ASSERT(p_cache);
+    ASSERT(p_samples);
+    ASSERT(p_stateOut);
+    def_cache_entry_header_t entry;
+    uint32_t payloadSize = CACHE_PAYLOAD_SIZE(p_samples->nbSamples, p_samples->nbPeriods);
+    uint32_t entrySize = sizeof(entry) + payloadSize;
+
+    if ((p_samples->nbSamples > SRV_UNCOMPRESS_NB_MAX_SAMPLES)
+        || !p_samples->nbPeriods || (p_samples->nbPeriods > UNCOMPRESS_NB_MAX_PERIODS)
+        || (sizeof(def_cache_file_header_t) + entrySize > p_cache->maxBytes / 2)) {
+        return 0;   // would not fit even after compaction
+    }
+    if ((p_cache->fileSize + entrySize > p_cache->maxBytes) && !cache_compact(p_cache, entrySize)) {
+        return 0;
+    }
+
+    uint8_t *p_payload = &p_cache->scratch[sizeof(entry)];
+    uint8_t *p_tempes = p_payload + p_samples->nbSamples * sizeof(uint32_t);
+    uint8_t *p_firsts = p_payload + CACHE_COLUMNS_SIZE(p_samples->nbSamples);
+    uint8_t *p_periods = p_firsts + p_samples->nbPeriods * sizeof(uint32_t);
+    memset(p_payload, 0, payloadSize);
+    for (uint32_t i = 0; i < p_samples->nbSamples; i++) {
+        memcpy(&p_payload[i * sizeof(uint32_t)], &p_samples->samples[i].time, sizeof(uint32_t));
+        memcpy(&p_tempes[i * sizeof(int16_t)], &p_samples->samples[i].tempe, sizeof(int16_t));
+    }
+    for (uint16_t i = 0; i < p_samples->nbPeriods; i++) {
+        memcpy(&p_firsts[i * sizeof(uint32_t)], &p_samples->periods[i].firstSample, sizeof(uint32_t));
+        memcpy(&p_periods[i * sizeof(uint16_t)], &p_samples->periods[i].period, sizeof(uint16_t));
+    }
+    memset(&entry, 0, sizeof(entry));
+    entry.magic = CACHE_ENTRY_MAGIC;
+    entry.nbSamples = p_samples->nbSamples;
+    entry.nbPeriods = p_samples->nbPeriods;
+    entry.key = key;
+    entry.stateOut = *p_stateOut;
+    entry.checksum = (uint32_t)cache_hash(p_payload, payloadSize, key);
+    memcpy(p_cache->scratch, &entry, sizeof(entry));
+
+    if (pwrite(p_cache->fd, p_cache->scratch, entrySize, p_cache->fileSize) != (ssize_t)entrySize) {
+        NRF_LOG_ERROR("cache: cannot write %s", p_cache->path);
+        return 0;
+    }
+    uint32_t offset = p_cache->fileSize;
+    p_cache->fileSize += entrySize;
+    return cache_index_insert(p_cache, key, offset);
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_cache_uncompress_data_with_state(uncompress_cache_t *p_cache, uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state)
+{
+    ASSERT(p_state);
+    uint64_t key;
+
+    if (!p_cache) {
+        return lib_uncompress_data_with_state(buffer, len, p_samples, p_state);
+    }
+    key = lib_uncompress_cache_key(buffer, len, p_state);
+    if (lib_uncompress_cache_get(p_cache, key, p_samples, p_state)) {
+        return p_samples->nbSamples ? 1 : 0;
+    }
+    uint8_t ret = lib_uncompress_data_with_state(buffer, len, p_samples, p_state);
+    lib_uncompress_cache_put(p_cache, key, p_samples, p_state);
+    return ret;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_cache_uncompress_data(uncompress_cache_t *p_cache, uint8_t *buffer, uint8_t len, samples_t *p_samples)
+{
+    uncompress_state_t state;
+
+    // same state as lib_uncompress_data: only the temperature is carried in
+    lib_uncompress_get_state(&state);
+    lib_uncompress_state_new_frame(&state);
+    uint8_t ret = lib_uncompress_cache_uncompress_data_with_state(p_cache, buffer, len, p_samples, &state);
+    lib_uncompress_set_state(&state);
+    return ret;
+}
+
+//****************************************************************************
+void lib_uncompress_cache_get_stats(uncompress_cache_t *p_cache, uncompress_cache_stats_t *p_stats)
+{
+    ASSERT(p_cache);
+    ASSERT(p_stats);
+    *p_stats = p_cache->stats;
+    p_stats->nbEntries = p_cache->nbEntries;
+    p_stats->fileSize = p_cache->fileSize;
+}
@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_cache.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Persistent cache of uncompressed frames.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_CACHE_H
+#define _LIB_UNCOMPRESS_CACHE_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+#include "lib_uncompress.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_CACHE_DEFAULT_MAX_BYTES  (16UL * 1024 * 1024)
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+typedef struct uncompress_cache_s uncompress_cache_t;  // opaque, allocated by lib_uncompress_cache_open
+
+typedef struct {
+    uint32_t    nbHits;
+    uint32_t    nbMisses;
+    uint32_t    nbEntries;      // entries currently in the file
+    uint32_t    nbCompactions;  // number of evictions
+    uint32_t    fileSize;       // bytes
+} uncompress_cache_stats_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Open (or create) a cache file.
+ * \param[in] path the cache file.
+ * \param[in] maxBytes max size of the file; when reached, the least recently used entries are evicted.
+ * \retval the cache, NULL on error.
+ * The file is append only: each entry holds the key, the decoder state after the frame, the samples
+ * as two columns (times then temperatures) and the periods of the samples. It is mapped in memory to
+ * read entries. A truncated last entry (crash while writing) is dropped at opening. Data are stored in
+ * native byte order.
+ */
+uncompress_cache_t *lib_uncompress_cache_open(const char *path, uint32_t maxBytes);
+
+//****************************************************************************
+/**
+ * \brief Close a cache opened by lib_uncompress_cache_open, and free it.
+ * \param[in] p_cache the cache, may be NULL.
+ */
+void lib_uncompress_cache_close(uncompress_cache_t *p_cache);
+
+//****************************************************************************
+/**
+ * \brief Compute the key of a frame.
+ * \param[in] buffer the compressed frame.
+ * \param[in] len len of the frame, in bytes.
+ * \param[in] p_stateIn the decoder state used to decode the frame.
+ * \retval a 64 bits hash of the frame and of the state.
+ */
+uint64_t lib_uncompress_cache_key(const uint8_t *buffer, uint16_t len, const uncompress_state_t *p_stateIn);
+
+//****************************************************************************
+/**
+ * \brief Look for a frame in the cache.
+ * \param[in] p_cache the cache.
+ * \param[in] key the key given by lib_uncompress_cache_key.
+ * \param[out] p_samples filled with the cached samples if found.
+ * \param[out] p_stateOut filled with the decoder state after the frame if found, may be NULL.
+ * \retval 1 if found, 0 otherwise.
+ */
+uint8_t lib_uncompress_cache_get(uncompress_cache_t *p_cache, uint64_t key, samples_t *p_samples, uncompress_state_t *p_stateOut);
+
+//****************************************************************************
+/**
+ * \brief Append a decoded frame to the cache.
+ * \param[in] p_cache the cache.
+ * \param[in] key the key given by lib_uncompress_cache_key.
+ * \param[in] p_samples the decoded samples.
+ * \param[in] p_stateOut the decoder state after the frame.
+ * \retval 1 on success, 0 on error.
+ */
+uint8_t lib_uncompress_cache_put(uncompress_cache_t *p_cache, uint64_t key, const samples_t *p_samples, const uncompress_state_t *p_stateOut);
+
+//****************************************************************************
+/**
+ * \brief Same as lib_uncompress_data, using the cache.
+ * \param[in] p_cache the cache, if NULL lib_uncompress_data is called.
+ * \param[in] buffer the buffer contains the compressed data.
+ * \param[in] len len of data, in bytes.
+ * \param[out] p_samples a struct where to store uncompressed samples.
+ * \retval 1 on success, 0 on error
+ * The decoder state is updated as lib_uncompress_data would do, so that calls can be mixed.
+ */
+uint8_t lib_uncompress_cache_uncompress_data(uncompress_cache_t *p_cache, uint8_t *buffer, uint8_t len, samples_t *p_samples);
+
+//****************************************************************************
+/**
+ * \brief Same as lib_uncompress_data_with_state, using the cache.
+ * \param[in] p_cache the cache, if NULL lib_uncompress_data_with_state is called.
+ * \param[in] buffer the buffer contains the compressed data.
+ * \param[in] len len of data, in bytes.
+ * \param[out] p_samples a struct where to store uncompressed samples.
+ * \param[in,out] p_state the state before the frame (part of the key), updated with the state after the frame.
+ * \retval 1 on success, 0 on error
+ */
+uint8_t lib_uncompress_cache_uncompress_data_with_state(uncompress_cache_t *p_cache, uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state);
+
+//****************************************************************************
+/**
+ * \brief Get cache counters.
+ * \param[in] p_cache the cache.
+ * \param[out] p_stats the counters.
+ */
+void lib_uncompress_cache_get_stats(uncompress_cache_t *p_cache, uncompress_cache_stats_t *p_stats);
+
+#endif // _LIB_UNCOMPRESS_CACHE_H
@@ -0,0 +1,195 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_fill.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Expected timestamps of the samples decoded without a valid time.
+  *       Samples are handled by blocks of 32 (one word of the interpolated mask):
+  *       the mask of invalid times is computed without branch, then each run of
+  *       invalid times is filled with an arithmetic progression, split where the
+  *       sampling period changes.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_fill.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_fill
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define FILL_BLOCK_SIZE     32
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static uint32_t fill_invalid_mask(const record_t *records, uint32_t nb);
+static uint8_t fill_trailing_zeros(uint32_t value);
+static void fill_run(record_t *records, uint32_t nb, uint32_t firstTime, uint32_t period);
+static uint32_t fill_gap(uncompress_fill_t *p_fill, record_t *records, uint32_t nb, uint16_t period);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+// 1 << j, a shift by the loop index keeps the compiler from vectorizing the mask loop
+static const uint32_t fillBits[FILL_BLOCK_SIZE] = {
+    1U << 0,  1U << 1,  1U << 2,  1U << 3,  1U << 4,  1U << 5,  1U << 6,  1U << 7,
+    1U << 8,  1U << 9,  1U << 10, 1U << 11, 1U << 12, 1U << 13, 1U << 14, 1U << 15,
+    1U << 16, 1U << 17, 1U << 18, 1U << 19, 1U << 20, 1U << 21, 1U << 22, 1U << 23,
+    1U << 24, 1U << 25, 1U << 26, 1U << 27, 1U << 28, 1U << 29, 1U << 30, 1U << 31,
+};
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+// Bit j is set when sample j has no valid time
+static uint32_t fill_invalid_mask(const record_t *records, uint32_t nb)
+{
+    uint32_t mask = 0;
+
+    for (uint32_t j = 0; j < nb; j++) {
+        mask |= (0U - (uint32_t)(records[j].time == UNCOMPRESS_INVALID_TIME)) & fillBits[j];
+    }
+    return mask;
+}
+
+//****************************************************************************
+// value > 0
+static uint8_t fill_trailing_zeros(uint32_t value)
+{
+#if defined(__GNUC__)
+    return (uint8_t)__builtin_ctz(value);
+#else
+    uint8_t count = 0;
+    while (!(value & 1)) {
+        count++;
+        value >>= 1;
+    }
+    return count;
+#endif
+}
+
+//****************************************************************************
+static void fill_run(record_t *records, uint32_t nb, uint32_t firstTime, uint32_t period)
+{
+    for (uint32_t k = 0; k < nb; k++) {
+        records[k].time = firstTime + k * period;
+    }
+}
+
+//****************************************************************************
+// nb samples without time, all decoded with period: fill the ones which can be placed, return their number
+static uint32_t fill_gap(uncompress_fill_t *p_fill, record_t *records, uint32_t nb, uint16_t period)
+{
+    uint32_t nbPlaced;
+
+    if ((period == UINT16_MAX) || (period == 0) || (p_fill->lastTime == UNCOMPRESS_INVALID_TIME)) {
+        p_fill->lastTime = UNCOMPRESS_INVALID_TIME;
+        return 0;
+    }
+    // stop before a time which would read as UNCOMPRESS_INVALID_TIME, or wrap
+    nbPlaced = (UNCOMPRESS_INVALID_TIME - 1 - p_fill->lastTime) / period;
+    if (nbPlaced > nb) {
+        nbPlaced = nb;
+    }
+    fill_run(records, nbPlaced, p_fill->lastTime + period, period);
+    p_fill->lastTime = (nbPlaced == nb) ? p_fill->lastTime + nb * period : UNCOMPRESS_INVALID_TIME;
+    return nbPlaced;
+}
+
+//****************************************************************************
+void lib_uncompress_fill_init(uncompress_fill_t *p_fill)
+{
+    ASSERT(p_fill);
+    p_fill->lastTime = UNCOMPRESS_INVALID_TIME;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_fill_times(uncompress_fill_t *p_fill, record_t *records, uint32_t nbRecords,
+                                   const uncompress_period_t *periods, uint16_t nbPeriods, uint32_t *interpolatedMask)
+{
+    ASSERT(p_fill);
+    ASSERT(records || !nbRecords);
+    ASSERT(periods || !nbPeriods);
+    uint16_t next = 0;          // next change of period
+    uint16_t period = UINT16_MAX;
+    uint32_t nbFilled = 0;
+
+    for (uint32_t i = 0; i < nbRecords; i += FILL_BLOCK_SIZE) {
+        record_t *block = &records[i];
+        uint32_t nb = nbRecords - i;
+        uint32_t invalid, filled = 0;
+        uint32_t pos = 0;
+
+        if (nb > FILL_BLOCK_SIZE) {
+            nb = FILL_BLOCK_SIZE;
+        }
+        invalid = fill_invalid_mask(block, nb);
+        while (pos < nb) {
+            uint32_t rest = invalid >> pos;     // pos < nb <= FILL_BLOCK_SIZE
+            uint32_t first, end, ones;
+
+            if (!rest) {
+                // only valid times up to the end of the block
+                p_fill->lastTime = block[nb - 1].time;
+                break;
+            }
+            first = pos + fill_trailing_zeros(rest);
+            if (first > pos) {
+                p_fill->lastTime = block[first - 1].time;
+            }
+            // invalid bits are only set below nb, so the run ends at nb at the latest
+            ones = ~(invalid >> first);
+            end = first + (ones ? fill_trailing_zeros(ones) : FILL_BLOCK_SIZE - first);
+            // one progression per period of the run
+            while (first < end) {
+                uint32_t segEnd = end, nbPlaced;
+                while ((next < nbPeriods) && (periods[next].firstSample <= i + first)) {
+                    period = periods[next++].period;
+                }
+                if ((next < nbPeriods) && (periods[next].firstSample < i + end)) {
+                    segEnd = periods[next].firstSample - i;
+                }
+                nbPlaced = fill_gap(p_fill, &block[first], segEnd - first, period);
+                if (nbPlaced) {
+                    filled |= ((nbPlaced < FILL_BLOCK_SIZE) ? ((1U << nbPlaced) - 1) : UINT32_MAX) << first;
+                    nbFilled += nbPlaced;
+                }
+                first = segEnd;
+            }
+            pos = end;
+        }
+        if (interpolatedMask) {
+            interpolatedMask[i / FILL_BLOCK_SIZE] = filled;
+        }
+    }
+    NRF_LOG_DEBUG("filled %u times of %u samples", nbFilled, nbRecords);
+    return nbFilled;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_fill_samples(uncompress_fill_t *p_fill, samples_t *p_samples, uint32_t *interpolatedMask)
+{
+    ASSERT(p_samples);
+    return lib_uncompress_fill_times(p_fill, p_samples->samples, p_samples->nbSamples,
+                                     p_samples->periods, p_samples->nbPeriods, interpolatedMask);
+}
@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_fill.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Expected timestamps of the samples decoded without a valid time.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_FILL_H
+#define _LIB_UNCOMPRESS_FILL_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+#include "lib_uncompress_stats.h"
+#include "lib_uncompress.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+
+// Kept from one call of lib_uncompress_fill_times to the next, for the gaps spanning several calls
+typedef struct {
+    uint32_t    lastTime;           // time of the previous sample, decoded or filled, UNCOMPRESS_INVALID_TIME if unknown
+} uncompress_fill_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Initialize a fill context, before the first samples or when the decoder state is reset
+ *        (lib_uncompress_state_new_frame, lib_uncompress_data).
+ * \param[out] p_fill the context.
+ */
+void lib_uncompress_fill_init(uncompress_fill_t *p_fill);
+
+//****************************************************************************
+/**
+ * \brief Give an expected time to the samples without a valid time (invalid timestamps and unreceived samples).
+ * \param[in,out] p_fill the context, see lib_uncompress_fill_init.
+ * \param[in,out] records the samples, as filled by lib_uncompress_data.
+ * \param[in] nbRecords number of samples in records.
+ * \param[in] periods the sampling periods of these samples, as given in samples_t (periods[0].firstSample is 0).
+ * \param[in] nbPeriods number of periods, at least 1.
+ * \param[out] interpolatedMask optional (may be NULL), UNCOMPRESS_STATS_MASK_WORDS(nbRecords) words.
+ *             Bit (i & 31) of word (i >> 5) is set when the time of sample i was filled.
+ * \retval the number of samples filled.
+ * A sample without time gets the time of the previous sample plus the period it was decoded with: the k-th
+ * sample after the last valid time gets lastValidTime + k * period when the period does not change, as the
+ * decoder adds n + 1 periods to the differential timestamp following n samples without time. Samples before
+ * the first valid time, decoded while the period is unknown (0 or UINT16_MAX), or whose time would reach
+ * UNCOMPRESS_INVALID_TIME keep UNCOMPRESS_INVALID_TIME, and so do the next ones up to a valid time.
+ * Samples are handled by blocks of 32; blocks without gap are only scanned, and the times of a gap
+ * are written by a loop without dependency between iterations, so that both are vectorized.
+ */
+uint32_t lib_uncompress_fill_times(uncompress_fill_t *p_fill, record_t *records, uint32_t nbRecords,
+                                   const uncompress_period_t *periods, uint16_t nbPeriods, uint32_t *interpolatedMask);
+
+//****************************************************************************
+/**
+ * \brief Fill the times of the samples of a frame, see lib_uncompress_fill_times.
+ * \param[in,out] p_fill the context.
+ * \param[in,out] p_samples the samples, as filled by lib_uncompress_data.
+ * \param[out] interpolatedMask optional (may be NULL), UNCOMPRESS_STATS_MASK_WORDS(p_samples->nbSamples) words.
+ * \retval the number of samples filled.
+ */
+uint32_t lib_uncompress_fill_samples(uncompress_fill_t *p_fill, samples_t *p_samples, uint32_t *interpolatedMask);
+
+#endif // _LIB_UNCOMPRESS_FILL_H
@@ -0,0 +1,358 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_session.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Recording session kept compressed in memory (about 10 times less than
+  *       decoded samples). Each frame is indexed when appended (first sample,
+  *       number of samples, max valid time, decoder state before the frame) so
+  *       that it can be decoded alone when accessed. A bounded LRU keeps the
+  *       last decoded frames, and the next frame in the scrolling direction is
+  *       decoded in advance.
+  *       Sessions do not use the global decoder state, but a session must not
+  *       be shared between threads.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_session.h"
+#include "lib_uncompress_stats.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_session
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define SESSION_MIN_FRAMES      64
+#define SESSION_MIN_BYTES       (SESSION_MIN_FRAMES * 160)
+#define SESSION_NO_FRAME        UINT32_MAX
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+typedef struct {
+    uint32_t    offset;         // offset of the compressed frame in data
+    uint32_t    firstSample;    // index of the first sample of the frame in the session
+    uint32_t    nbSamples;
+    uint32_t    maxTime;        // max valid time of this frame and of all the previous ones
+    uncompress_state_t stateIn; // decoder state before the frame
+    uint8_t     len;
+} def_session_frame_t;
+
+typedef struct {
+    uint32_t    frame;          // SESSION_NO_FRAME if the slot is free
+    uint32_t    lastUse;
+    uint32_t    capacity;       // number of records allocated
+    record_t    *records;
+} def_session_slot_t;
+
+struct uncompress_session_s {
+    def_session_frame_t *frames;
+    uint32_t    nbFrames;
+    uint32_t    maxFrames;
+    uint8_t     *data;          // compressed frames, one after the other
+    uint32_t    dataSize;
+    uint32_t    maxDataSize;
+    uint32_t    nbSamples;
+    uncompress_state_t stateOut;    // decoder state after the last appended frame
+    samples_t   *scratch;
+    def_session_slot_t *slots;
+    uint16_t    nbSlots;
+    uint32_t    useCounter;
+    uint32_t    lastFrame;      // last accessed frame, to guess the scrolling direction
+    uncompress_session_stats_t stats;
+};
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static void session_decode(uncompress_session_t *p_session, const def_session_frame_t *p_frame);
+static const record_t *session_get_frame(uncompress_session_t *p_session, uint32_t frame);
+static uint32_t session_find_frame(uncompress_session_t *p_session, uint32_t sample);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+uncompress_session_t *lib_uncompress_session_create(uint16_t nbCachedFrames)
+{
+    uncompress_session_t *p_session = calloc(1, sizeof(uncompress_session_t));
+    if (!p_session) {
+        return NULL;
+    }
+    p_session->nbSlots = nbCachedFrames ? nbCachedFrames : UNCOMPRESS_SESSION_DEFAULT_NB_CACHED;
+    p_session->slots = calloc(p_session->nbSlots, sizeof(def_session_slot_t));
+    p_session->scratch = malloc(sizeof(samples_t));
+    if (!p_session->slots || !p_session->scratch) {
+        lib_uncompress_session_free(p_session);
+        return NULL;
+    }
+    for (uint16_t i = 0; i < p_session->nbSlots; i++) {
+        p_session->slots[i].frame = SESSION_NO_FRAME;
+    }
+    lib_uncompress_state_init(&p_session->stateOut);
+    p_session->lastFrame = SESSION_NO_FRAME;
+    return p_session;
+}
+
+//****************************************************************************
+void lib_uncompress_session_free(uncompress_session_t *p_session)
+{
+    if (!p_session) {
+        return;
+    }
+    if (p_session->slots) {
+        for (uint16_t i = 0; i < p_session->nbSlots; i++) {
+            free(p_session->slots[i].records);
+        }
+    }
+    free(p_session->slots);
+    free(p_session->scratch);
+    free(p_session->frames);
+    free(p_session->data);
+    free(p_session);
+}
+
+//****************************************************************************
+// Decode a frame alone in scratch, from its stored state
+static void session_decode(uncompress_session_t *p_session, const def_session_frame_t *p_frame)
+{
+    uncompress_state_t state = p_frame->stateIn;
+
+    lib_uncompress_data_with_state(&p_session->data[p_frame->offset], p_frame->len, p_session->scratch, &state);
+    p_session->stats.nbDecodes++;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_session_append(uncompress_session_t *p_session, const uint8_t *buffer, uint8_t len)
+{
+    ASSERT(p_session);
+    def_session_frame_t *p_frame;
+
+    if (!buffer || !len) {
+        return 0;
+    }
+    if (p_session->nbFrames == p_session->maxFrames) {
+        uint32_t maxFrames = p_session->maxFrames ? p_session->maxFrames * 2 : SESSION_MIN_FRAMES;
+        def_session_frame_t *frames = realloc(p_session->frames, maxFrames * sizeof(def_session_frame_t));
+        if (!frames) {
+            return 0;
+        }
+        p_session->frames = frames;
+        p_session->maxFrames = maxFrames;
+    }
+    if (p_session->dataSize + len > p_session->maxDataSize) {
+        uint32_t maxDataSize = p_session->maxDataSize ? p_session->maxDataSize * 2 : SESSION_MIN_BYTES;
+        uint8_t *data = realloc(p_session->data, maxDataSize);
+        if (!data) {
+            return 0;
+        }
+        p_session->data = data;
+        p_session->maxDataSize = maxDataSize;
+    }
+
+    p_frame = &p_session->frames[p_session->nbFrames];
+    p_frame->offset = p_session->dataSize;
+    p_frame->len = len;
+    p_frame->firstSample = p_session->nbSamples;
+    // same as lib_uncompress_data: only the temperature reference is kept from the previous frame
+    lib_uncompress_state_new_frame(&p_session->stateOut);
+    p_frame->stateIn = p_session->stateOut;
+    memcpy(&p_session->data[p_frame->offset], buffer, len);
+
+    // decode once to index the frame, and get the state for the next one
+    lib_uncompress_data_with_state(&p_session->data[p_frame->offset], len, p_session->scratch, &p_session->stateOut);
+
+    if (!p_session->scratch->nbSamples) {
+        return 0;   // keep the state (period may be set) but not the frame
+    }
+    p_frame->nbSamples = p_session->scratch->nbSamples;
+    p_frame->maxTime = p_session->nbFrames ? p_session->frames[p_session->nbFrames-1].maxTime : 0;
+    for (uint32_t i = 0; i < p_frame->nbSamples; i++) {
+        uint32_t time = p_session->scratch->samples[i].time;
+        if ((time != UNCOMPRESS_INVALID_TIME) && (time > p_frame->maxTime)) {
+            p_frame->maxTime = time;
+        }
+    }
+    p_session->dataSize += len;
+    p_session->nbSamples += p_frame->nbSamples;
+    p_session->nbFrames++;
+    return 1;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_session_get_nb_samples(uncompress_session_t *p_session)
+{
+    ASSERT(p_session);
+    return p_session->nbSamples;
+}
+
+//****************************************************************************
+// Get the decoded samples of a frame, from the LRU or decoded now
+static const record_t *session_get_frame(uncompress_session_t *p_session, uint32_t frame)
+{
+    def_session_slot_t *p_slot = &p_session->slots[0];
+    const def_session_frame_t *p_frame = &p_session->frames[frame];
+
+    for (uint16_t i = 0; i < p_session->nbSlots; i++) {
+        if (p_session->slots[i].frame == frame) {
+            p_session->slots[i].lastUse = ++p_session->useCounter;
+            p_session->stats.nbHits++;
+            return p_session->slots[i].records;
+        }
+        // take a free slot, or the least recently used one
+        if ((p_slot->frame != SESSION_NO_FRAME)
+            && ((p_session->slots[i].frame == SESSION_NO_FRAME) || (p_session->slots[i].lastUse < p_slot->lastUse))) {
+            p_slot = &p_session->slots[i];
+        }
+    }
+
+    if (p_slot->capacity < p_frame->nbSamples) {
+        record_t *records = realloc(p_slot->records, p_frame->nbSamples * sizeof(record_t));
+        if (!records) {
+            return NULL;
+        }
+        p_session->stats.decodedBytes += (p_frame->nbSamples - p_slot->capacity) * sizeof(record_t);
+        p_slot->records = records;
+        p_slot->capacity = p_frame->nbSamples;
+    }
+    session_decode(p_session, p_frame);
+    if (p_session->scratch->nbSamples != p_frame->nbSamples) {
+        NRF_LOG_ERROR("session: frame %u decoded with %u samples instead of %u", frame, p_session->scratch->nbSamples, p_frame->nbSamples);
+        p_slot->frame = SESSION_NO_FRAME;
+        return NULL;
+    }
+    memcpy(p_slot->records, p_session->scratch->samples, p_frame->nbSamples * sizeof(record_t));
+    p_slot->frame = frame;
+    p_slot->lastUse = ++p_session->useCounter;
+    return p_slot->records;
+}
+
+//****************************************************************************
+// Binary search of the frame holding a sample
+static uint32_t session_find_frame(uncompress_session_t *p_session, uint32_t sample)
+{
+    uint32_t low = 0, high = p_session->nbFrames;
+
+    while (high - low > 1) {
+        uint32_t mid = (low + high) / 2;
+        if (p_session->frames[mid].firstSample <= sample) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_session_get_samples(uncompress_session_t *p_session, uint32_t first, uint32_t nb, record_t *output)
+{
+    ASSERT(p_session);
+    uint32_t nbRead = 0;
+    uint32_t frame;
+
+    if (!output || (first >= p_session->nbSamples)) {
+        return 0;
+    }
+    if (nb > p_session->nbSamples - first) {
+        nb = p_session->nbSamples - first;
+    }
+    frame = session_find_frame(p_session, first);
+    while (nbRead < nb) {
+        const def_session_frame_t *p_frame = &p_session->frames[frame];
+        const record_t *records = session_get_frame(p_session, frame);
+        if (!records) {
+            break;
+        }
+        uint32_t offset = first + nbRead - p_frame->firstSample;
+        uint32_t nbCopy = p_frame->nbSamples - offset;
+        if (nbCopy > nb - nbRead) {
+            nbCopy = nb - nbRead;
+        }
+        memcpy(&output[nbRead], &records[offset], nbCopy * sizeof(record_t));
+        nbRead += nbCopy;
+        if (nbRead < nb) {
+            frame++;
+        }
+    }
+
+    // prefetch the next frame in the scrolling direction
+    uint32_t next = SESSION_NO_FRAME;
+    if ((p_session->lastFrame == SESSION_NO_FRAME) || (frame >= p_session->lastFrame)) {
+        if (frame + 1 < p_session->nbFrames) {
+            next = frame + 1;
+        }
+    } else {
+        next = session_find_frame(p_session, first);
+        next = next ? next - 1 : SESSION_NO_FRAME;
+    }
+    p_session->lastFrame = frame;
+    if ((next != SESSION_NO_FRAME) && (p_session->nbSlots > 1)) {
+        uint32_t nbHits = p_session->stats.nbHits;
+        session_get_frame(p_session, next);
+        p_session->stats.nbHits = nbHits;   // do not count prefetches as hits
+    }
+    return nbRead;
+}
+
+//****************************************************************************
+uint32_t lib_uncompress_session_find_time(uncompress_session_t *p_session, uint32_t time)
+{
+    ASSERT(p_session);
+    uint32_t low = 0, high = p_session->nbFrames;
+
+    // first frame whose max time (including previous frames) reaches time
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (p_session->frames[mid].maxTime < time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == p_session->nbFrames) {
+        return UNCOMPRESS_SESSION_NOT_FOUND;
+    }
+    const def_session_frame_t *p_frame = &p_session->frames[low];
+    const record_t *records = session_get_frame(p_session, low);
+    if (!records) {
+        return UNCOMPRESS_SESSION_NOT_FOUND;
+    }
+    for (uint32_t i = 0; i < p_frame->nbSamples; i++) {
+        if ((records[i].time != UNCOMPRESS_INVALID_TIME) && (records[i].time >= time)) {
+            return p_frame->firstSample + i;
+        }
+    }
+    return UNCOMPRESS_SESSION_NOT_FOUND;
+}
+
+//****************************************************************************
+void lib_uncompress_session_get_stats(uncompress_session_t *p_session, uncompress_session_stats_t *p_stats)
+{
+    ASSERT(p_session);
+    ASSERT(p_stats);
+    *p_stats = p_session->stats;
+    p_stats->nbFrames = p_session->nbFrames;
+    p_stats->nbSamples = p_session->nbSamples;
+    p_stats->compressedBytes = p_session->dataSize;
+}
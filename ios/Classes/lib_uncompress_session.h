@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_session.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Recording session kept compressed, frames decoded on access.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_SESSION_H
+#define _LIB_UNCOMPRESS_SESSION_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+#include "lib_uncompress.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_SESSION_DEFAULT_NB_CACHED    32      // decoded frames kept in memory
+#define UNCOMPRESS_SESSION_NOT_FOUND            UINT32_MAX
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+typedef struct uncompress_session_s uncompress_session_t;  // opaque, allocated by lib_uncompress_session_create
+
+typedef struct {
+    uint32_t    nbFrames;
+    uint32_t    nbSamples;
+    uint32_t    compressedBytes;    // memory used by compressed frames
+    uint32_t    decodedBytes;       // memory used by decoded frames in the LRU
+    uint32_t    nbDecodes;          // number of frames decoded on access or prefetch
+    uint32_t    nbHits;             // accesses served by the LRU
+} uncompress_session_stats_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Create an empty session.
+ * \param[in] nbCachedFrames max number of decoded frames kept in memory (LRU), 0 for the default.
+ * \retval the session, NULL on error.
+ */
+uncompress_session_t *lib_uncompress_session_create(uint16_t nbCachedFrames);
+
+//****************************************************************************
+/**
+ * \brief Free a session created by lib_uncompress_session_create.
+ * \param[in] p_session the session, may be NULL.
+ */
+void lib_uncompress_session_free(uncompress_session_t *p_session);
+
+//****************************************************************************
+/**
+ * \brief Append a compressed frame to the session.
+ * \param[in] p_session the session.
+ * \param[in] buffer the compressed frame, copied.
+ * \param[in] len len of the frame, in bytes.
+ * \retval 1 on success, 0 on error (nothing decoded in the frame, or no memory).
+ * The frame is decoded once to index its samples and times, with the decoder state left by the
+ * previous frame of the session, then only the compressed frame is kept.
+ */
+uint8_t lib_uncompress_session_append(uncompress_session_t *p_session, const uint8_t *buffer, uint8_t len);
+
+//****************************************************************************
+/**
+ * \brief Number of samples of the session.
+ * \param[in] p_session the session.
+ * \retval the number of samples.
+ */
+uint32_t lib_uncompress_session_get_nb_samples(uncompress_session_t *p_session);
+
+//****************************************************************************
+/**
+ * \brief Read samples, decoding the frames which are not in memory.
+ * \param[in] p_session the session.
+ * \param[in] first index of the first sample.
+ * \param[in] nb number of samples to read.
+ * \param[out] output at least nb records, allocated by caller.
+ * \retval the number of samples read (less than nb at the end of the session).
+ * The next frame in the direction of the accesses is decoded in advance.
+ */
+uint32_t lib_uncompress_session_get_samples(uncompress_session_t *p_session, uint32_t first, uint32_t nb, record_t *output);
+
+//****************************************************************************
+/**
+ * \brief Find the first sample with a valid time greater or equal to a time.
+ * \param[in] p_session the session.
+ * \param[in] time the time to look for.
+ * \retval the index of the sample, UNCOMPRESS_SESSION_NOT_FOUND if there is none.
+ * Frames are expected to be appended in chronological order.
+ */
+uint32_t lib_uncompress_session_find_time(uncompress_session_t *p_session, uint32_t time);
+
+//****************************************************************************
+/**
+ * \brief Get session counters.
+ * \param[in] p_session the session.
+ * \param[out] p_stats the counters.
+ */
+void lib_uncompress_session_get_stats(uncompress_session_t *p_session, uncompress_session_stats_t *p_stats);
+
+#endif // _LIB_UNCOMPRESS_SESSION_H
@@ -0,0 +1,198 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_stats.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Single pass statistics over uncompressed samples.
+  *       Samples are handled by blocks of 32 (one word of the validity mask),
+  *       the block loop has no branch so that it is vectorized by the compiler.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <string.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_stats.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_stats
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define STATS_BLOCK_SIZE    32
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+// Accumulators of a block, merged into the global statistics at the end of each block
+typedef struct {
+    uint32_t    nbValidTempe;
+    uint32_t    nbInvalidTempe;
+    uint32_t    nbUnreceived;
+    uint32_t    nbInvalidTime;
+    int32_t     minTempe;
+    int32_t     maxTempe;
+    int64_t     sumTempe;
+    uint64_t    sumSqTempe;
+    uint32_t    firstTime;
+    uint32_t    lastTime;
+    uint32_t    mask;
+} def_stats_block_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static void stats_block(const record_t *records, uint32_t nb, def_stats_block_t *p_block);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+// 1 << j, a shift by the loop index keeps the compiler from vectorizing the block loop
+static const uint32_t statsBits[STATS_BLOCK_SIZE] = {
+    1U << 0,  1U << 1,  1U << 2,  1U << 3,  1U << 4,  1U << 5,  1U << 6,  1U << 7,
+    1U << 8,  1U << 9,  1U << 10, 1U << 11, 1U << 12, 1U << 13, 1U << 14, 1U << 15,
+    1U << 16, 1U << 17, 1U << 18, 1U << 19, 1U << 20, 1U << 21, 1U << 22, 1U << 23,
+    1U << 24, 1U << 25, 1U << 26, 1U << 27, 1U << 28, 1U << 29, 1U << 30, 1U << 31,
+};
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+static void stats_block(const record_t *records, uint32_t nb, def_stats_block_t *p_block)
+{
+    uint32_t nbValid = 0, nbInvalid = 0, nbUnreceived = 0, nbInvalidTime = 0;
+    int32_t minT = INT16_MAX, maxT = INT16_MIN;
+    int32_t sum = 0;                // 32 * 32767 fits in 32 bits
+    uint64_t sumSq = 0;
+    uint32_t firstTime = UINT32_MAX, lastTime = 0;
+    uint32_t mask = 0;
+
+    for (uint32_t j = 0; j < nb; j++) {
+        int32_t tempe = records[j].tempe;
+        uint32_t time = records[j].time;
+        uint32_t invalidTempe = (tempe == INVALID_TEMPERATURE);
+        uint32_t unreceivedTempe = (tempe == UNCOMPRESS_UNRECEIVED_TEMPERATURE);
+        uint32_t validTempe = !(invalidTempe | unreceivedTempe);
+        uint32_t validTime = (time != UNCOMPRESS_INVALID_TIME);
+        // all-ones when valid, so that selections below do not need branches
+        int32_t selTempe = -(int32_t)validTempe;
+        uint32_t selTime = -validTime;
+
+        nbValid += validTempe;
+        nbInvalid += invalidTempe;
+        nbUnreceived += unreceivedTempe & !validTime;
+        nbInvalidTime += !validTime;
+
+        int32_t t = tempe & selTempe;
+        sum += t;
+        sumSq += (uint64_t)(t * t);
+        int32_t tMin = t | (~selTempe & INT16_MAX);
+        int32_t tMax = t | (~selTempe & INT16_MIN);
+        minT = (tMin < minT) ? tMin : minT;
+        maxT = (tMax > maxT) ? tMax : maxT;
+
+        uint32_t tFirst = time | ~selTime;
+        uint32_t tLast = time & selTime;
+        firstTime = (tFirst < firstTime) ? tFirst : firstTime;
+        lastTime = (tLast > lastTime) ? tLast : lastTime;
+
+        mask |= -(validTempe & validTime) & statsBits[j];
+    }
+
+    p_block->nbValidTempe = nbValid;
+    p_block->nbInvalidTempe = nbInvalid;
+    p_block->nbUnreceived = nbUnreceived;
+    p_block->nbInvalidTime = nbInvalidTime;
+    p_block->minTempe = minT;
+    p_block->maxTempe = maxT;
+    p_block->sumTempe = sum;
+    p_block->sumSqTempe = sumSq;
+    p_block->firstTime = firstTime;
+    p_block->lastTime = lastTime;
+    p_block->mask = mask;
+}
+
+//****************************************************************************
+void lib_uncompress_stats_compute(const record_t *records, uint32_t nbRecords, uncompress_stats_t *p_stats, uint32_t *validMask)
+{
+    ASSERT(p_stats);
+    def_stats_block_t block;
+    int32_t minT = INT16_MAX, maxT = INT16_MIN;
+    uint32_t firstTime = UINT32_MAX, lastTime = 0;
+
+    memset(p_stats, 0, sizeof(uncompress_stats_t));
+    p_stats->nbSamples = nbRecords;
+    if (!records) {
+        nbRecords = 0;
+    }
+
+    for (uint32_t i = 0; i < nbRecords; i += STATS_BLOCK_SIZE) {
+        uint32_t nb = nbRecords - i;
+        if (nb > STATS_BLOCK_SIZE) {
+            nb = STATS_BLOCK_SIZE;
+        }
+        stats_block(&records[i], nb, &block);
+
+        p_stats->nbValidTempe += block.nbValidTempe;
+        p_stats->nbInvalidTempe += block.nbInvalidTempe;
+        p_stats->nbUnreceived += block.nbUnreceived;
+        p_stats->nbInvalidTime += block.nbInvalidTime;
+        p_stats->sumTempe += block.sumTempe;
+        p_stats->sumSqTempe += block.sumSqTempe;
+        if (block.minTempe < minT) {
+            minT = block.minTempe;
+        }
+        if (block.maxTempe > maxT) {
+            maxT = block.maxTempe;
+        }
+        if (block.firstTime < firstTime) {
+            firstTime = block.firstTime;
+        }
+        if (block.lastTime > lastTime) {
+            lastTime = block.lastTime;
+        }
+        if (validMask) {
+            validMask[i / STATS_BLOCK_SIZE] = block.mask;
+        }
+    }
+
+    if (p_stats->nbValidTempe) {
+        double n = (double)p_stats->nbValidTempe;
+        double mean = (double)p_stats->sumTempe / n;
+        double variance = (double)p_stats->sumSqTempe / n - mean * mean;
+        p_stats->minTempe = (int16_t)minT;
+        p_stats->maxTempe = (int16_t)maxT;
+        p_stats->meanTempe = (float)mean;
+        p_stats->varianceTempe = (float)((variance > 0) ? variance : 0);
+    } else {
+        p_stats->minTempe = INVALID_TEMPERATURE;
+        p_stats->maxTempe = INVALID_TEMPERATURE;
+    }
+    p_stats->firstTime = firstTime;
+    p_stats->lastTime = lastTime;
+    if (firstTime < lastTime) {
+        p_stats->timeSpan = lastTime - firstTime;
+    }
+    NRF_LOG_DEBUG("stats: %u samples, %u valid temperatures", p_stats->nbSamples, p_stats->nbValidTempe);
+}
+
+//****************************************************************************
+void lib_uncompress_stats_compute_samples(const samples_t *p_samples, uncompress_stats_t *p_stats, uint32_t *validMask)
+{
+    ASSERT(p_samples);
+    lib_uncompress_stats_compute(p_samples->samples, p_samples->nbSamples, p_stats, validMask);
+}
@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_stats.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Statistics and validity mask computed over uncompressed samples.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_STATS_H
+#define _LIB_UNCOMPRESS_STATS_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+#include "lib_uncompress.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_UNRECEIVED_TEMPERATURE   ((int16_t)UINT16_MAX)   // temperature stored for unreceived samples
+#define UNCOMPRESS_INVALID_TIME             UINT32_MAX              // time stored for invalid/unreceived samples
+
+// Number of uint32_t words needed to store the validity mask of n samples
+#define UNCOMPRESS_STATS_MASK_WORDS(n)      (((n) + 31) / 32)
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+typedef struct {
+    uint32_t    nbSamples;          // number of samples analysed
+    uint32_t    nbValidTempe;       // samples with a valid temperature
+    uint32_t    nbInvalidTempe;     // samples with INVALID_TEMPERATURE (sensor error)
+    uint32_t    nbUnreceived;       // unreceived samples (invalid time and temperature set to UINT16_MAX)
+    uint32_t    nbInvalidTime;      // samples with an invalid time, unreceived samples included
+    int16_t     minTempe;           // min of valid temperatures, INVALID_TEMPERATURE if none
+    int16_t     maxTempe;           // max of valid temperatures, INVALID_TEMPERATURE if none
+    int64_t     sumTempe;           // sum of valid temperatures
+    uint64_t    sumSqTempe;         // sum of squares of valid temperatures
+    float       meanTempe;          // mean of valid temperatures, 0 if none
+    float       varianceTempe;      // population variance of valid temperatures, 0 if none
+    uint32_t    firstTime;          // min of valid times, UINT32_MAX if none
+    uint32_t    lastTime;           // max of valid times, 0 if none
+    uint32_t    timeSpan;           // lastTime - firstTime, 0 if less than two valid times
+} uncompress_stats_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Compute statistics over uncompressed samples, in a single pass.
+ * \param[in] records the samples, as filled by lib_uncompress_data.
+ * \param[in] nbRecords number of samples in records.
+ * \param[out] p_stats the statistics.
+ * \param[out] validMask optional (may be NULL), UNCOMPRESS_STATS_MASK_WORDS(nbRecords) words.
+ *             Bit (i & 31) of word (i >> 5) is set when sample i has both a valid time and a valid temperature.
+ * The loop works on blocks of 32 samples without branches so that the compiler can vectorize it.
+ */
+void lib_uncompress_stats_compute(const record_t *records, uint32_t nbRecords, uncompress_stats_t *p_stats, uint32_t *validMask);
+
+//****************************************************************************
+/**
+ * \brief Compute statistics over the samples of a frame, see lib_uncompress_stats_compute.
+ * \param[in] p_samples the samples, as filled by lib_uncompress_data.
+ * \param[out] p_stats the statistics.
+ * \param[out] validMask optional (may be NULL), UNCOMPRESS_STATS_MASK_WORDS(p_samples->nbSamples) words.
+ */
+void lib_uncompress_stats_compute_samples(const samples_t *p_samples, uncompress_stats_t *p_stats, uint32_t *validMask);
+
+#endif // _LIB_UNCOMPRESS_STATS_H
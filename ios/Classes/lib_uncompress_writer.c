@@ -0,0 +1,276 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_writer.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Format uncompressed samples straight into an output buffer, which
+  *       is written when full. Numbers are converted two digits at a time.
+  *       lib_uncompress_data_to_writer calls lib_uncompress_writer_add_one
+  *       for each decoded sample, so that no samples_t is needed.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_writer.h"
+#include "lib_uncompress_stats.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_writer
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define WRITER_BINARY_RECORD_LEN    6
+#define IS_VALID_TEMPE(t)   (((t) != INVALID_TEMPERATURE) && ((t) != UNCOMPRESS_UNRECEIVED_TEMPERATURE))
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static char *writer_put_u32(char *p, uint32_t value);
+static char *writer_put_tempe(char *p, const uncompress_writer_config_t *p_config, int16_t tempe);
+static uint8_t writer_flush_buffer(uncompress_writer_t *p_writer);
+static uint8_t writer_file_flush(void *p_user, const uint8_t *data, uint32_t len);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+static const char digitPairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+// Write the decimal value at p, return the end
+static char *writer_put_u32(char *p, uint32_t value)
+{
+    char *end;
+
+    if (value < 10) {
+        *p = (char)('0' + value);
+        return p + 1;
+    }
+    end = p + ((value < 100) ? 2 : (value < 1000) ? 3 : (value < 10000) ? 4 : (value < 100000) ? 5 :
+               (value < 1000000) ? 6 : (value < 10000000) ? 7 : (value < 100000000) ? 8 : (value < 1000000000) ? 9 : 10);
+    p = end;
+    while (value >= 100) {
+        uint32_t pair = value % 100;
+        value /= 100;
+        p -= 2;
+        memcpy(p, &digitPairs[2 * pair], 2);
+    }
+    if (value >= 10) {
+        memcpy(p - 2, &digitPairs[2 * value], 2);
+    } else {
+        *(p - 1) = (char)('0' + value);
+    }
+    return end;
+}
+
+//****************************************************************************
+static char *writer_put_tempe(char *p, const uncompress_writer_config_t *p_config, int16_t tempe)
+{
+    uint32_t value;
+
+    if (p_config->emptyInvalid && !IS_VALID_TEMPE(tempe)) {
+        return p;
+    }
+    if (tempe < 0) {
+        *p++ = '-';
+        value = (uint32_t)(-(int32_t)tempe);
+    } else {
+        value = (uint32_t)tempe;
+    }
+    if (!p_config->celsius) {
+        return writer_put_u32(p, value);
+    }
+    // fixed point, 1/100 degree
+    p = writer_put_u32(p, value / 100);
+    *p++ = '.';
+    memcpy(p, &digitPairs[2 * (value % 100)], 2);
+    return p + 2;
+}
+
+//****************************************************************************
+static uint8_t writer_flush_buffer(uncompress_writer_t *p_writer)
+{
+    if (!p_writer->flush) {
+        p_writer->error = 1;
+        return 0;
+    }
+    if (p_writer->len) {
+        if (!(*p_writer->flush)(p_writer->p_user, p_writer->buffer, p_writer->len)) {
+            NRF_LOG_ERROR("writer: flush of %u bytes failed", p_writer->len);
+            p_writer->error = 1;
+        } else {
+            p_writer->nbBytes += p_writer->len;
+        }
+        p_writer->len = 0;
+    }
+    return !p_writer->error;
+}
+
+//****************************************************************************
+static uint8_t writer_file_flush(void *p_user, const uint8_t *data, uint32_t len)
+{
+    return fwrite(data, 1, len, (FILE *)p_user) == len;
+}
+
+//****************************************************************************
+void lib_uncompress_writer_config_default(uncompress_writer_config_t *p_config)
+{
+    ASSERT(p_config);
+    p_config->format = UNCOMPRESS_WRITER_CSV;
+    p_config->fieldSeparator = ';';
+    p_config->lineSeparator = '\n';
+    p_config->celsius = 0;
+    p_config->emptyInvalid = 0;
+}
+
+//****************************************************************************
+void lib_uncompress_writer_init(uncompress_writer_t *p_writer, uint8_t *buffer, uint32_t size,
+                                uncompress_writer_flush_t flush, void *p_user, const uncompress_writer_config_t *p_config)
+{
+    ASSERT(p_writer);
+    ASSERT(buffer);
+    ASSERT(size >= UNCOMPRESS_WRITER_MAX_RECORD_LEN);
+    memset(p_writer, 0, sizeof(uncompress_writer_t));
+    if (p_config) {
+        p_writer->config = *p_config;
+    } else {
+        lib_uncompress_writer_config_default(&p_writer->config);
+    }
+    p_writer->buffer = buffer;
+    p_writer->size = size;
+    p_writer->flush = flush;
+    p_writer->p_user = p_user;
+}
+
+//****************************************************************************
+uncompress_writer_t *lib_uncompress_writer_open(const char *path, uint8_t append, const uncompress_writer_config_t *p_config)
+{
+    uncompress_writer_t *p_writer;
+    uint8_t *buffer;
+    FILE *p_file;
+
+    ASSERT(path);
+    p_file = fopen(path, append ? "ab" : "wb");
+    if (!p_file) {
+        NRF_LOG_ERROR("writer: cannot open %s", path);
+        return NULL;
+    }
+    // the writer buffer is enough, do not copy the data again in the FILE buffer
+    setvbuf(p_file, NULL, _IONBF, 0);
+    p_writer = malloc(sizeof(uncompress_writer_t));
+    buffer = malloc(UNCOMPRESS_WRITER_FILE_BUFFER_SIZE);
+    if (!p_writer || !buffer) {
+        free(p_writer);
+        free(buffer);
+        fclose(p_file);
+        return NULL;
+    }
+    lib_uncompress_writer_init(p_writer, buffer, UNCOMPRESS_WRITER_FILE_BUFFER_SIZE, writer_file_flush, p_file, p_config);
+    p_writer->p_file = p_file;
+    return p_writer;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_writer_add_one(uncompress_writer_t *p_writer, const record_t *p_record)
+{
+    char *p;
+
+    if ((p_writer->size - p_writer->len < UNCOMPRESS_WRITER_MAX_RECORD_LEN) && !writer_flush_buffer(p_writer)) {
+        return 0;
+    }
+    p = (char *)p_writer->buffer + p_writer->len;
+    if (p_writer->config.format == UNCOMPRESS_WRITER_BINARY) {
+        uint16_t tempe = (uint16_t)p_record->tempe;
+        p[0] = (char)(uint8_t)p_record->time;
+        p[1] = (char)(uint8_t)(p_record->time >> 8);
+        p[2] = (char)(uint8_t)(p_record->time >> 16);
+        p[3] = (char)(uint8_t)(p_record->time >> 24);
+        p[4] = (char)(uint8_t)tempe;
+        p[5] = (char)(uint8_t)(tempe >> 8);
+        p += WRITER_BINARY_RECORD_LEN;
+    } else {
+        if (!p_writer->config.emptyInvalid || (p_record->time != UNCOMPRESS_INVALID_TIME)) {
+            p = writer_put_u32(p, p_record->time);
+        }
+        *p++ = p_writer->config.fieldSeparator;
+        p = writer_put_tempe(p, &p_writer->config, p_record->tempe);
+        *p++ = p_writer->config.lineSeparator;
+    }
+    p_writer->len = (uint32_t)(p - (char *)p_writer->buffer);
+    p_writer->nbRecords++;
+    return 1;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_writer_add(uncompress_writer_t *p_writer, const record_t *records, uint32_t nbRecords)
+{
+    ASSERT(p_writer);
+    ASSERT(records || !nbRecords);
+    for (uint32_t i = 0; i < nbRecords; i++) {
+        if (!lib_uncompress_writer_add_one(p_writer, &records[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_writer_flush(uncompress_writer_t *p_writer)
+{
+    ASSERT(p_writer);
+    if (!p_writer->len || !p_writer->flush) {
+        return !p_writer->error;
+    }
+    return writer_flush_buffer(p_writer);
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_writer_close(uncompress_writer_t *p_writer)
+{
+    uint8_t ret;
+
+    if (!p_writer) {
+        return 0;
+    }
+    ret = lib_uncompress_writer_flush(p_writer);
+    if (p_writer->p_file) {
+        if (fclose((FILE *)p_writer->p_file)) {
+            ret = 0;
+        }
+        free(p_writer->buffer);
+        free(p_writer);
+    }
+    return ret;
+}
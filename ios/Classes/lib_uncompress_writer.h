@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_writer.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Export of uncompressed samples to CSV or binary, in large writes.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_WRITER_H
+#define _LIB_UNCOMPRESS_WRITER_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_WRITER_CSV               0   // "time;temperature\n", as written by the application
+#define UNCOMPRESS_WRITER_BINARY            1   // uint32_t time, int16_t temperature, little endian
+
+#define UNCOMPRESS_WRITER_MAX_RECORD_LEN    24          // max bytes written for one record
+#define UNCOMPRESS_WRITER_FILE_BUFFER_SIZE  (256 * 1024)
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+
+/**
+ * Called when the buffer is full and by lib_uncompress_writer_flush.
+ * \retval 1 if the len bytes were written, 0 on error.
+ */
+typedef uint8_t (*uncompress_writer_flush_t)(void *p_user, const uint8_t *data, uint32_t len);
+
+typedef struct {
+    uint8_t     format;             // UNCOMPRESS_WRITER_CSV or UNCOMPRESS_WRITER_BINARY
+    char        fieldSeparator;     // CSV: between time and temperature
+    char        lineSeparator;      // CSV: after each record
+    uint8_t     celsius;            // CSV: temperature in degrees with 2 decimals, instead of 1/100 degree
+    uint8_t     emptyInvalid;       // CSV: empty field for invalid times and invalid or unreceived temperatures
+} uncompress_writer_config_t;
+
+typedef struct {
+    uncompress_writer_config_t config;
+    uint8_t     *buffer;
+    uint32_t    size;               // bytes allocated in buffer
+    uint32_t    len;                // bytes waiting in buffer
+    uncompress_writer_flush_t flush;
+    void        *p_user;
+    void        *p_file;            // FILE opened by lib_uncompress_writer_open, NULL otherwise
+    uint64_t    nbRecords;          // records written
+    uint64_t    nbBytes;            // bytes given to flush
+    uint8_t     error;              // a flush failed, or the buffer was full without flush
+} uncompress_writer_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Fill a writer config with the default values: CSV as written by the application.
+ * \param[out] p_config the config.
+ */
+void lib_uncompress_writer_config_default(uncompress_writer_config_t *p_config);
+
+//****************************************************************************
+/**
+ * \brief Initialize a writer in a buffer allocated by caller.
+ * \param[out] p_writer the writer.
+ * \param[in] buffer where the records are formatted, at least UNCOMPRESS_WRITER_MAX_RECORD_LEN bytes.
+ * \param[in] size size of buffer.
+ * \param[in] flush called with the content of the buffer when it is full, NULL to stop writing instead
+ *            (the formatted records are then read in buffer/len).
+ * \param[in] p_user given to flush.
+ * \param[in] p_config the config, copied, NULL for the default.
+ */
+void lib_uncompress_writer_init(uncompress_writer_t *p_writer, uint8_t *buffer, uint32_t size,
+                                uncompress_writer_flush_t flush, void *p_user, const uncompress_writer_config_t *p_config);
+
+//****************************************************************************
+/**
+ * \brief Create a writer to a file, with a buffer of UNCOMPRESS_WRITER_FILE_BUFFER_SIZE.
+ * \param[in] path the file.
+ * \param[in] append 1 to write at the end of the file, 0 to truncate it.
+ * \param[in] p_config the config, copied, NULL for the default.
+ * \retval the writer, to be closed by lib_uncompress_writer_close, NULL on error.
+ */
+uncompress_writer_t *lib_uncompress_writer_open(const char *path, uint8_t append, const uncompress_writer_config_t *p_config);
+
+//****************************************************************************
+/**
+ * \brief Format records.
+ * \param[in] p_writer the writer.
+ * \param[in] records the records.
+ * \param[in] nbRecords number of records.
+ * \retval 1 on success, 0 on error (see error).
+ */
+uint8_t lib_uncompress_writer_add(uncompress_writer_t *p_writer, const record_t *records, uint32_t nbRecords);
+
+//****************************************************************************
+/**
+ * \brief Give the records waiting in the buffer to flush.
+ * \param[in] p_writer the writer.
+ * \retval 1 on success, 0 if an error occurred since the writer was created.
+ */
+uint8_t lib_uncompress_writer_flush(uncompress_writer_t *p_writer);
+
+//****************************************************************************
+/**
+ * \brief Flush a writer, and free it if it was created by lib_uncompress_writer_open.
+ * \param[in] p_writer the writer, may be NULL.
+ * \retval 1 on success, 0 if an error occurred since the writer was created.
+ */
+uint8_t lib_uncompress_writer_close(uncompress_writer_t *p_writer);
+
+//****************************************************************************
+/**
+ * \brief Format one record, used by the decoder to write the samples as they are decoded.
+ * \param[in] p_writer the writer.
+ * \param[in] p_record the record.
+ * \retval 1 on success, 0 on error.
+ */
+uint8_t lib_uncompress_writer_add_one(uncompress_writer_t *p_writer, const record_t *p_record);
+
+#endif // _LIB_UNCOMPRESS_WRITER_H
@@ -65,6 +65,812 @@ class UncompressBinding {
 
   _dart_lib_uncompress_data? _lib_uncompress_data;
 
+  // void lib_uncompress_stats_compute(const record_t *records, uint32_t nbRecords, uncompress_stats_t *p_stats, uint32_t *validMask);
+
+  void lib_uncompress_stats_compute(
+      ffi.Pointer<record_t> records,
+      int nbRecords,
+      ffi.Pointer<uncompress_stats_t> p_stats,
+      ffi.Pointer<ffi.Uint32> validMask,
+      ) {
+    return (_lib_uncompress_stats_compute ??= _dylib.lookupFunction<
+        _c_lib_uncompress_stats_compute,
+        _dart_lib_uncompress_stats_compute>('lib_uncompress_stats_compute'))(
+      records,
+      nbRecords,
+      p_stats,
+      validMask,
+    );
+  }
+
+  _dart_lib_uncompress_stats_compute? _lib_uncompress_stats_compute;
+
+  // void lib_uncompress_stats_compute_samples(const samples_t *p_samples, uncompress_stats_t *p_stats, uint32_t *validMask);
+
+  void lib_uncompress_stats_compute_samples(
+      ffi.Pointer<samples_t> p_samples,
+      ffi.Pointer<uncompress_stats_t> p_stats,
+      ffi.Pointer<ffi.Uint32> validMask,
+      ) {
+    return (_lib_uncompress_stats_compute_samples ??= _dylib.lookupFunction<
+        _c_lib_uncompress_stats_compute_samples,
+        _dart_lib_uncompress_stats_compute_samples>('lib_uncompress_stats_compute_samples'))(
+      p_samples,
+      p_stats,
+      validMask,
+    );
+  }
+
+  _dart_lib_uncompress_stats_compute_samples? _lib_uncompress_stats_compute_samples;
+
+  // void lib_uncompress_get_state(uncompress_state_t *p_state);
+
+  void lib_uncompress_get_state(
+      ffi.Pointer<uncompress_state_t> p_state,
+      ) {
+    return (_lib_uncompress_get_state ??= _dylib.lookupFunction<
+        _c_lib_uncompress_get_state,
+        _dart_lib_uncompress_get_state>('lib_uncompress_get_state'))(
+      p_state,
+    );
+  }
+
+  _dart_lib_uncompress_get_state? _lib_uncompress_get_state;
+
+  // void lib_uncompress_aggregate_init(uncompress_aggregate_t *p_agg, uncompress_bucket_t *buckets, uint32_t nbBuckets, uint32_t origin, uint32_t width);
+
+  void lib_uncompress_aggregate_init(
+      ffi.Pointer<uncompress_aggregate_t> p_agg,
+      ffi.Pointer<uncompress_bucket_t> buckets,
+      int nbBuckets,
+      int origin,
+      int width,
+      ) {
+    return (_lib_uncompress_aggregate_init ??= _dylib.lookupFunction<
+        _c_lib_uncompress_aggregate_init,
+        _dart_lib_uncompress_aggregate_init>('lib_uncompress_aggregate_init'))(
+      p_agg,
+      buckets,
+      nbBuckets,
+      origin,
+      width,
+    );
+  }
+
+  _dart_lib_uncompress_aggregate_init? _lib_uncompress_aggregate_init;
+
+  // uint32_t lib_uncompress_aggregate_width_from_periods(uint16_t period, uint32_t nbPeriods);
+
+  int lib_uncompress_aggregate_width_from_periods(
+      int period,
+      int nbPeriods,
+      ) {
+    return (_lib_uncompress_aggregate_width_from_periods ??= _dylib.lookupFunction<
+        _c_lib_uncompress_aggregate_width_from_periods,
+        _dart_lib_uncompress_aggregate_width_from_periods>('lib_uncompress_aggregate_width_from_periods'))(
+      period,
+      nbPeriods,
+    );
+  }
+
+  _dart_lib_uncompress_aggregate_width_from_periods? _lib_uncompress_aggregate_width_from_periods;
+
+  // void lib_uncompress_aggregate_add(uncompress_aggregate_t *p_agg, const record_t *records, uint32_t nbRecords, const uncompress_period_t *periods, uint16_t nbPeriods);
+
+  void lib_uncompress_aggregate_add(
+      ffi.Pointer<uncompress_aggregate_t> p_agg,
+      ffi.Pointer<record_t> records,
+      int nbRecords,
+      ffi.Pointer<uncompress_period_t> periods,
+      int nbPeriods,
+      ) {
+    return (_lib_uncompress_aggregate_add ??= _dylib.lookupFunction<
+        _c_lib_uncompress_aggregate_add,
+        _dart_lib_uncompress_aggregate_add>('lib_uncompress_aggregate_add'))(
+      p_agg,
+      records,
+      nbRecords,
+      periods,
+      nbPeriods,
+    );
+  }
+
+  _dart_lib_uncompress_aggregate_add? _lib_uncompress_aggregate_add;
+
+  // void lib_uncompress_aggregate_add_samples(uncompress_aggregate_t *p_agg, const samples_t *p_samples);
+
+  void lib_uncompress_aggregate_add_samples(
+      ffi.Pointer<uncompress_aggregate_t> p_agg,
+      ffi.Pointer<samples_t> p_samples,
+      ) {
+    return (_lib_uncompress_aggregate_add_samples ??= _dylib.lookupFunction<
+        _c_lib_uncompress_aggregate_add_samples,
+        _dart_lib_uncompress_aggregate_add_samples>('lib_uncompress_aggregate_add_samples'))(
+      p_agg,
+      p_samples,
+    );
+  }
+
+  _dart_lib_uncompress_aggregate_add_samples? _lib_uncompress_aggregate_add_samples;
+
+  // void lib_uncompress_aggregate_finish(uncompress_aggregate_t *p_agg);
+
+  void lib_uncompress_aggregate_finish(
+      ffi.Pointer<uncompress_aggregate_t> p_agg,
+      ) {
+    return (_lib_uncompress_aggregate_finish ??= _dylib.lookupFunction<
+        _c_lib_uncompress_aggregate_finish,
+        _dart_lib_uncompress_aggregate_finish>('lib_uncompress_aggregate_finish'))(
+      p_agg,
+    );
+  }
+
+  _dart_lib_uncompress_aggregate_finish? _lib_uncompress_aggregate_finish;
+
+  // uint32_t lib_uncompress_downsample_m4(const record_t *records, uint32_t nbRecords, uint32_t nbPixels, record_t *output);
+
+  int lib_uncompress_downsample_m4(
+      ffi.Pointer<record_t> records,
+      int nbRecords,
+      int nbPixels,
+      ffi.Pointer<record_t> output,
+      ) {
+    return (_lib_uncompress_downsample_m4 ??= _dylib.lookupFunction<
+        _c_lib_uncompress_downsample_m4,
+        _dart_lib_uncompress_downsample_m4>('lib_uncompress_downsample_m4'))(
+      records,
+      nbRecords,
+      nbPixels,
+      output,
+    );
+  }
+
+  _dart_lib_uncompress_downsample_m4? _lib_uncompress_downsample_m4;
+
+  // uncompress_m4_t *lib_uncompress_m4_create(void);
+
+  ffi.Pointer<uncompress_m4_t> lib_uncompress_m4_create() {
+    return (_lib_uncompress_m4_create ??= _dylib.lookupFunction<
+        _c_lib_uncompress_m4_create,
+        _dart_lib_uncompress_m4_create>('lib_uncompress_m4_create'))();
+  }
+
+  _dart_lib_uncompress_m4_create? _lib_uncompress_m4_create;
+
+  // void lib_uncompress_m4_free(uncompress_m4_t *p_m4);
+
+  void lib_uncompress_m4_free(
+      ffi.Pointer<uncompress_m4_t> p_m4,
+      ) {
+    return (_lib_uncompress_m4_free ??= _dylib.lookupFunction<
+        _c_lib_uncompress_m4_free,
+        _dart_lib_uncompress_m4_free>('lib_uncompress_m4_free'))(
+      p_m4,
+    );
+  }
+
+  _dart_lib_uncompress_m4_free? _lib_uncompress_m4_free;
+
+  // uint8_t lib_uncompress_m4_add_samples(uncompress_m4_t *p_m4, const samples_t *p_samples);
+
+  int lib_uncompress_m4_add_samples(
+      ffi.Pointer<uncompress_m4_t> p_m4,
+      ffi.Pointer<samples_t> p_samples,
+      ) {
+    return (_lib_uncompress_m4_add_samples ??= _dylib.lookupFunction<
+        _c_lib_uncompress_m4_add_samples,
+        _dart_lib_uncompress_m4_add_samples>('lib_uncompress_m4_add_samples'))(
+      p_m4,
+      p_samples,
+    );
+  }
+
+  _dart_lib_uncompress_m4_add_samples? _lib_uncompress_m4_add_samples;
+
+  // uint32_t lib_uncompress_m4_finish(const uncompress_m4_t *p_m4, uint32_t nbPixels, record_t *output);
+
+  int lib_uncompress_m4_finish(
+      ffi.Pointer<uncompress_m4_t> p_m4,
+      int nbPixels,
+      ffi.Pointer<record_t> output,
+      ) {
+    return (_lib_uncompress_m4_finish ??= _dylib.lookupFunction<
+        _c_lib_uncompress_m4_finish,
+        _dart_lib_uncompress_m4_finish>('lib_uncompress_m4_finish'))(
+      p_m4,
+      nbPixels,
+      output,
+    );
+  }
+
+  _dart_lib_uncompress_m4_finish? _lib_uncompress_m4_finish;
+
+  // void lib_uncompress_set_state(const uncompress_state_t *p_state);
+
+  void lib_uncompress_set_state(
+      ffi.Pointer<uncompress_state_t> p_state,
+      ) {
+    return (_lib_uncompress_set_state ??= _dylib.lookupFunction<
+        _c_lib_uncompress_set_state,
+        _dart_lib_uncompress_set_state>('lib_uncompress_set_state'))(
+      p_state,
+    );
+  }
+
+  _dart_lib_uncompress_set_state? _lib_uncompress_set_state;
+
+  // uncompress_cache_t *lib_uncompress_cache_open(const char *path, uint32_t maxBytes);
+
+  ffi.Pointer<uncompress_cache_t> lib_uncompress_cache_open(
+      ffi.Pointer<ffi.Int8> path,
+      int maxBytes,
+      ) {
+    return (_lib_uncompress_cache_open ??= _dylib.lookupFunction<
+        _c_lib_uncompress_cache_open,
+        _dart_lib_uncompress_cache_open>('lib_uncompress_cache_open'))(
+      path,
+      maxBytes,
+    );
+  }
+
+  _dart_lib_uncompress_cache_open? _lib_uncompress_cache_open;
+
+  // void lib_uncompress_cache_close(uncompress_cache_t *p_cache);
+
+  void lib_uncompress_cache_close(
+      ffi.Pointer<uncompress_cache_t> p_cache,
+      ) {
+    return (_lib_uncompress_cache_close ??= _dylib.lookupFunction<
+        _c_lib_uncompress_cache_close,
+        _dart_lib_uncompress_cache_close>('lib_uncompress_cache_close'))(
+      p_cache,
+    );
+  }
+
+  _dart_lib_uncompress_cache_close? _lib_uncompress_cache_close;
+
+  // uint8_t lib_uncompress_cache_uncompress_data(uncompress_cache_t *p_cache, uint8_t *buffer, uint8_t len, samples_t *p_samples);
+
+  int lib_uncompress_cache_uncompress_data(
+      ffi.Pointer<uncompress_cache_t> p_cache,
+      ffi.Pointer<ffi.Uint8> buffer,
+      int len,
+      ffi.Pointer<samples_t> p_samples,
+      ) {
+    return (_lib_uncompress_cache_uncompress_data ??= _dylib.lookupFunction<
+        _c_lib_uncompress_cache_uncompress_data,
+        _dart_lib_uncompress_cache_uncompress_data>('lib_uncompress_cache_uncompress_data'))(
+      p_cache,
+      buffer,
+      len,
+      p_samples,
+    );
+  }
+
+  _dart_lib_uncompress_cache_uncompress_data? _lib_uncompress_cache_uncompress_data;
+
+  // void lib_uncompress_cache_get_stats(uncompress_cache_t *p_cache, uncompress_cache_stats_t *p_stats);
+
+  void lib_uncompress_cache_get_stats(
+      ffi.Pointer<uncompress_cache_t> p_cache,
+      ffi.Pointer<uncompress_cache_stats_t> p_stats,
+      ) {
+    return (_lib_uncompress_cache_get_stats ??= _dylib.lookupFunction<
+        _c_lib_uncompress_cache_get_stats,
+        _dart_lib_uncompress_cache_get_stats>('lib_uncompress_cache_get_stats'))(
+      p_cache,
+      p_stats,
+    );
+  }
+
+  _dart_lib_uncompress_cache_get_stats? _lib_uncompress_cache_get_stats;
+
+  // uncompress_session_t *lib_uncompress_session_create(uint16_t nbCachedFrames);
+
+  ffi.Pointer<uncompress_session_t> lib_uncompress_session_create(
+      int nbCachedFrames,
+      ) {
+    return (_lib_uncompress_session_create ??= _dylib.lookupFunction<
+        _c_lib_uncompress_session_create,
+        _dart_lib_uncompress_session_create>('lib_uncompress_session_create'))(
+      nbCachedFrames,
+    );
+  }
+
+  _dart_lib_uncompress_session_create? _lib_uncompress_session_create;
+
+  // void lib_uncompress_session_free(uncompress_session_t *p_session);
+
+  void lib_uncompress_session_free(
+      ffi.Pointer<uncompress_session_t> p_session,
+      ) {
+    return (_lib_uncompress_session_free ??= _dylib.lookupFunction<
+        _c_lib_uncompress_session_free,
+        _dart_lib_uncompress_session_free>('lib_uncompress_session_free'))(
+      p_session,
+    );
+  }
+
+  _dart_lib_uncompress_session_free? _lib_uncompress_session_free;
+
+  // uint8_t lib_uncompress_session_append(uncompress_session_t *p_session, const uint8_t *buffer, uint8_t len);
+
+  int lib_uncompress_session_append(
+      ffi.Pointer<uncompress_session_t> p_session,
+      ffi.Pointer<ffi.Uint8> buffer,
+      int len,
+      ) {
+    return (_lib_uncompress_session_append ??= _dylib.lookupFunction<
+        _c_lib_uncompress_session_append,
+        _dart_lib_uncompress_session_append>('lib_uncompress_session_append'))(
+      p_session,
+      buffer,
+      len,
+    );
+  }
+
+  _dart_lib_uncompress_session_append? _lib_uncompress_session_append;
+
+  // uint32_t lib_uncompress_session_get_nb_samples(uncompress_session_t *p_session);
+
+  int lib_uncompress_session_get_nb_samples(
+      ffi.Pointer<uncompress_session_t> p_session,
+      ) {
+    return (_lib_uncompress_session_get_nb_samples ??= _dylib.lookupFunction<
+        _c_lib_uncompress_session_get_nb_samples,
+        _dart_lib_uncompress_session_get_nb_samples>('lib_uncompress_session_get_nb_samples'))(
+      p_session,
+    );
+  }
+
+  _dart_lib_uncompress_session_get_nb_samples? _lib_uncompress_session_get_nb_samples;
+
+  // uint32_t lib_uncompress_session_get_samples(uncompress_session_t *p_session, uint32_t first, uint32_t nb, record_t *output);
+
+  int lib_uncompress_session_get_samples(
+      ffi.Pointer<uncompress_session_t> p_session,
+      int first,
+      int nb,
+      ffi.Pointer<record_t> output,
+      ) {
+    return (_lib_uncompress_session_get_samples ??= _dylib.lookupFunction<
+        _c_lib_uncompress_session_get_samples,
+        _dart_lib_uncompress_session_get_samples>('lib_uncompress_session_get_samples'))(
+      p_session,
+      first,
+      nb,
+      output,
+    );
+  }
+
+  _dart_lib_uncompress_session_get_samples? _lib_uncompress_session_get_samples;
+
+  // uint32_t lib_uncompress_session_find_time(uncompress_session_t *p_session, uint32_t time);
+
+  int lib_uncompress_session_find_time(
+      ffi.Pointer<uncompress_session_t> p_session,
+      int time,
+      ) {
+    return (_lib_uncompress_session_find_time ??= _dylib.lookupFunction<
+        _c_lib_uncompress_session_find_time,
+        _dart_lib_uncompress_session_find_time>('lib_uncompress_session_find_time'))(
+      p_session,
+      time,
+    );
+  }
+
+  _dart_lib_uncompress_session_find_time? _lib_uncompress_session_find_time;
+
+  // void lib_uncompress_state_init(uncompress_state_t *p_state);
+
+  void lib_uncompress_state_init(
+      ffi.Pointer<uncompress_state_t> p_state,
+      ) {
+    return (_lib_uncompress_state_init ??= _dylib.lookupFunction<
+        _c_lib_uncompress_state_init,
+        _dart_lib_uncompress_state_init>('lib_uncompress_state_init'))(
+      p_state,
+    );
+  }
+
+  _dart_lib_uncompress_state_init? _lib_uncompress_state_init;
+
+  // void lib_uncompress_state_new_frame(uncompress_state_t *p_state);
+
+  void lib_uncompress_state_new_frame(
+      ffi.Pointer<uncompress_state_t> p_state,
+      ) {
+    return (_lib_uncompress_state_new_frame ??= _dylib.lookupFunction<
+        _c_lib_uncompress_state_new_frame,
+        _dart_lib_uncompress_state_new_frame>('lib_uncompress_state_new_frame'))(
+      p_state,
+    );
+  }
+
+  _dart_lib_uncompress_state_new_frame? _lib_uncompress_state_new_frame;
+
+  // uint8_t lib_uncompress_state_save(const uncompress_state_t *p_state, uint8_t *blob, uint8_t size);
+
+  int lib_uncompress_state_save(
+      ffi.Pointer<uncompress_state_t> p_state,
+      ffi.Pointer<ffi.Uint8> blob,
+      int size,
+      ) {
+    return (_lib_uncompress_state_save ??= _dylib.lookupFunction<
+        _c_lib_uncompress_state_save,
+        _dart_lib_uncompress_state_save>('lib_uncompress_state_save'))(
+      p_state,
+      blob,
+      size,
+    );
+  }
+
+  _dart_lib_uncompress_state_save? _lib_uncompress_state_save;
+
+  // uint8_t lib_uncompress_state_restore(uncompress_state_t *p_state, const uint8_t *blob, uint8_t len);
+
+  int lib_uncompress_state_restore(
+      ffi.Pointer<uncompress_state_t> p_state,
+      ffi.Pointer<ffi.Uint8> blob,
+      int len,
+      ) {
+    return (_lib_uncompress_state_restore ??= _dylib.lookupFunction<
+        _c_lib_uncompress_state_restore,
+        _dart_lib_uncompress_state_restore>('lib_uncompress_state_restore'))(
+      p_state,
+      blob,
+      len,
+    );
+  }
+
+  _dart_lib_uncompress_state_restore? _lib_uncompress_state_restore;
+
+  // uint8_t lib_uncompress_data_with_state(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state);
+
+  int lib_uncompress_data_with_state(
+      ffi.Pointer<ffi.Uint8> buffer,
+      int len,
+      ffi.Pointer<samples_t> p_samples,
+      ffi.Pointer<uncompress_state_t> p_state,
+      ) {
+    return (_lib_uncompress_data_with_state ??= _dylib.lookupFunction<
+        _c_lib_uncompress_data_with_state,
+        _dart_lib_uncompress_data_with_state>('lib_uncompress_data_with_state'))(
+      buffer,
+      len,
+      p_samples,
+      p_state,
+    );
+  }
+
+  _dart_lib_uncompress_data_with_state? _lib_uncompress_data_with_state;
+
+  // uint8_t lib_uncompress_cache_uncompress_data_with_state(uncompress_cache_t *p_cache, uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state);
+
+  int lib_uncompress_cache_uncompress_data_with_state(
+      ffi.Pointer<uncompress_cache_t> p_cache,
+      ffi.Pointer<ffi.Uint8> buffer,
+      int len,
+      ffi.Pointer<samples_t> p_samples,
+      ffi.Pointer<uncompress_state_t> p_state,
+      ) {
+    return (_lib_uncompress_cache_uncompress_data_with_state ??= _dylib.lookupFunction<
+        _c_lib_uncompress_cache_uncompress_data_with_state,
+        _dart_lib_uncompress_cache_uncompress_data_with_state>('lib_uncompress_cache_uncompress_data_with_state'))(
+      p_cache,
+      buffer,
+      len,
+      p_samples,
+      p_state,
+    );
+  }
+
+  _dart_lib_uncompress_cache_uncompress_data_with_state? _lib_uncompress_cache_uncompress_data_with_state;
+
+  // void lib_uncompress_resync_config_default(uncompress_resync_config_t *p_config);
+
+  void lib_uncompress_resync_config_default(
+      ffi.Pointer<uncompress_resync_config_t> p_config,
+      ) {
+    return (_lib_uncompress_resync_config_default ??= _dylib.lookupFunction<
+        _c_lib_uncompress_resync_config_default,
+        _dart_lib_uncompress_resync_config_default>('lib_uncompress_resync_config_default'))(
+      p_config,
+    );
+  }
+
+  _dart_lib_uncompress_resync_config_default? _lib_uncompress_resync_config_default;
+
+  // uint8_t lib_uncompress_data_resync(uint8_t *buffer, uint8_t len, samples_t *p_samples, uncompress_state_t *p_state, const uncompress_resync_config_t *p_config, uncompress_resync_report_t *p_report);
+
+  int lib_uncompress_data_resync(
+      ffi.Pointer<ffi.Uint8> buffer,
+      int len,
+      ffi.Pointer<samples_t> p_samples,
+      ffi.Pointer<uncompress_state_t> p_state,
+      ffi.Pointer<uncompress_resync_config_t> p_config,
+      ffi.Pointer<uncompress_resync_report_t> p_report,
+      ) {
+    return (_lib_uncompress_data_resync ??= _dylib.lookupFunction<
+        _c_lib_uncompress_data_resync,
+        _dart_lib_uncompress_data_resync>('lib_uncompress_data_resync'))(
+      buffer,
+      len,
+      p_samples,
+      p_state,
+      p_config,
+      p_report,
+    );
+  }
+
+  _dart_lib_uncompress_data_resync? _lib_uncompress_data_resync;
+
+  // uint32_t lib_uncompress_archive_max_size(uint32_t nbRecords);
+
+  int lib_uncompress_archive_max_size(
+      int nbRecords,
+      ) {
+    return (_lib_uncompress_archive_max_size ??= _dylib.lookupFunction<
+        _c_lib_uncompress_archive_max_size,
+        _dart_lib_uncompress_archive_max_size>('lib_uncompress_archive_max_size'))(
+      nbRecords,
+    );
+  }
+
+  _dart_lib_uncompress_archive_max_size? _lib_uncompress_archive_max_size;
+
+  // uint32_t lib_uncompress_archive_encode(const record_t *records, uint32_t nbRecords, uint8_t *output, uint32_t size);
+
+  int lib_uncompress_archive_encode(
+      ffi.Pointer<record_t> records,
+      int nbRecords,
+      ffi.Pointer<ffi.Uint8> output,
+      int size,
+      ) {
+    return (_lib_uncompress_archive_encode ??= _dylib.lookupFunction<
+        _c_lib_uncompress_archive_encode,
+        _dart_lib_uncompress_archive_encode>('lib_uncompress_archive_encode'))(
+      records,
+      nbRecords,
+      output,
+      size,
+    );
+  }
+
+  _dart_lib_uncompress_archive_encode? _lib_uncompress_archive_encode;
+
+  // uint8_t lib_uncompress_archive_get_nb_records(const uint8_t *archive, uint32_t len, uint32_t *p_nbRecords);
+
+  int lib_uncompress_archive_get_nb_records(
+      ffi.Pointer<ffi.Uint8> archive,
+      int len,
+      ffi.Pointer<ffi.Uint32> p_nbRecords,
+      ) {
+    return (_lib_uncompress_archive_get_nb_records ??= _dylib.lookupFunction<
+        _c_lib_uncompress_archive_get_nb_records,
+        _dart_lib_uncompress_archive_get_nb_records>('lib_uncompress_archive_get_nb_records'))(
+      archive,
+      len,
+      p_nbRecords,
+    );
+  }
+
+  _dart_lib_uncompress_archive_get_nb_records? _lib_uncompress_archive_get_nb_records;
+
+  // uint8_t lib_uncompress_archive_decode(const uint8_t *archive, uint32_t len, record_t *records, uint32_t maxRecords);
+
+  int lib_uncompress_archive_decode(
+      ffi.Pointer<ffi.Uint8> archive,
+      int len,
+      ffi.Pointer<record_t> records,
+      int maxRecords,
+      ) {
+    return (_lib_uncompress_archive_decode ??= _dylib.lookupFunction<
+        _c_lib_uncompress_archive_decode,
+        _dart_lib_uncompress_archive_decode>('lib_uncompress_archive_decode'))(
+      archive,
+      len,
+      records,
+      maxRecords,
+    );
+  }
+
+  _dart_lib_uncompress_archive_decode? _lib_uncompress_archive_decode;
+
+  // uint8_t lib_uncompress_data_to_writer(uint8_t *buffer, uint8_t len, uncompress_state_t *p_state, uncompress_writer_t *p_writer);
+
+  int lib_uncompress_data_to_writer(
+      ffi.Pointer<ffi.Uint8> buffer,
+      int len,
+      ffi.Pointer<uncompress_state_t> p_state,
+      ffi.Pointer<uncompress_writer_t> p_writer,
+      ) {
+    return (_lib_uncompress_data_to_writer ??= _dylib.lookupFunction<
+        _c_lib_uncompress_data_to_writer,
+        _dart_lib_uncompress_data_to_writer>('lib_uncompress_data_to_writer'))(
+      buffer,
+      len,
+      p_state,
+      p_writer,
+    );
+  }
+
+  _dart_lib_uncompress_data_to_writer? _lib_uncompress_data_to_writer;
+
+  // void lib_uncompress_writer_config_default(uncompress_writer_config_t *p_config);
+
+  void lib_uncompress_writer_config_default(
+      ffi.Pointer<uncompress_writer_config_t> p_config,
+      ) {
+    return (_lib_uncompress_writer_config_default ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_config_default,
+        _dart_lib_uncompress_writer_config_default>('lib_uncompress_writer_config_default'))(
+      p_config,
+    );
+  }
+
+  _dart_lib_uncompress_writer_config_default? _lib_uncompress_writer_config_default;
+
+  // void lib_uncompress_writer_init(uncompress_writer_t *p_writer, uint8_t *buffer, uint32_t size, uncompress_writer_flush_t flush, void *p_user, const uncompress_writer_config_t *p_config);
+
+  void lib_uncompress_writer_init(
+      ffi.Pointer<uncompress_writer_t> p_writer,
+      ffi.Pointer<ffi.Uint8> buffer,
+      int size,
+      ffi.Pointer<ffi.NativeFunction<_typedefC_1>> flush,
+      ffi.Pointer<ffi.Void> p_user,
+      ffi.Pointer<uncompress_writer_config_t> p_config,
+      ) {
+    return (_lib_uncompress_writer_init ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_init,
+        _dart_lib_uncompress_writer_init>('lib_uncompress_writer_init'))(
+      p_writer,
+      buffer,
+      size,
+      flush,
+      p_user,
+      p_config,
+    );
+  }
+
+  _dart_lib_uncompress_writer_init? _lib_uncompress_writer_init;
+
+  // uncompress_writer_t *lib_uncompress_writer_open(const char *path, uint8_t append, const uncompress_writer_config_t *p_config);
+
+  ffi.Pointer<uncompress_writer_t> lib_uncompress_writer_open(
+      ffi.Pointer<ffi.Int8> path,
+      int append,
+      ffi.Pointer<uncompress_writer_config_t> p_config,
+      ) {
+    return (_lib_uncompress_writer_open ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_open,
+        _dart_lib_uncompress_writer_open>('lib_uncompress_writer_open'))(
+      path,
+      append,
+      p_config,
+    );
+  }
+
+  _dart_lib_uncompress_writer_open? _lib_uncompress_writer_open;
+
+  // uint8_t lib_uncompress_writer_add(uncompress_writer_t *p_writer, const record_t *records, uint32_t nbRecords);
+
+  int lib_uncompress_writer_add(
+      ffi.Pointer<uncompress_writer_t> p_writer,
+      ffi.Pointer<record_t> records,
+      int nbRecords,
+      ) {
+    return (_lib_uncompress_writer_add ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_add,
+        _dart_lib_uncompress_writer_add>('lib_uncompress_writer_add'))(
+      p_writer,
+      records,
+      nbRecords,
+    );
+  }
+
+  _dart_lib_uncompress_writer_add? _lib_uncompress_writer_add;
+
+  // uint8_t lib_uncompress_writer_flush(uncompress_writer_t *p_writer);
+
+  int lib_uncompress_writer_flush(
+      ffi.Pointer<uncompress_writer_t> p_writer,
+      ) {
+    return (_lib_uncompress_writer_flush ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_flush,
+        _dart_lib_uncompress_writer_flush>('lib_uncompress_writer_flush'))(
+      p_writer,
+    );
+  }
+
+  _dart_lib_uncompress_writer_flush? _lib_uncompress_writer_flush;
+
+  // uint8_t lib_uncompress_writer_close(uncompress_writer_t *p_writer);
+
+  int lib_uncompress_writer_close(
+      ffi.Pointer<uncompress_writer_t> p_writer,
+      ) {
+    return (_lib_uncompress_writer_close ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_close,
+        _dart_lib_uncompress_writer_close>('lib_uncompress_writer_close'))(
+      p_writer,
+    );
+  }
+
+  _dart_lib_uncompress_writer_close? _lib_uncompress_writer_close;
+
+  // uint8_t lib_uncompress_writer_add_one(uncompress_writer_t *p_writer, const record_t *p_record);
+
+  int lib_uncompress_writer_add_one(
+      ffi.Pointer<uncompress_writer_t> p_writer,
+      ffi.Pointer<record_t> p_record,
+      ) {
+    return (_lib_uncompress_writer_add_one ??= _dylib.lookupFunction<
+        _c_lib_uncompress_writer_add_one,
+        _dart_lib_uncompress_writer_add_one>('lib_uncompress_writer_add_one'))(
+      p_writer,
+      p_record,
+    );
+  }
+
+  _dart_lib_uncompress_writer_add_one? _lib_uncompress_writer_add_one;
+
+  // void lib_uncompress_fill_init(uncompress_fill_t *p_fill);
+
+  void lib_uncompress_fill_init(
+      ffi.Pointer<uncompress_fill_t> p_fill,
+      ) {
+    return (_lib_uncompress_fill_init ??= _dylib.lookupFunction<
+        _c_lib_uncompress_fill_init,
+        _dart_lib_uncompress_fill_init>('lib_uncompress_fill_init'))(
+      p_fill,
+    );
+  }
+
+  _dart_lib_uncompress_fill_init? _lib_uncompress_fill_init;
+
+  // uint32_t lib_uncompress_fill_times(uncompress_fill_t *p_fill, record_t *records, uint32_t nbRecords, const uncompress_period_t *periods, uint16_t nbPeriods, uint32_t *interpolatedMask);
+
+  int lib_uncompress_fill_times(
+      ffi.Pointer<uncompress_fill_t> p_fill,
+      ffi.Pointer<record_t> records,
+      int nbRecords,
+      ffi.Pointer<uncompress_period_t> periods,
+      int nbPeriods,
+      ffi.Pointer<ffi.Uint32> interpolatedMask,
+      ) {
+    return (_lib_uncompress_fill_times ??= _dylib.lookupFunction<
+        _c_lib_uncompress_fill_times,
+        _dart_lib_uncompress_fill_times>('lib_uncompress_fill_times'))(
+      p_fill,
+      records,
+      nbRecords,
+      periods,
+      nbPeriods,
+      interpolatedMask,
+    );
+  }
+
+  _dart_lib_uncompress_fill_times? _lib_uncompress_fill_times;
+
+  // uint32_t lib_uncompress_fill_samples(uncompress_fill_t *p_fill, samples_t *p_samples, uint32_t *interpolatedMask);
+
+  int lib_uncompress_fill_samples(
+      ffi.Pointer<uncompress_fill_t> p_fill,
+      ffi.Pointer<samples_t> p_samples,
+      ffi.Pointer<ffi.Uint32> interpolatedMask,
+      ) {
+    return (_lib_uncompress_fill_samples ??= _dylib.lookupFunction<
+        _c_lib_uncompress_fill_samples,
+        _dart_lib_uncompress_fill_samples>('lib_uncompress_fill_samples'))(
+      p_fill,
+      p_samples,
+      interpolatedMask,
+    );
+  }
+
+  _dart_lib_uncompress_fill_samples? _lib_uncompress_fill_samples;
+
   void __va_start(
       ffi.Pointer<ffi.Pointer<ffi.Int8>> arg0,
       ) {
@@ -222,12 +1028,240 @@ class record_t extends ffi.Struct {
   external int tempe;
 }
 
+class uncompress_period_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int firstSample;
+
+  @ffi.Uint16()
+  external int period;
+}
+
 class samples_t extends ffi.Struct {
   @ffi.Uint32()
   external int nbSamples;
 
   @ffi.Array.multi([50000])
   external ffi.Array<record_t> samples;
+
+  @ffi.Uint16()
+  external int nbPeriods;
+
+  @ffi.Array.multi([103])
+  external ffi.Array<uncompress_period_t> periods;
+}
+
+class uncompress_state_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int lastValidTime;
+
+  @ffi.Uint16()
+  external int currentPeriod;
+
+  @ffi.Uint16()
+  external int nbPeriodToAdd;
+
+  @ffi.Int16()
+  external int lastValidTempe;
+}
+
+class uncompress_bucket_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int startTime;
+
+  @ffi.Uint32()
+  external int count;
+
+  @ffi.Uint32()
+  external int nbGaps;
+
+  @ffi.Int16()
+  external int minTempe;
+
+  @ffi.Int16()
+  external int maxTempe;
+
+  @ffi.Int64()
+  external int sumTempe;
+
+  @ffi.Float()
+  external double meanTempe;
+}
+
+class uncompress_aggregate_t extends ffi.Struct {
+  external ffi.Pointer<uncompress_bucket_t> buckets;
+
+  @ffi.Uint32()
+  external int nbBuckets;
+
+  @ffi.Uint32()
+  external int origin;
+
+  @ffi.Uint32()
+  external int width;
+
+  @ffi.Uint32()
+  external int nbDropped;
+
+  @ffi.Uint32()
+  external int lastTime;
+}
+
+class uncompress_cache_t extends ffi.Opaque {}
+
+class uncompress_session_t extends ffi.Opaque {}
+
+class uncompress_m4_t extends ffi.Opaque {}
+
+class uncompress_cache_stats_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int nbHits;
+
+  @ffi.Uint32()
+  external int nbMisses;
+
+  @ffi.Uint32()
+  external int nbEntries;
+
+  @ffi.Uint32()
+  external int nbCompactions;
+
+  @ffi.Uint32()
+  external int fileSize;
+}
+
+class uncompress_stats_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int nbSamples;
+
+  @ffi.Uint32()
+  external int nbValidTempe;
+
+  @ffi.Uint32()
+  external int nbInvalidTempe;
+
+  @ffi.Uint32()
+  external int nbUnreceived;
+
+  @ffi.Uint32()
+  external int nbInvalidTime;
+
+  @ffi.Int16()
+  external int minTempe;
+
+  @ffi.Int16()
+  external int maxTempe;
+
+  @ffi.Int64()
+  external int sumTempe;
+
+  @ffi.Uint64()
+  external int sumSqTempe;
+
+  @ffi.Float()
+  external double meanTempe;
+
+  @ffi.Float()
+  external double varianceTempe;
+
+  @ffi.Uint32()
+  external int firstTime;
+
+  @ffi.Uint32()
+  external int lastTime;
+
+  @ffi.Uint32()
+  external int timeSpan;
+}
+
+class uncompress_resync_config_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int minTime;
+
+  @ffi.Uint32()
+  external int maxTime;
+
+  @ffi.Uint32()
+  external int maxTimeJump;
+
+  @ffi.Int16()
+  external int minTempe;
+
+  @ffi.Int16()
+  external int maxTempe;
+}
+
+class uncompress_skipped_range_t extends ffi.Struct {
+  @ffi.Uint16()
+  external int firstBit;
+
+  @ffi.Uint16()
+  external int nbBits;
+}
+
+class uncompress_resync_report_t extends ffi.Struct {
+  @ffi.Uint16()
+  external int nbResyncs;
+
+  @ffi.Uint16()
+  external int nbRanges;
+
+  @ffi.Uint32()
+  external int nbSkippedBits;
+
+  @ffi.Uint32()
+  external int nbDroppedSamples;
+
+  @ffi.Array.multi([16])
+  external ffi.Array<uncompress_skipped_range_t> ranges;
+}
+
+class uncompress_writer_config_t extends ffi.Struct {
+  @ffi.Uint8()
+  external int format;
+
+  @ffi.Int8()
+  external int fieldSeparator;
+
+  @ffi.Int8()
+  external int lineSeparator;
+
+  @ffi.Uint8()
+  external int celsius;
+
+  @ffi.Uint8()
+  external int emptyInvalid;
+}
+
+class uncompress_writer_t extends ffi.Struct {
+  external uncompress_writer_config_t config;
+
+  external ffi.Pointer<ffi.Uint8> buffer;
+
+  @ffi.Uint32()
+  external int size;
+
+  @ffi.Uint32()
+  external int len;
+
+  external ffi.Pointer<ffi.NativeFunction<_typedefC_1>> flush;
+
+  external ffi.Pointer<ffi.Void> p_user;
+
+  external ffi.Pointer<ffi.Void> p_file;
+
+  @ffi.Uint64()
+  external int nbRecords;
+
+  @ffi.Uint64()
+  external int nbBytes;
+
+  @ffi.Uint8()
+  external int error;
+}
+
+class uncompress_fill_t extends ffi.Struct {
+  @ffi.Uint32()
+  external int lastTime;
 }
 
 class def_bitStream_t extends ffi.Struct {
@@ -292,27 +1326,63 @@ const int CT_UNRECEIVED_COUNTER_MAX = 63;
 
 const int CT_DIRECT_PREFIX_VALUE = 10;
 
-const int CT_DIRECT_PREFIX_NB_BITS = 4;
+const int CT_DIRECT_PREFIX_NB_BITS = 4;
+
+const int CT_DIRECT_NB_BITS = 32;
+
+const int CT_INVALID_VALUE = 11;
+
+const int CT_INVALID_NB_BITS = 4;
+
+const int CT_NEW_PERIOD_PREFIX_VALUE = 13;
+
+const int CT_NEW_PERIOD_PREFIX_NB_BITS = 4;
+
+const int CT_NEW_PERIOD_NB_BITS = 16;
+
+const int CT_RESERVED_VALUE = 14;
+
+const int CT_RESERVED_NB_BITS = 4;
+
+const int INVALID_TEMPERATURE = 32767;
+
+const int SRV_UNCOMPRESS_NB_MAX_SAMPLES = 200000;
+
+const int UNCOMPRESS_AGGREGATE_AUTO_ORIGIN = 4294967295;
+
+const int UNCOMPRESS_CACHE_DEFAULT_MAX_BYTES = 16777216;
+
+const int UNCOMPRESS_NB_MAX_PERIODS = 103;
+
+const int UNCOMPRESS_SESSION_DEFAULT_NB_CACHED = 32;
+
+const int UNCOMPRESS_SESSION_NOT_FOUND = 4294967295;
+
+const int UNCOMPRESS_STATE_BLOB_MAGIC = 188;
+
+const int UNCOMPRESS_STATE_BLOB_VERSION = 1;
+
+const int UNCOMPRESS_STATE_BLOB_SIZE = 13;
 
-const int CT_DIRECT_NB_BITS = 32;
+const int UNCOMPRESS_RESYNC_MAX_RANGES = 16;
 
-const int CT_INVALID_VALUE = 11;
+const int UNCOMPRESS_ARCHIVE_MAGIC = 186;
 
-const int CT_INVALID_NB_BITS = 4;
+const int UNCOMPRESS_ARCHIVE_VERSION = 2;
 
-const int CT_NEW_PERIOD_PREFIX_VALUE = 13;
+const int UNCOMPRESS_ARCHIVE_HEADER_SIZE = 6;
 
-const int CT_NEW_PERIOD_PREFIX_NB_BITS = 4;
+const int UNCOMPRESS_ARCHIVE_BLOCK_RECORDS = 4096;
 
-const int CT_NEW_PERIOD_NB_BITS = 16;
+const int UNCOMPRESS_ARCHIVE_MAX_RECORDS = 268435456;
 
-const int CT_RESERVED_VALUE = 14;
+const int UNCOMPRESS_WRITER_CSV = 0;
 
-const int CT_RESERVED_NB_BITS = 4;
+const int UNCOMPRESS_WRITER_BINARY = 1;
 
-const int INVALID_TEMPERATURE = 32767;
+const int UNCOMPRESS_WRITER_MAX_RECORD_LEN = 24;
 
-const int SRV_UNCOMPRESS_NB_MAX_SAMPLES = 200000;
+const int UNCOMPRESS_WRITER_FILE_BUFFER_SIZE = 262144;
 
 const int _VCRT_COMPILER_PREPROCESSOR = 1;
 
@@ -466,6 +1536,536 @@ typedef _dart_lib_uncompress_data = int Function(
     ffi.Pointer<samples_t> p_samples,
     );
 
+typedef _c_lib_uncompress_stats_compute = ffi.Void Function(
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 nbRecords,
+    ffi.Pointer<uncompress_stats_t> p_stats,
+    ffi.Pointer<ffi.Uint32> validMask,
+    );
+
+typedef _dart_lib_uncompress_stats_compute = void Function(
+    ffi.Pointer<record_t> records,
+    int nbRecords,
+    ffi.Pointer<uncompress_stats_t> p_stats,
+    ffi.Pointer<ffi.Uint32> validMask,
+    );
+
+typedef _c_lib_uncompress_stats_compute_samples = ffi.Void Function(
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_stats_t> p_stats,
+    ffi.Pointer<ffi.Uint32> validMask,
+    );
+
+typedef _dart_lib_uncompress_stats_compute_samples = void Function(
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_stats_t> p_stats,
+    ffi.Pointer<ffi.Uint32> validMask,
+    );
+
+typedef _c_lib_uncompress_get_state = ffi.Void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _dart_lib_uncompress_get_state = void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _c_lib_uncompress_aggregate_init = ffi.Void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    ffi.Pointer<uncompress_bucket_t> buckets,
+    ffi.Uint32 nbBuckets,
+    ffi.Uint32 origin,
+    ffi.Uint32 width,
+    );
+
+typedef _dart_lib_uncompress_aggregate_init = void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    ffi.Pointer<uncompress_bucket_t> buckets,
+    int nbBuckets,
+    int origin,
+    int width,
+    );
+
+typedef _c_lib_uncompress_aggregate_width_from_periods = ffi.Uint32 Function(
+    ffi.Uint16 period,
+    ffi.Uint32 nbPeriods,
+    );
+
+typedef _dart_lib_uncompress_aggregate_width_from_periods = int Function(
+    int period,
+    int nbPeriods,
+    );
+
+typedef _c_lib_uncompress_aggregate_add = ffi.Void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 nbRecords,
+    ffi.Pointer<uncompress_period_t> periods,
+    ffi.Uint16 nbPeriods,
+    );
+
+typedef _dart_lib_uncompress_aggregate_add = void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    ffi.Pointer<record_t> records,
+    int nbRecords,
+    ffi.Pointer<uncompress_period_t> periods,
+    int nbPeriods,
+    );
+
+typedef _c_lib_uncompress_aggregate_add_samples = ffi.Void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    ffi.Pointer<samples_t> p_samples,
+    );
+
+typedef _dart_lib_uncompress_aggregate_add_samples = void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    ffi.Pointer<samples_t> p_samples,
+    );
+
+typedef _c_lib_uncompress_aggregate_finish = ffi.Void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    );
+
+typedef _dart_lib_uncompress_aggregate_finish = void Function(
+    ffi.Pointer<uncompress_aggregate_t> p_agg,
+    );
+
+typedef _c_lib_uncompress_downsample_m4 = ffi.Uint32 Function(
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 nbRecords,
+    ffi.Uint32 nbPixels,
+    ffi.Pointer<record_t> output,
+    );
+
+typedef _dart_lib_uncompress_downsample_m4 = int Function(
+    ffi.Pointer<record_t> records,
+    int nbRecords,
+    int nbPixels,
+    ffi.Pointer<record_t> output,
+    );
+
+typedef _c_lib_uncompress_m4_create = ffi.Pointer<uncompress_m4_t> Function();
+
+typedef _dart_lib_uncompress_m4_create = ffi.Pointer<uncompress_m4_t> Function();
+
+typedef _c_lib_uncompress_m4_free = ffi.Void Function(
+    ffi.Pointer<uncompress_m4_t> p_m4,
+    );
+
+typedef _dart_lib_uncompress_m4_free = void Function(
+    ffi.Pointer<uncompress_m4_t> p_m4,
+    );
+
+typedef _c_lib_uncompress_m4_add_samples = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_m4_t> p_m4,
+    ffi.Pointer<samples_t> p_samples,
+    );
+
+typedef _dart_lib_uncompress_m4_add_samples = int Function(
+    ffi.Pointer<uncompress_m4_t> p_m4,
+    ffi.Pointer<samples_t> p_samples,
+    );
+
+typedef _c_lib_uncompress_m4_finish = ffi.Uint32 Function(
+    ffi.Pointer<uncompress_m4_t> p_m4,
+    ffi.Uint32 nbPixels,
+    ffi.Pointer<record_t> output,
+    );
+
+typedef _dart_lib_uncompress_m4_finish = int Function(
+    ffi.Pointer<uncompress_m4_t> p_m4,
+    int nbPixels,
+    ffi.Pointer<record_t> output,
+    );
+
+typedef _c_lib_uncompress_set_state = ffi.Void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _dart_lib_uncompress_set_state = void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _c_lib_uncompress_cache_open = ffi.Pointer<uncompress_cache_t> Function(
+    ffi.Pointer<ffi.Int8> path,
+    ffi.Uint32 maxBytes,
+    );
+
+typedef _dart_lib_uncompress_cache_open = ffi.Pointer<uncompress_cache_t> Function(
+    ffi.Pointer<ffi.Int8> path,
+    int maxBytes,
+    );
+
+typedef _c_lib_uncompress_cache_close = ffi.Void Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    );
+
+typedef _dart_lib_uncompress_cache_close = void Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    );
+
+typedef _c_lib_uncompress_cache_uncompress_data = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint8 len,
+    ffi.Pointer<samples_t> p_samples,
+    );
+
+typedef _dart_lib_uncompress_cache_uncompress_data = int Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    ffi.Pointer<ffi.Uint8> buffer,
+    int len,
+    ffi.Pointer<samples_t> p_samples,
+    );
+
+typedef _c_lib_uncompress_cache_get_stats = ffi.Void Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    ffi.Pointer<uncompress_cache_stats_t> p_stats,
+    );
+
+typedef _dart_lib_uncompress_cache_get_stats = void Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    ffi.Pointer<uncompress_cache_stats_t> p_stats,
+    );
+
+typedef _c_lib_uncompress_session_create = ffi.Pointer<uncompress_session_t> Function(
+    ffi.Uint16 nbCachedFrames,
+    );
+
+typedef _dart_lib_uncompress_session_create = ffi.Pointer<uncompress_session_t> Function(
+    int nbCachedFrames,
+    );
+
+typedef _c_lib_uncompress_session_free = ffi.Void Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    );
+
+typedef _dart_lib_uncompress_session_free = void Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    );
+
+typedef _c_lib_uncompress_session_append = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint8 len,
+    );
+
+typedef _dart_lib_uncompress_session_append = int Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    ffi.Pointer<ffi.Uint8> buffer,
+    int len,
+    );
+
+typedef _c_lib_uncompress_session_get_nb_samples = ffi.Uint32 Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    );
+
+typedef _dart_lib_uncompress_session_get_nb_samples = int Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    );
+
+typedef _c_lib_uncompress_session_get_samples = ffi.Uint32 Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    ffi.Uint32 first,
+    ffi.Uint32 nb,
+    ffi.Pointer<record_t> output,
+    );
+
+typedef _dart_lib_uncompress_session_get_samples = int Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    int first,
+    int nb,
+    ffi.Pointer<record_t> output,
+    );
+
+typedef _c_lib_uncompress_session_find_time = ffi.Uint32 Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    ffi.Uint32 time,
+    );
+
+typedef _dart_lib_uncompress_session_find_time = int Function(
+    ffi.Pointer<uncompress_session_t> p_session,
+    int time,
+    );
+
+typedef _c_lib_uncompress_state_init = ffi.Void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _dart_lib_uncompress_state_init = void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _c_lib_uncompress_state_new_frame = ffi.Void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _dart_lib_uncompress_state_new_frame = void Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _c_lib_uncompress_state_save = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<ffi.Uint8> blob,
+    ffi.Uint8 size,
+    );
+
+typedef _dart_lib_uncompress_state_save = int Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<ffi.Uint8> blob,
+    int size,
+    );
+
+typedef _c_lib_uncompress_state_restore = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<ffi.Uint8> blob,
+    ffi.Uint8 len,
+    );
+
+typedef _dart_lib_uncompress_state_restore = int Function(
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<ffi.Uint8> blob,
+    int len,
+    );
+
+typedef _c_lib_uncompress_data_with_state = ffi.Uint8 Function(
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint8 len,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _dart_lib_uncompress_data_with_state = int Function(
+    ffi.Pointer<ffi.Uint8> buffer,
+    int len,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _c_lib_uncompress_cache_uncompress_data_with_state = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint8 len,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _dart_lib_uncompress_cache_uncompress_data_with_state = int Function(
+    ffi.Pointer<uncompress_cache_t> p_cache,
+    ffi.Pointer<ffi.Uint8> buffer,
+    int len,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_state_t> p_state,
+    );
+
+typedef _c_lib_uncompress_resync_config_default = ffi.Void Function(
+    ffi.Pointer<uncompress_resync_config_t> p_config,
+    );
+
+typedef _dart_lib_uncompress_resync_config_default = void Function(
+    ffi.Pointer<uncompress_resync_config_t> p_config,
+    );
+
+typedef _c_lib_uncompress_data_resync = ffi.Uint8 Function(
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint8 len,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<uncompress_resync_config_t> p_config,
+    ffi.Pointer<uncompress_resync_report_t> p_report,
+    );
+
+typedef _dart_lib_uncompress_data_resync = int Function(
+    ffi.Pointer<ffi.Uint8> buffer,
+    int len,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<uncompress_resync_config_t> p_config,
+    ffi.Pointer<uncompress_resync_report_t> p_report,
+    );
+
+typedef _c_lib_uncompress_archive_max_size = ffi.Uint32 Function(
+    ffi.Uint32 nbRecords,
+    );
+
+typedef _dart_lib_uncompress_archive_max_size = int Function(
+    int nbRecords,
+    );
+
+typedef _c_lib_uncompress_archive_encode = ffi.Uint32 Function(
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 nbRecords,
+    ffi.Pointer<ffi.Uint8> output,
+    ffi.Uint32 size,
+    );
+
+typedef _dart_lib_uncompress_archive_encode = int Function(
+    ffi.Pointer<record_t> records,
+    int nbRecords,
+    ffi.Pointer<ffi.Uint8> output,
+    int size,
+    );
+
+typedef _c_lib_uncompress_archive_get_nb_records = ffi.Uint8 Function(
+    ffi.Pointer<ffi.Uint8> archive,
+    ffi.Uint32 len,
+    ffi.Pointer<ffi.Uint32> p_nbRecords,
+    );
+
+typedef _dart_lib_uncompress_archive_get_nb_records = int Function(
+    ffi.Pointer<ffi.Uint8> archive,
+    int len,
+    ffi.Pointer<ffi.Uint32> p_nbRecords,
+    );
+
+typedef _c_lib_uncompress_archive_decode = ffi.Uint8 Function(
+    ffi.Pointer<ffi.Uint8> archive,
+    ffi.Uint32 len,
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 maxRecords,
+    );
+
+typedef _dart_lib_uncompress_archive_decode = int Function(
+    ffi.Pointer<ffi.Uint8> archive,
+    int len,
+    ffi.Pointer<record_t> records,
+    int maxRecords,
+    );
+
+typedef _c_lib_uncompress_data_to_writer = ffi.Uint8 Function(
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint8 len,
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    );
+
+typedef _dart_lib_uncompress_data_to_writer = int Function(
+    ffi.Pointer<ffi.Uint8> buffer,
+    int len,
+    ffi.Pointer<uncompress_state_t> p_state,
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    );
+
+typedef _c_lib_uncompress_writer_config_default = ffi.Void Function(
+    ffi.Pointer<uncompress_writer_config_t> p_config,
+    );
+
+typedef _dart_lib_uncompress_writer_config_default = void Function(
+    ffi.Pointer<uncompress_writer_config_t> p_config,
+    );
+
+typedef _c_lib_uncompress_writer_init = ffi.Void Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    ffi.Pointer<ffi.Uint8> buffer,
+    ffi.Uint32 size,
+    ffi.Pointer<ffi.NativeFunction<_typedefC_1>> flush,
+    ffi.Pointer<ffi.Void> p_user,
+    ffi.Pointer<uncompress_writer_config_t> p_config,
+    );
+
+typedef _dart_lib_uncompress_writer_init = void Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    ffi.Pointer<ffi.Uint8> buffer,
+    int size,
+    ffi.Pointer<ffi.NativeFunction<_typedefC_1>> flush,
+    ffi.Pointer<ffi.Void> p_user,
+    ffi.Pointer<uncompress_writer_config_t> p_config,
+    );
+
+typedef _c_lib_uncompress_writer_open = ffi.Pointer<uncompress_writer_t> Function(
+    ffi.Pointer<ffi.Int8> path,
+    ffi.Uint8 append,
+    ffi.Pointer<uncompress_writer_config_t> p_config,
+    );
+
+typedef _dart_lib_uncompress_writer_open = ffi.Pointer<uncompress_writer_t> Function(
+    ffi.Pointer<ffi.Int8> path,
+    int append,
+    ffi.Pointer<uncompress_writer_config_t> p_config,
+    );
+
+typedef _c_lib_uncompress_writer_add = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 nbRecords,
+    );
+
+typedef _dart_lib_uncompress_writer_add = int Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    ffi.Pointer<record_t> records,
+    int nbRecords,
+    );
+
+typedef _c_lib_uncompress_writer_flush = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    );
+
+typedef _dart_lib_uncompress_writer_flush = int Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    );
+
+typedef _c_lib_uncompress_writer_close = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    );
+
+typedef _dart_lib_uncompress_writer_close = int Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    );
+
+typedef _c_lib_uncompress_writer_add_one = ffi.Uint8 Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    ffi.Pointer<record_t> p_record,
+    );
+
+typedef _dart_lib_uncompress_writer_add_one = int Function(
+    ffi.Pointer<uncompress_writer_t> p_writer,
+    ffi.Pointer<record_t> p_record,
+    );
+
+typedef _typedefC_1 = ffi.Uint8 Function(
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Uint8>,
+    ffi.Uint32,
+    );
+
+typedef _c_lib_uncompress_fill_init = ffi.Void Function(
+    ffi.Pointer<uncompress_fill_t> p_fill,
+    );
+
+typedef _dart_lib_uncompress_fill_init = void Function(
+    ffi.Pointer<uncompress_fill_t> p_fill,
+    );
+
+typedef _c_lib_uncompress_fill_times = ffi.Uint32 Function(
+    ffi.Pointer<uncompress_fill_t> p_fill,
+    ffi.Pointer<record_t> records,
+    ffi.Uint32 nbRecords,
+    ffi.Pointer<uncompress_period_t> periods,
+    ffi.Uint16 nbPeriods,
+    ffi.Pointer<ffi.Uint32> interpolatedMask,
+    );
+
+typedef _dart_lib_uncompress_fill_times = int Function(
+    ffi.Pointer<uncompress_fill_t> p_fill,
+    ffi.Pointer<record_t> records,
+    int nbRecords,
+    ffi.Pointer<uncompress_period_t> periods,
+    int nbPeriods,
+    ffi.Pointer<ffi.Uint32> interpolatedMask,
+    );
+
+typedef _c_lib_uncompress_fill_samples = ffi.Uint32 Function(
+    ffi.Pointer<uncompress_fill_t> p_fill,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<ffi.Uint32> interpolatedMask,
+    );
+
+typedef _dart_lib_uncompress_fill_samples = int Function(
+    ffi.Pointer<uncompress_fill_t> p_fill,
+    ffi.Pointer<samples_t> p_samples,
+    ffi.Pointer<ffi.Uint32> interpolatedMask,
+    );
+
 typedef _c___va_start = ffi.Void Function(
     ffi.Pointer<ffi.Pointer<ffi.Int8>> arg0,
     );
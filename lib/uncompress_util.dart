@@ -3,6 +3,7 @@
 import 'dart:ffi'; // For FFI
 // For Platform.isX
 import 'dart:io';
+import 'dart:typed_data';
 import 'uncompress_lib_bindings.dart';
 import 'package:ffi/ffi.dart' as ffi;
 
@@ -13,12 +14,18 @@ final uncompressBinding = UncompressBinding(
 
 class UncompressUtil {
 
-  static List<UncompressedRecord> uncompress (List<int> values ) {
+  // Set fillTimes to give the samples without a valid time their expected time, flagged as interpolated
+  static List<UncompressedRecord> uncompress (List<int> values , {bool fillTimes = false}) {
       return ffi.using((arena) {
         var uncompressedPointer = arena.allocate<samples_t>(500000);
         var pointer = intListToArray(values, arena);
         var ret = uncompressBinding.lib_uncompress_data(
             pointer, values.length, uncompressedPointer);
+        if (fillTimes) {
+          var fillPointer = arena<uncompress_fill_t>();
+          uncompressBinding.lib_uncompress_fill_init(fillPointer);
+          return filledRecords(uncompressedPointer, fillPointer, arena);
+        }
         samples_t samples = uncompressedPointer.elementAt(0).ref;
         var results = List.generate(samples.nbSamples, (index) {
           var record = samples.samples[index];
@@ -29,6 +36,192 @@ class UncompressUtil {
       } , ffi.malloc);
   }
 
+  // Records of decoded samples after lib_uncompress_fill_samples
+  static List<UncompressedRecord> filledRecords (Pointer<samples_t> samplesPointer ,
+      Pointer<uncompress_fill_t> fillPointer , ffi.Arena arena) {
+    int nbSamples = samplesPointer.ref.nbSamples;
+    var maskPointer = arena<Uint32>((nbSamples + 31) ~/ 32 + 1);
+    uncompressBinding.lib_uncompress_fill_samples(
+        fillPointer, samplesPointer, maskPointer);
+    samples_t samples = samplesPointer.ref;
+    return List.generate(nbSamples, (index) {
+      var record = samples.samples[index];
+      var interpolated = (maskPointer[index >> 5] >> (index & 31)) & 1 == 1;
+      return UncompressedRecord(record.tempe, record.time, interpolated: interpolated);
+    });
+  }
+
+  static UncompressStats statistics (List<int> values ) {
+      return ffi.using((arena) {
+        var uncompressedPointer = arena.allocate<samples_t>(500000);
+        var pointer = intListToArray(values, arena);
+        uncompressBinding.lib_uncompress_data(
+            pointer, values.length, uncompressedPointer);
+        int nbSamples = uncompressedPointer.ref.nbSamples;
+        var statsPointer = arena<uncompress_stats_t>();
+        var maskPointer = arena<Uint32>((nbSamples + 31) ~/ 32 + 1);
+        uncompressBinding.lib_uncompress_stats_compute_samples(
+            uncompressedPointer, statsPointer, maskPointer);
+        var stats = statsPointer.ref;
+        var results = UncompressStats(
+            stats.nbSamples,
+            stats.nbValidTempe,
+            stats.nbInvalidTempe,
+            stats.nbUnreceived,
+            stats.nbInvalidTime,
+            stats.minTempe,
+            stats.maxTempe,
+            stats.meanTempe,
+            stats.varianceTempe,
+            stats.firstTime,
+            stats.lastTime,
+            stats.timeSpan,
+            maskPointer.asTypedList((nbSamples + 31) ~/ 32).toList());
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
+  // Buckets of nbPeriods sampling periods; the period is taken from the first frame giving it,
+  // and the frames decoded before are aggregated too. Empty if no frame gives the period.
+  static List<UncompressedBucket> aggregate (List<List<int>> frames , int nbPeriods , int nbBuckets) {
+      int width = ffi.using((arena) {
+        var uncompressedPointer = arena.allocate<samples_t>(500000);
+        var statePointer = arena<uncompress_state_t>();
+        uncompressBinding.lib_uncompress_state_init(statePointer);
+        for (var values in frames) {
+          decodeFrame(values, uncompressedPointer, statePointer, arena);
+          int periodsWidth = uncompressBinding.lib_uncompress_aggregate_width_from_periods(
+              statePointer.ref.currentPeriod, nbPeriods);
+          if (periodsWidth != 0) {
+            return periodsWidth;
+          }
+        }
+        return 0;
+      } , ffi.malloc);
+      if (width == 0) {
+        return <UncompressedBucket>[];
+      }
+      return aggregateSeconds(frames, width, nbBuckets);
+  }
+
+  // Buckets of width seconds (60 for one bucket per minute), the first one starting at origin
+  // or at the first sample, aligned on width
+  static List<UncompressedBucket> aggregateSeconds (List<List<int>> frames , int width , int nbBuckets ,
+      {int origin = UNCOMPRESS_AGGREGATE_AUTO_ORIGIN}) {
+      return ffi.using((arena) {
+        var uncompressedPointer = arena.allocate<samples_t>(500000);
+        var statePointer = arena<uncompress_state_t>();
+        var aggPointer = arena<uncompress_aggregate_t>();
+        var bucketsPointer = arena<uncompress_bucket_t>(nbBuckets + 1);
+        uncompressBinding.lib_uncompress_state_init(statePointer);
+        uncompressBinding.lib_uncompress_aggregate_init(aggPointer,
+            bucketsPointer, nbBuckets, origin, width);
+        for (var values in frames) {
+          decodeFrame(values, uncompressedPointer, statePointer, arena);
+          uncompressBinding.lib_uncompress_aggregate_add_samples(
+              aggPointer, uncompressedPointer);
+        }
+        uncompressBinding.lib_uncompress_aggregate_finish(aggPointer);
+        var results = List.generate(nbBuckets, (index) {
+          var bucket = bucketsPointer.elementAt(index).ref;
+          return UncompressedBucket(bucket.startTime, bucket.count,
+              bucket.nbGaps, bucket.minTempe, bucket.maxTempe, bucket.meanTempe);
+        });
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
+  // M4 downsampling to nbPixels columns. The samples stay in native memory,
+  // only the (at most 4 * nbPixels) kept samples are copied.
+  static List<UncompressedRecord> downsample (List<List<int>> frames , int nbPixels) {
+      var m4Pointer = uncompressBinding.lib_uncompress_m4_create();
+      if (m4Pointer == nullptr) {
+        throw OutOfMemoryError();
+      }
+      try {
+        return ffi.using((arena) {
+          var uncompressedPointer = arena.allocate<samples_t>(500000);
+          var statePointer = arena<uncompress_state_t>();
+          uncompressBinding.lib_uncompress_state_init(statePointer);
+          for (var values in frames) {
+            decodeFrame(values, uncompressedPointer, statePointer, arena);
+            if (uncompressBinding.lib_uncompress_m4_add_samples(m4Pointer, uncompressedPointer) == 0) {
+              throw OutOfMemoryError();
+            }
+          }
+          var outputPointer = arena<record_t>(4 * nbPixels + 1);
+          int nbOutput = uncompressBinding.lib_uncompress_m4_finish(
+              m4Pointer, nbPixels, outputPointer);
+          var results = List.generate(nbOutput, (index) {
+            var record = outputPointer.elementAt(index).ref;
+            return UncompressedRecord(record.tempe, record.time);
+          });
+          arena.releaseAll();
+          return results;
+        } , ffi.malloc);
+      } finally {
+        uncompressBinding.lib_uncompress_m4_free(m4Pointer);
+      }
+  }
+
+  // Decode a frame into samplesPointer with the state of the caller, the temperature reference
+  // is kept from the previous frame (same as lib_uncompress_data)
+  static void decodeFrame (List<int> values , Pointer<samples_t> samplesPointer ,
+      Pointer<uncompress_state_t> statePointer , ffi.Arena arena) {
+    var pointer = intListToArray(values, arena);
+    uncompressBinding.lib_uncompress_state_new_frame(statePointer);
+    uncompressBinding.lib_uncompress_data_with_state(
+        pointer, values.length, samplesPointer, statePointer);
+  }
+
+  // Compact form of decoded records for the long term storage, see unarchive
+  static Uint8List archive (List<UncompressedRecord> records ) {
+      return ffi.using((arena) {
+        var recordsPointer = arena<record_t>(records.length + 1);
+        for (var i = 0; i < records.length; i++) {
+          recordsPointer.elementAt(i).ref
+            ..time = records[i].time
+            ..tempe = records[i].temp;
+        }
+        int size = uncompressBinding.lib_uncompress_archive_max_size(records.length);
+        if (size == 0) {
+          throw ArgumentError('too many records to archive');
+        }
+        var outputPointer = arena<Uint8>(size);
+        int len = uncompressBinding.lib_uncompress_archive_encode(
+            recordsPointer, records.length, outputPointer, size);
+        var result = Uint8List.fromList(outputPointer.asTypedList(len));
+        arena.releaseAll();
+        return result;
+      } , ffi.malloc);
+  }
+
+  // Records given to archive, throws if the archive is corrupted
+  static List<UncompressedRecord> unarchive (Uint8List archive ) {
+      return ffi.using((arena) {
+        var pointer = intListToArray(archive, arena);
+        var nbPointer = arena<Uint32>();
+        if (uncompressBinding.lib_uncompress_archive_get_nb_records(
+            pointer, archive.length, nbPointer) == 0) {
+          throw FormatException('invalid archive');
+        }
+        int nbRecords = nbPointer.value;
+        var recordsPointer = arena<record_t>(nbRecords + 1);
+        if (uncompressBinding.lib_uncompress_archive_decode(
+            pointer, archive.length, recordsPointer, nbRecords) == 0) {
+          throw FormatException('corrupted archive');
+        }
+        var results = List.generate(nbRecords, (index) {
+          var record = recordsPointer.elementAt(index).ref;
+          return UncompressedRecord(record.tempe, record.time);
+        });
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
   static Pointer<Uint8> intListToArray(List<int> list , ffi.Arena arena) {
     final ptr = arena.allocate<Uint8>(list.length);
     for (var i = 0; i < list.length; i++) {
@@ -40,7 +233,309 @@ class UncompressUtil {
 class UncompressedRecord {
   final int temp ;
   final int time ;
+  final bool interpolated ;   // time filled by UncompressUtil.uncompress(fillTimes: true), not decoded
 
-  UncompressedRecord(this.temp, this.time);
+  UncompressedRecord(this.temp, this.time, {this.interpolated = false});
 }
 
+class UncompressCache {
+  Pointer<uncompress_cache_t> _cache = nullptr;
+
+  // Open (or create) the cache file, the least recently used frames are evicted above maxBytes
+  UncompressCache(String path, {int maxBytes = UNCOMPRESS_CACHE_DEFAULT_MAX_BYTES}) {
+    var pathPointer = path.toNativeUtf8();
+    _cache = uncompressBinding.lib_uncompress_cache_open(
+        pathPointer.cast<Int8>(), maxBytes);
+    ffi.malloc.free(pathPointer);
+  }
+
+  bool get isOpen => _cache != nullptr;
+
+  // Same as UncompressUtil.uncompress, frames already decoded are read from the cache
+  List<UncompressedRecord> uncompress (List<int> values ) {
+      return ffi.using((arena) {
+        var uncompressedPointer = arena.allocate<samples_t>(500000);
+        var pointer = UncompressUtil.intListToArray(values, arena);
+        uncompressBinding.lib_uncompress_cache_uncompress_data(
+            _cache, pointer, values.length, uncompressedPointer);
+        samples_t samples = uncompressedPointer.elementAt(0).ref;
+        var results = List.generate(samples.nbSamples, (index) {
+          var record = samples.samples[index];
+          return UncompressedRecord(record.tempe, record.time);
+        });
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
+  void close() {
+    uncompressBinding.lib_uncompress_cache_close(_cache);
+    _cache = nullptr;
+  }
+}
+
+class UncompressSession {
+  Pointer<uncompress_session_t> _session = nullptr;
+
+  // Frames are kept compressed, at most nbCachedFrames decoded frames are kept in memory
+  UncompressSession({int nbCachedFrames = UNCOMPRESS_SESSION_DEFAULT_NB_CACHED}) {
+    _session = uncompressBinding.lib_uncompress_session_create(nbCachedFrames);
+  }
+
+  bool append (List<int> values ) {
+      return ffi.using((arena) {
+        var pointer = UncompressUtil.intListToArray(values, arena);
+        var ret = uncompressBinding.lib_uncompress_session_append(
+            _session, pointer, values.length);
+        arena.releaseAll();
+        return ret != 0;
+      } , ffi.malloc);
+  }
+
+  int get length => uncompressBinding.lib_uncompress_session_get_nb_samples(_session);
+
+  List<UncompressedRecord> samples (int first , int nb ) {
+      return ffi.using((arena) {
+        var outputPointer = arena<record_t>(nb);
+        int nbRead = uncompressBinding.lib_uncompress_session_get_samples(
+            _session, first, nb, outputPointer);
+        var results = List.generate(nbRead, (index) {
+          var record = outputPointer.elementAt(index).ref;
+          return UncompressedRecord(record.tempe, record.time);
+        });
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
+  // Index of the first sample at or after time, -1 if none
+  int indexOfTime (int time ) {
+    int index = uncompressBinding.lib_uncompress_session_find_time(_session, time);
+    return index == UNCOMPRESS_SESSION_NOT_FOUND ? -1 : index;
+  }
+
+  void close() {
+    uncompressBinding.lib_uncompress_session_free(_session);
+    _session = nullptr;
+  }
+}
+
+class UncompressDecoder {
+  Pointer<uncompress_state_t> _state = nullptr;
+  Pointer<uncompress_fill_t> _fill = nullptr;
+
+  // Decoder with its own state, independent of UncompressUtil.uncompress
+  UncompressDecoder() {
+    _state = ffi.malloc<uncompress_state_t>();
+    uncompressBinding.lib_uncompress_state_init(_state);
+    _fill = ffi.malloc<uncompress_fill_t>();
+    uncompressBinding.lib_uncompress_fill_init(_fill);
+  }
+
+  // Decoder resumed from a snapshot, throws if the snapshot is corrupted.
+  // A gap open at the time of the snapshot is not filled.
+  UncompressDecoder.restore(Uint8List snapshot) {
+    _fill = ffi.malloc<uncompress_fill_t>();
+    uncompressBinding.lib_uncompress_fill_init(_fill);
+    _state = ffi.malloc<uncompress_state_t>();
+    var ret = ffi.using((arena) {
+      var pointer = UncompressUtil.intListToArray(snapshot, arena);
+      return uncompressBinding.lib_uncompress_state_restore(
+          _state, pointer, snapshot.length);
+    } , ffi.malloc);
+    if (ret == 0) {
+      ffi.malloc.free(_state);
+      ffi.malloc.free(_fill);
+      _state = nullptr;
+      _fill = nullptr;
+      throw FormatException('invalid decoder snapshot');
+    }
+  }
+
+  // Decode a frame; set newFrame to false when the frame continues the previous one.
+  // Set fillTimes to give the samples without a valid time their expected time, flagged as interpolated.
+  List<UncompressedRecord> uncompress (List<int> values , {bool newFrame = true, bool fillTimes = false}) {
+      return ffi.using((arena) {
+        var uncompressedPointer = arena.allocate<samples_t>(500000);
+        var pointer = UncompressUtil.intListToArray(values, arena);
+        if (newFrame) {
+          uncompressBinding.lib_uncompress_state_new_frame(_state);
+          uncompressBinding.lib_uncompress_fill_init(_fill);
+        }
+        uncompressBinding.lib_uncompress_data_with_state(
+            pointer, values.length, uncompressedPointer, _state);
+        if (fillTimes) {
+          return UncompressUtil.filledRecords(uncompressedPointer, _fill, arena);
+        }
+        samples_t samples = uncompressedPointer.elementAt(0).ref;
+        var results = List.generate(samples.nbSamples, (index) {
+          var record = samples.samples[index];
+          return UncompressedRecord(record.tempe, record.time);
+        });
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
+  // Same as uncompress, skipping the corrupted parts of the frame
+  UncompressResyncResult uncompressResync (List<int> values , {bool newFrame = true}) {
+      return ffi.using((arena) {
+        var uncompressedPointer = arena.allocate<samples_t>(500000);
+        var reportPointer = arena<uncompress_resync_report_t>();
+        var pointer = UncompressUtil.intListToArray(values, arena);
+        if (newFrame) {
+          uncompressBinding.lib_uncompress_state_new_frame(_state);
+        }
+        uncompressBinding.lib_uncompress_data_resync(
+            pointer, values.length, uncompressedPointer, _state, nullptr, reportPointer);
+        samples_t samples = uncompressedPointer.elementAt(0).ref;
+        uncompress_resync_report_t report = reportPointer.ref;
+        var results = UncompressResyncResult(
+            List.generate(samples.nbSamples, (index) {
+              var record = samples.samples[index];
+              return UncompressedRecord(record.tempe, record.time);
+            }),
+            List.generate(report.nbRanges, (index) {
+              var range = report.ranges[index];
+              return UncompressSkippedRange(range.firstBit, range.nbBits);
+            }),
+            report.nbResyncs, report.nbSkippedBits);
+        arena.releaseAll();
+        return results;
+      } , ffi.malloc);
+  }
+
+  // Serialized state, to be stored and given to UncompressDecoder.restore
+  Uint8List snapshot() {
+      return ffi.using((arena) {
+        var blob = arena<Uint8>(UNCOMPRESS_STATE_BLOB_SIZE);
+        uncompressBinding.lib_uncompress_state_save(
+            _state, blob, UNCOMPRESS_STATE_BLOB_SIZE);
+        var result = Uint8List.fromList(blob.asTypedList(UNCOMPRESS_STATE_BLOB_SIZE));
+        arena.releaseAll();
+        return result;
+      } , ffi.malloc);
+  }
+
+  void close() {
+    ffi.malloc.free(_state);
+    ffi.malloc.free(_fill);
+    _state = nullptr;
+    _fill = nullptr;
+  }
+}
+
+class UncompressExporter {
+  Pointer<uncompress_writer_t> _writer = nullptr;
+  Pointer<uncompress_state_t> _state = nullptr;
+
+  // Samples are decoded and formatted in native code, then written to path in large blocks.
+  // Default: "time;temp" lines as in the example; celsius writes 37.12 instead of 3712.
+  UncompressExporter(String path, {bool append = true, bool binary = false,
+      bool celsius = false, bool emptyInvalid = false,
+      String fieldSeparator = ';', String lineSeparator = '\n'}) {
+    ffi.using((arena) {
+      var configPointer = arena<uncompress_writer_config_t>();
+      uncompressBinding.lib_uncompress_writer_config_default(configPointer);
+      configPointer.ref
+        ..format = binary ? UNCOMPRESS_WRITER_BINARY : UNCOMPRESS_WRITER_CSV
+        ..fieldSeparator = fieldSeparator.codeUnitAt(0)
+        ..lineSeparator = lineSeparator.codeUnitAt(0)
+        ..celsius = celsius ? 1 : 0
+        ..emptyInvalid = emptyInvalid ? 1 : 0;
+      var pathPointer = path.toNativeUtf8(allocator: arena);
+      _writer = uncompressBinding.lib_uncompress_writer_open(
+          pathPointer.cast<Int8>(), append ? 1 : 0, configPointer);
+    } , ffi.malloc);
+    if (_writer != nullptr) {
+      _state = ffi.malloc<uncompress_state_t>();
+      uncompressBinding.lib_uncompress_state_init(_state);
+    }
+  }
+
+  bool get isOpen => _writer != nullptr;
+
+  // Number of samples written since the exporter was created, 0 once closed or if the file could not be opened
+  int get length => isOpen ? _writer.ref.nbRecords : 0;
+
+  // Decode a frame and write its samples; set newFrame to false when the frame continues the previous one.
+  // Throws StateError once closed or if the file could not be opened.
+  int add (List<int> values , {bool newFrame = true}) {
+      if (!isOpen) {
+        throw StateError('exporter is not open');
+      }
+      return ffi.using((arena) {
+        var pointer = UncompressUtil.intListToArray(values, arena);
+        int before = _writer.ref.nbRecords;
+        if (newFrame) {
+          uncompressBinding.lib_uncompress_state_new_frame(_state);
+        }
+        uncompressBinding.lib_uncompress_data_to_writer(
+            pointer, values.length, _state, _writer);
+        arena.releaseAll();
+        return _writer.ref.nbRecords - before;
+      } , ffi.malloc);
+  }
+
+  // Write the remaining samples and close the file, false on a write error
+  bool close() {
+    if (_writer == nullptr) {
+      return false;
+    }
+    var ret = uncompressBinding.lib_uncompress_writer_close(_writer);
+    ffi.malloc.free(_state);
+    _writer = nullptr;
+    _state = nullptr;
+    return ret != 0;
+  }
+}
+
+class UncompressSkippedRange {
+  final int firstBit ;
+  final int nbBits ;
+
+  UncompressSkippedRange(this.firstBit, this.nbBits);
+}
+
+class UncompressResyncResult {
+  final List<UncompressedRecord> records ;
+  final List<UncompressSkippedRange> skippedRanges ;  // at most UNCOMPRESS_RESYNC_MAX_RANGES
+  final int nbResyncs ;
+  final int nbSkippedBits ;
+
+  UncompressResyncResult(this.records, this.skippedRanges, this.nbResyncs, this.nbSkippedBits);
+}
+
+class UncompressedBucket {
+  final int startTime ;
+  final int count ;
+  final int nbGaps ;
+  final int minTemp ;
+  final int maxTemp ;
+  final double meanTemp ;
+
+  UncompressedBucket(this.startTime, this.count, this.nbGaps, this.minTemp,
+      this.maxTemp, this.meanTemp);
+}
+
+class UncompressStats {
+  final int nbSamples ;
+  final int nbValidTemp ;
+  final int nbInvalidTemp ;
+  final int nbUnreceived ;
+  final int nbInvalidTime ;
+  final int minTemp ;
+  final int maxTemp ;
+  final double meanTemp ;
+  final double varianceTemp ;
+  final int firstTime ;
+  final int lastTime ;
+  final int timeSpan ;
+  // bit (i % 32) of validMask[i ~/ 32] is set when sample i has a valid time and temperature
+  final List<int> validMask ;
+
+  UncompressStats(this.nbSamples, this.nbValidTemp, this.nbInvalidTemp,
+      this.nbUnreceived, this.nbInvalidTime, this.minTemp, this.maxTemp,
+      this.meanTemp, this.varianceTemp, this.firstTime, this.lastTime,
+      this.timeSpan, this.validMask);
+}
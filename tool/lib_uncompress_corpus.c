@@ -0,0 +1,552 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_corpus.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Corpora of frames shared by uncompress_bench and uncompress_check.
+  ******************************************************************************
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_uncompress_corpus.h"
+#include "lib_bitStream.h"
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define CORPUS_CONCAT_REPEAT    256         // slots concatenated this number of times in slots_concat
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+// Synthetic dump being made
+typedef struct {
+    uncompress_corpus_t *p_corpus;
+    def_bitStream_t     bs;
+    uint8_t             frame[UINT8_MAX];
+    uint32_t            seed;
+    uint32_t            time;
+    int16_t             tempe;
+} def_corpus_encoder_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static uncompress_corpus_t *corpus_new(const char *name);
+static int corpus_append(uncompress_corpus_t *p_corpus, const uint8_t *data, uint32_t len);
+static int corpus_load_slots(const char *path, uncompress_corpus_t **p_slots, uint32_t *p_nbSlots);
+static int corpus_make_concat(uncompress_corpus_t **slots, uint32_t nbSlots);
+static void corpus_encoder_begin(def_corpus_encoder_t *p_enc, const char *name, uint32_t seed);
+static int corpus_encoder_frame_end(def_corpus_encoder_t *p_enc);
+static uint8_t corpus_encoder_put(def_corpus_encoder_t *p_enc, uint32_t value, uint8_t nbBits);
+static int corpus_encoder_sample(def_corpus_encoder_t *p_enc, const uint32_t *codes, uint8_t nbCodes);
+static int corpus_make_direct(void);
+static int corpus_make_diff8(void);
+static int corpus_make_unreceived(void);
+static int corpus_make_mixed(void);
+static int corpus_make_random(void);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+static uncompress_corpus_t *madeCorpora;   // set by lib_uncompress_corpus_make_all
+static uint32_t nbMadeCorpora;
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+// xorshift32, the synthetic corpora must not depend on the libc
+uint32_t lib_uncompress_corpus_random(uint32_t *p_seed)
+{
+    uint32_t x = *p_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *p_seed = x;
+    return x;
+}
+
+//****************************************************************************
+static uncompress_corpus_t *corpus_new(const char *name)
+{
+    uncompress_corpus_t *p_corpus;
+
+    if (nbMadeCorpora >= UNCOMPRESS_CORPUS_MAX) {
+        fprintf(stderr, "too many corpora\n");
+        return NULL;
+    }
+    p_corpus = &madeCorpora[nbMadeCorpora++];
+    memset(p_corpus, 0, sizeof(uncompress_corpus_t));
+    snprintf(p_corpus->name, sizeof(p_corpus->name), "%s", name);
+    return p_corpus;
+}
+
+//****************************************************************************
+static int corpus_append(uncompress_corpus_t *p_corpus, const uint8_t *data, uint32_t len)
+{
+    if (p_corpus->len + len > p_corpus->size) {
+        uint32_t size = p_corpus->size ? p_corpus->size : 4096;
+        uint8_t *p;
+        while (size < p_corpus->len + len) {
+            size *= 2;
+        }
+        p = realloc(p_corpus->data, size);
+        if (!p) {
+            fprintf(stderr, "out of memory\n");
+            return -1;
+        }
+        p_corpus->data = p;
+        p_corpus->size = size;
+    }
+    memcpy(p_corpus->data + p_corpus->len, data, len);
+    p_corpus->len += len;
+    return 0;
+}
+
+//****************************************************************************
+// Each "List<List<int>> name = [[...], ...];" of the file is a corpus
+static int corpus_load_slots(const char *path, uncompress_corpus_t **p_slots, uint32_t *p_nbSlots)
+{
+    static const char listType[] = "List<List<int>>";
+    FILE *p_file;
+    char *text, *p;
+    long size;
+    uint32_t nbSlots = 0;
+    int ret = 0;
+
+    p_file = fopen(path, "rb");
+    if (!p_file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fseek(p_file, 0, SEEK_END);
+    size = ftell(p_file);
+    rewind(p_file);
+    text = malloc(size + 1);
+    if (!text || (fread(text, 1, size, p_file) != (size_t)size)) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        fclose(p_file);
+        free(text);
+        return -1;
+    }
+    fclose(p_file);
+    text[size] = 0;
+
+    p = text;
+    while (!ret && (p = strstr(p, listType))) {
+        uncompress_corpus_t *p_corpus;
+        char name[UNCOMPRESS_CORPUS_NAME_LEN];
+        uint8_t frame[UINT8_MAX + 1];
+        uint32_t len = 0, nameLen = 0;
+        int depth = 0;
+
+        p += sizeof(listType) - 1;
+        while (*p == ' ') {
+            p++;
+        }
+        while (((*p >= 'a') && (*p <= 'z')) || ((*p >= 'A') && (*p <= 'Z')) || ((*p >= '0') && (*p <= '9')) || (*p == '_')) {
+            if (nameLen < sizeof(name) - 1) {
+                name[nameLen++] = *p;
+            }
+            p++;
+        }
+        name[nameLen] = 0;
+        p_corpus = corpus_new(name);
+        if (!p_corpus || (nbSlots >= UNCOMPRESS_CORPUS_MAX)) {
+            ret = -1;
+            break;
+        }
+        p_corpus->isSlot = 1;
+        p_slots[nbSlots++] = p_corpus;
+        p = strchr(p, '[');
+        while (p && *p) {
+            if (*p == '[') {
+                depth++;
+                len = 1;    // frame[0] is the length
+                p++;
+            } else if (*p == ']') {
+                if (--depth == 0) {
+                    break;
+                }
+                frame[0] = (uint8_t)(len - 1);
+                ret = corpus_append(p_corpus, frame, len);
+                p_corpus->nbFrames++;
+                p++;
+            } else if ((*p >= '0') && (*p <= '9') && (depth == 2)) {
+                unsigned long value = strtoul(p, &p, 10);
+                if ((value > UINT8_MAX) || (len > UINT8_MAX)) {
+                    fprintf(stderr, "%s: %s: bad frame %u\n", path, name, p_corpus->nbFrames);
+                    ret = -1;
+                    break;
+                }
+                frame[len++] = (uint8_t)value;
+            } else {
+                p++;
+            }
+        }
+        if (!p || !*p) {
+            fprintf(stderr, "%s: %s: unterminated list\n", path, name);
+            ret = -1;
+        }
+    }
+    free(text);
+    if (!ret && !nbSlots) {
+        fprintf(stderr, "%s: no slot data\n", path);
+        ret = -1;
+    }
+    *p_nbSlots = nbSlots;
+    return ret;
+}
+
+//****************************************************************************
+// A long dump, as made by a device recording for days
+static int corpus_make_concat(uncompress_corpus_t **slots, uint32_t nbSlots)
+{
+    uncompress_corpus_t *p_corpus = corpus_new("slots_concat");
+
+    if (!p_corpus) {
+        return -1;
+    }
+    for (uint32_t r = 0; r < CORPUS_CONCAT_REPEAT; r++) {
+        for (uint32_t s = 0; s < nbSlots; s++) {
+            if (corpus_append(p_corpus, slots[s]->data, slots[s]->len)) {
+                return -1;
+            }
+            p_corpus->nbFrames += slots[s]->nbFrames;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+static void corpus_encoder_begin(def_corpus_encoder_t *p_enc, const char *name, uint32_t seed)
+{
+    memset(p_enc, 0, sizeof(def_corpus_encoder_t));
+    p_enc->p_corpus = corpus_new(name);
+    p_enc->seed = seed;
+    p_enc->time = 1600000000;
+    p_enc->tempe = 3700;
+    lib_bitStream_create(&p_enc->bs, p_enc->frame, sizeof(p_enc->frame), 0);
+}
+
+//****************************************************************************
+// Close the frame as the device does (last byte completed with 1 bits) and start a new one
+static int corpus_encoder_frame_end(def_corpus_encoder_t *p_enc)
+{
+    uint8_t len;
+
+    lib_bitStream_completeLastByte(&p_enc->bs);
+    len = (uint8_t)lib_bitStream_get_len(&p_enc->bs);
+    if (len) {
+        if (corpus_append(p_enc->p_corpus, &len, 1) || corpus_append(p_enc->p_corpus, p_enc->frame, len)) {
+            return -1;
+        }
+        p_enc->p_corpus->nbFrames++;
+    }
+    lib_bitStream_create(&p_enc->bs, p_enc->frame, sizeof(p_enc->frame), 0);
+    return 0;
+}
+
+//****************************************************************************
+static uint8_t corpus_encoder_put(def_corpus_encoder_t *p_enc, uint32_t value, uint8_t nbBits)
+{
+    return lib_bitStream_set_bits(&p_enc->bs, value, nbBits);
+}
+
+//****************************************************************************
+// Add a sample, given as pairs of value and number of bits.
+// Returns 1 if added, 0 if the frame is full (the frame is then closed), -1 on error.
+static int corpus_encoder_sample(def_corpus_encoder_t *p_enc, const uint32_t *codes, uint8_t nbCodes)
+{
+    for (uint8_t i = 0; i < nbCodes; i += 2) {
+        if (!corpus_encoder_put(p_enc, codes[i], (uint8_t)codes[i + 1])) {
+            return corpus_encoder_frame_end(p_enc);
+        }
+    }
+    lib_bitStream_validate(&p_enc->bs, 1);
+    return 1;
+}
+
+//****************************************************************************
+// Direct timestamps and temperatures only: the most bits read per sample
+static int corpus_make_direct(void)
+{
+    def_corpus_encoder_t enc;
+    int ret = 0;
+
+    corpus_encoder_begin(&enc, "synth_direct", 0x1234567);
+    if (!enc.p_corpus) {
+        return -1;
+    }
+    for (uint32_t i = 0; (i < 100000) && (ret >= 0); i++) {
+        enc.time += 1 + lib_uncompress_corpus_random(&enc.seed) % 600;
+        enc.tempe = (int16_t)(lib_uncompress_corpus_random(&enc.seed) % C9_DIRECT_MAX);   // C9_DIRECT_MAX is the invalid value
+        if (lib_uncompress_corpus_random(&enc.seed) % 64 == 0) {
+            enc.tempe = C9_INVALID_TEMPERATURE;
+        }
+        uint32_t codes[] = { CT_DIRECT_PREFIX_VALUE, CT_DIRECT_PREFIX_NB_BITS, enc.time, CT_DIRECT_NB_BITS,
+                             C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, (uint32_t)enc.tempe, C9_DIRECT_NB_BITS };
+        while ((ret = corpus_encoder_sample(&enc, codes, sizeof(codes) / sizeof(codes[0]))) == 0) {
+        }
+    }
+    return (ret < 0) ? ret : corpus_encoder_frame_end(&enc);
+}
+
+//****************************************************************************
+// 8 bits differential timestamps and 4 bits differential temperatures: the longest walk in C_dec
+static int corpus_make_diff8(void)
+{
+    def_corpus_encoder_t enc;
+    uint8_t newFrame = 1;
+    int ret = 0;
+
+    corpus_encoder_begin(&enc, "synth_diff8", 0x89abcdef);
+    if (!enc.p_corpus) {
+        return -1;
+    }
+    for (uint32_t i = 0; (i < 200000) && (ret >= 0); i++) {
+        if (newFrame) {
+            uint32_t codes[] = { CT_NEW_PERIOD_PREFIX_VALUE, CT_NEW_PERIOD_PREFIX_NB_BITS, 300, CT_NEW_PERIOD_NB_BITS,
+                                 CT_DIRECT_PREFIX_VALUE, CT_DIRECT_PREFIX_NB_BITS, enc.time, CT_DIRECT_NB_BITS,
+                                 C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, (uint32_t)enc.tempe, C9_DIRECT_NB_BITS };
+            ret = corpus_encoder_sample(&enc, codes, sizeof(codes) / sizeof(codes[0]));
+        } else {
+            uint32_t timeIndex = lib_uncompress_corpus_random(&enc.seed) % 256;     // -129..-2, 2..129
+            uint32_t tempeIndex = lib_uncompress_corpus_random(&enc.seed) % 15;     // -10..-4, 4..11
+            if (enc.tempe > 4500) {
+                tempeIndex %= 7;
+            } else if (enc.tempe < 1500) {
+                tempeIndex = 7 + tempeIndex % 8;
+            }
+            uint32_t codes[] = { 0xF, 4, timeIndex, 8, 0x7, 3, tempeIndex, 4 };
+            ret = corpus_encoder_sample(&enc, codes, sizeof(codes) / sizeof(codes[0]));
+            if (ret > 0) {
+                enc.time += 300 + ((timeIndex < 128) ? (int32_t)timeIndex - 129 : (int32_t)timeIndex - 126);
+                enc.tempe += (tempeIndex < 7) ? (int16_t)tempeIndex - 10 : (int16_t)tempeIndex - 3;
+            }
+        }
+        newFrame = (ret == 0);
+    }
+    return (ret < 0) ? ret : corpus_encoder_frame_end(&enc);
+}
+
+//****************************************************************************
+// Runs of 63 unreceived samples: the most samples written per bit read
+static int corpus_make_unreceived(void)
+{
+    def_corpus_encoder_t enc;
+    uint8_t newFrame = 1;
+    int ret = 0;
+
+    corpus_encoder_begin(&enc, "synth_unreceived", 0x2468ace);
+    if (!enc.p_corpus) {
+        return -1;
+    }
+    for (uint32_t i = 0; (i < 4000) && (ret >= 0); i++) {
+        if (newFrame) {
+            uint32_t codes[] = { CT_DIRECT_PREFIX_VALUE, CT_DIRECT_PREFIX_NB_BITS, enc.time, CT_DIRECT_NB_BITS,
+                                 C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, (uint32_t)enc.tempe, C9_DIRECT_NB_BITS };
+            ret = corpus_encoder_sample(&enc, codes, sizeof(codes) / sizeof(codes[0]));
+            enc.time += 3600;
+        } else {
+            uint32_t codes[] = { CT_UNRECEIVED_PREFIX_VALUE, CT_UNRECEIVED_PREFIX_NB_BITS, CT_UNRECEIVED_COUNTER_MAX, CT_UNRECEIVED_COUNTER_NB_BITS };
+            ret = corpus_encoder_sample(&enc, codes, sizeof(codes) / sizeof(codes[0]));
+        }
+        newFrame = (ret == 0);
+    }
+    return (ret < 0) ? ret : corpus_encoder_frame_end(&enc);
+}
+
+//****************************************************************************
+// Every code of the format, in random order
+static int corpus_make_mixed(void)
+{
+    def_corpus_encoder_t enc;
+    uint8_t newFrame = 1;
+    int ret = 0;
+
+    corpus_encoder_begin(&enc, "synth_mixed", 0xdeadbeef);
+    if (!enc.p_corpus) {
+        return -1;
+    }
+    for (uint32_t i = 0; (i < 200000) && (ret >= 0); i++) {
+        uint32_t codes[12];
+        uint8_t nbCodes = 0;
+        uint32_t r = lib_uncompress_corpus_random(&enc.seed) % 100;
+
+        // timestamp
+        if (newFrame || (r < 2)) {
+            codes[nbCodes++] = CT_DIRECT_PREFIX_VALUE;
+            codes[nbCodes++] = CT_DIRECT_PREFIX_NB_BITS;
+            codes[nbCodes++] = enc.time += lib_uncompress_corpus_random(&enc.seed) % 1000;
+            codes[nbCodes++] = CT_DIRECT_NB_BITS;
+        } else if (r < 5) {
+            codes[nbCodes++] = CT_NEW_PERIOD_PREFIX_VALUE;
+            codes[nbCodes++] = CT_NEW_PERIOD_PREFIX_NB_BITS;
+            codes[nbCodes++] = 1 + lib_uncompress_corpus_random(&enc.seed) % 900;
+            codes[nbCodes++] = CT_NEW_PERIOD_NB_BITS;
+        } else if (r < 10) {
+            codes[nbCodes++] = CT_UNRECEIVED_PREFIX_VALUE;
+            codes[nbCodes++] = CT_UNRECEIVED_PREFIX_NB_BITS;
+            codes[nbCodes++] = 1 + lib_uncompress_corpus_random(&enc.seed) % CT_UNRECEIVED_COUNTER_MAX;
+            codes[nbCodes++] = CT_UNRECEIVED_COUNTER_NB_BITS;
+        } else if (r < 15) {
+            codes[nbCodes++] = CT_INVALID_VALUE;
+            codes[nbCodes++] = CT_INVALID_NB_BITS;
+        } else if (r < 25) {
+            codes[nbCodes++] = 0xF;
+            codes[nbCodes++] = 4;
+            codes[nbCodes++] = lib_uncompress_corpus_random(&enc.seed) % 256;
+            codes[nbCodes++] = 8;
+        } else if (r < 40) {
+            codes[nbCodes++] = (r & 1) ? CT_DIFF_PLUS_ONE_VALUE : CT_DIFF_MINUS_ONE_VALUE;
+            codes[nbCodes++] = CT_DIFF_PLUS_ONE_NB_BITS;
+        } else {
+            codes[nbCodes++] = CT_DIFF_UNCHANGED_VALUE;
+            codes[nbCodes++] = CT_DIFF_UNCHANGED_NB_BITS;
+        }
+        // temperature, not after an unreceived run nor a new period
+        if ((r < 2) || (r >= 10) || newFrame) {
+            r = lib_uncompress_corpus_random(&enc.seed) % 100;
+            if (newFrame || (r < 8)) {
+                codes[nbCodes++] = C9_DIRECT_PREFIX_VALUE;
+                codes[nbCodes++] = C9_DIRECT_PREFIX_NB_BITS;
+                codes[nbCodes++] = 3000 + lib_uncompress_corpus_random(&enc.seed) % 1200;
+                codes[nbCodes++] = C9_DIRECT_NB_BITS;
+            } else if (r < 10) {
+                codes[nbCodes++] = C9_DIRECT_PREFIX_VALUE;
+                codes[nbCodes++] = C9_DIRECT_PREFIX_NB_BITS;
+                codes[nbCodes++] = C9_INVALID_TEMPERATURE;
+                codes[nbCodes++] = C9_DIRECT_NB_BITS;
+            } else if (r < 30) {
+                codes[nbCodes++] = 0x7;
+                codes[nbCodes++] = 3;
+                codes[nbCodes++] = lib_uncompress_corpus_random(&enc.seed) % 15;
+                codes[nbCodes++] = 4;
+            } else {
+                codes[nbCodes++] = lib_uncompress_corpus_random(&enc.seed) % 7;
+                codes[nbCodes++] = 3;
+            }
+        }
+        ret = corpus_encoder_sample(&enc, codes, nbCodes);
+        newFrame = (ret == 0);
+    }
+    return (ret < 0) ? ret : corpus_encoder_frame_end(&enc);
+}
+
+//****************************************************************************
+// Random frames: corrupted data, unexpected and truncated codes
+static int corpus_make_random(void)
+{
+    uncompress_corpus_t *p_corpus = corpus_new("synth_random");
+    uint32_t seed = 0x55aa55aa;
+    uint8_t frame[UINT8_MAX + 1];
+
+    if (!p_corpus) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 4000; i++) {
+        frame[0] = (uint8_t)(1 + lib_uncompress_corpus_random(&seed) % UINT8_MAX);
+        for (uint32_t j = 1; j <= frame[0]; j++) {
+            frame[j] = (uint8_t)lib_uncompress_corpus_random(&seed);
+        }
+        if (corpus_append(p_corpus, frame, frame[0] + 1)) {
+            return -1;
+        }
+        p_corpus->nbFrames++;
+    }
+    return 0;
+}
+
+//****************************************************************************
+int lib_uncompress_corpus_make_all(const char *slotsPath, uncompress_corpus_t *corpora, uint32_t *p_nbCorpora)
+{
+    uncompress_corpus_t *slots[UNCOMPRESS_CORPUS_MAX];
+    uint32_t nbSlots = 0;
+    int ret;
+
+    madeCorpora = corpora;
+    nbMadeCorpora = 0;
+    ret = corpus_load_slots(slotsPath, slots, &nbSlots);
+    if (!ret) {
+        ret = corpus_make_concat(slots, nbSlots);
+    }
+    if (!ret) {
+        ret = corpus_make_direct();
+    }
+    if (!ret) {
+        ret = corpus_make_diff8();
+    }
+    if (!ret) {
+        ret = corpus_make_unreceived();
+    }
+    if (!ret) {
+        ret = corpus_make_mixed();
+    }
+    if (!ret) {
+        ret = corpus_make_random();
+    }
+    if (ret) {
+        lib_uncompress_corpus_free(corpora, nbMadeCorpora);
+        nbMadeCorpora = 0;
+    }
+    *p_nbCorpora = nbMadeCorpora;
+    return ret;
+}
+
+//****************************************************************************
+void lib_uncompress_corpus_free(uncompress_corpus_t *corpora, uint32_t nbCorpora)
+{
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        free(corpora[c].data);
+        corpora[c].data = NULL;
+    }
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_corpus_next_frame(const uncompress_corpus_t *p_corpus, uint32_t *p_idx, uint8_t **pp_frame, uint8_t *p_len)
+{
+    uint32_t idx = *p_idx;
+    uint8_t len;
+
+    if (idx >= p_corpus->len) {
+        return 0;
+    }
+    len = p_corpus->data[idx++];
+    if (idx + len > p_corpus->len) {
+        return 0;
+    }
+    *pp_frame = &p_corpus->data[idx];
+    *p_len = len;
+    *p_idx = idx + len;
+    return 1;
+}
+
+//****************************************************************************
+uint8_t lib_uncompress_corpus_frame(uint8_t *frame, const uint32_t *codes, uint16_t nbCodes)
+{
+    def_bitStream_t bs;
+
+    lib_bitStream_create(&bs, frame, UINT8_MAX, 0);
+    for (uint16_t i = 0; i < nbCodes; i += 2) {
+        if (!lib_bitStream_set_bits(&bs, codes[i], (uint8_t)codes[i + 1])) {
+            return 0;
+        }
+    }
+    lib_bitStream_validate(&bs, 1);
+    lib_bitStream_completeLastByte(&bs);
+    return (uint8_t)lib_bitStream_get_len(&bs);
+}
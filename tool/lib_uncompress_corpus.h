@@ -0,0 +1,98 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_corpus.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Corpora of frames shared by uncompress_bench and uncompress_check.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_CORPUS_H
+#define _LIB_UNCOMPRESS_CORPUS_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_CORPUS_MAX       16
+#define UNCOMPRESS_CORPUS_NAME_LEN  32
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+// A dump: frames prefixed by their length on one byte
+typedef struct {
+    char        name[UNCOMPRESS_CORPUS_NAME_LEN];
+    uint8_t     *data;
+    uint32_t    len;
+    uint32_t    size;           // allocated in data
+    uint32_t    nbFrames;
+    uint8_t     isSlot;         // slot of the example application, not made by the tool
+} uncompress_corpus_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Make the corpora: the slots of the example application, their concatenation repeated into a large
+ *        dump, and synthetic dumps made with lib_bitStream_set_bits that stress each path of the decoder.
+ * \param[in] slotsPath the slot data (example/lib/slots_data.dart), each "List<List<int>> name = [[...], ...];"
+ *            of the file is a corpus.
+ * \param[out] corpora at least UNCOMPRESS_CORPUS_MAX corpora.
+ * \param[out] p_nbCorpora number of corpora made, the slots first.
+ * \retval 0 on success, -1 on error (message printed on stderr, corpora freed).
+ * The synthetic corpora only depend on their seed, they are the same on every machine.
+ */
+int lib_uncompress_corpus_make_all(const char *slotsPath, uncompress_corpus_t *corpora, uint32_t *p_nbCorpora);
+
+//****************************************************************************
+/**
+ * \brief Free the corpora made by lib_uncompress_corpus_make_all.
+ * \param[in] corpora the corpora.
+ * \param[in] nbCorpora number of corpora.
+ */
+void lib_uncompress_corpus_free(uncompress_corpus_t *corpora, uint32_t nbCorpora);
+
+//****************************************************************************
+/**
+ * \brief Get the next frame of a corpus.
+ * \param[in] p_corpus the corpus.
+ * \param[in,out] p_idx offset of the length byte of the frame, 0 for the first one, moved to the next frame.
+ * \param[out] pp_frame the frame.
+ * \param[out] p_len len of the frame.
+ * \retval 1 if a frame was read, 0 at the end of the corpus or if the last frame is truncated.
+ */
+uint8_t lib_uncompress_corpus_next_frame(const uncompress_corpus_t *p_corpus, uint32_t *p_idx, uint8_t **pp_frame, uint8_t *p_len);
+
+//****************************************************************************
+/**
+ * \brief Encode a frame, as the device does (last byte completed with 1 bits).
+ * \param[out] frame at least UINT8_MAX bytes.
+ * \param[in] codes pairs of value and number of bits.
+ * \param[in] nbCodes number of values in codes (twice the number of codes).
+ * \retval the len of the frame, 0 if the codes do not fit in a frame.
+ */
+uint8_t lib_uncompress_corpus_frame(uint8_t *frame, const uint32_t *codes, uint16_t nbCodes);
+
+//****************************************************************************
+/**
+ * \brief Pseudo random numbers (xorshift32), the same on every machine.
+ * \param[in,out] p_seed the state, not 0.
+ * \retval the next number.
+ */
+uint32_t lib_uncompress_corpus_random(uint32_t *p_seed);
+
+#endif // _LIB_UNCOMPRESS_CORPUS_H
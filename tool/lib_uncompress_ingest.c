@@ -0,0 +1,702 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_ingest.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Ingest engine for gateways receiving frames of many devices at once.
+  *       Each worker thread owns a bounded lock-free queue (many producers, one
+  *       consumer) and the sessions of the devices hashed to it, so that a
+  *       session is only used by one thread and needs no lock. A session holds
+  *       the decoder state of its device, a reorder window indexed by frame
+  *       counter, and a batch of decoded records given to the sink.
+  *       Atomics use the GCC/clang __atomic builtins.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "project.h"
+#include "lib_uncompress_ingest.h"
+#include "assert.h"
+
+#undef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL 3         // set to 4 to display DEBUG LOGs
+#define NRF_LOG_MODULE_NAME uncompress_ingest
+#include "nrf_log.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define INGEST_MAX_WORKERS      256
+#define INGEST_MIN_BUCKETS      64
+#define INGEST_SPIN_COUNT       128     // empty polls before a worker sleeps
+#define INGEST_CACHE_LINE       64
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+// Queue cell, see lib_uncompress_ingest_push
+typedef struct {
+    uint32_t    seq;            // cell sequence (atomic), not the frame counter
+    uint32_t    deviceId;
+    uint32_t    frameSeq;
+    uint8_t     len;
+    uint8_t     data[UINT8_MAX];
+} def_ingest_cell_t;
+
+// Frame waiting in a reorder window
+typedef struct {
+    uint8_t     used;
+    uint8_t     len;
+    uint32_t    seq;
+    uint64_t    arrivalMs;
+    uint8_t     data[UINT8_MAX];
+} def_ingest_frame_t;
+
+typedef struct def_ingest_session_s {
+    uint32_t    deviceId;
+    uint8_t     started;        // set when the first frame is decoded
+    uint32_t    nextSeq;        // next frame to decode
+    uint32_t    maxSeq;         // highest frame counter received
+    uncompress_state_t state;
+    def_ingest_frame_t *window; // reorderWindow frames, indexed by seq % reorderWindow
+    uint16_t    nbPending;      // frames in window
+    record_t    *batch;
+    uint32_t    nbBatch;
+    void        *p_sinkSession;
+    struct def_ingest_session_s *next;  // hash chain
+} def_ingest_session_t;
+
+typedef struct {
+    // written by producers
+    uint32_t    enqueuePos __attribute__((aligned(INGEST_CACHE_LINE)));
+    uint32_t    sleeping;       // set by the worker before waiting on wakeup
+    uint64_t    nbFull;
+    // owned by the worker
+    uint32_t    dequeuePos __attribute__((aligned(INGEST_CACHE_LINE)));
+    def_ingest_cell_t *cells;
+    uint32_t    mask;
+    struct uncompress_ingest_s *p_ingest;
+    uint16_t    id;
+    pthread_t   thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    samples_t   *p_samples;
+    def_ingest_session_t **buckets;
+    uint32_t    nbBuckets;
+    uint32_t    nbSessions;     // atomic
+    uint64_t    lastTimeoutCheckMs;
+    uncompress_ingest_stats_t stats;    // atomic fields, read by lib_uncompress_ingest_get_stats
+} def_ingest_worker_t;
+
+struct uncompress_ingest_s {
+    uncompress_ingest_config_t config;
+    def_ingest_worker_t *workers;
+    uint32_t    stopping;       // atomic
+};
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static uint64_t ingest_now_ms(void);
+static void *ingest_worker(void *arg);
+static void ingest_handle(def_ingest_worker_t *p_worker, const def_ingest_cell_t *p_cell);
+static uint8_t ingest_keep(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session, const def_ingest_cell_t *p_cell);
+static void ingest_start(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session);
+static void ingest_restart(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session);
+static def_ingest_session_t *ingest_get_session(def_ingest_worker_t *p_worker, uint32_t deviceId);
+static void ingest_decode(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session, uint8_t *data, uint8_t len);
+static void ingest_drain(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session);
+static void ingest_give_up(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session, uint32_t seq);
+static void ingest_flush(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session);
+static void ingest_idle(def_ingest_worker_t *p_worker);
+static void ingest_close_sessions(def_ingest_worker_t *p_worker);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+static uint64_t ingest_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+//****************************************************************************
+static inline def_ingest_worker_t *ingest_worker_of(uncompress_ingest_t *p_ingest, uint32_t deviceId)
+{
+    // devices with close ids are spread over the workers
+    return &p_ingest->workers[(uint32_t)(deviceId * 2654435761u) % p_ingest->config.nbWorkers];
+}
+
+//****************************************************************************
+void lib_uncompress_ingest_config_default(uncompress_ingest_config_t *p_config)
+{
+    ASSERT(p_config);
+    memset(p_config, 0, sizeof(uncompress_ingest_config_t));
+    p_config->queueSize = UNCOMPRESS_INGEST_DEFAULT_QUEUE_SIZE;
+    p_config->reorderWindow = UNCOMPRESS_INGEST_DEFAULT_REORDER_WINDOW;
+    p_config->reorderTimeoutMs = UNCOMPRESS_INGEST_DEFAULT_REORDER_TIMEOUT;
+    p_config->batchSize = UNCOMPRESS_INGEST_DEFAULT_BATCH_SIZE;
+}
+
+//****************************************************************************
+uncompress_ingest_t *lib_uncompress_ingest_start(const uncompress_ingest_config_t *p_config)
+{
+    uncompress_ingest_t *p_ingest;
+    uint32_t queueSize = 2;
+    uint16_t reorderWindow = 1;
+    uint16_t nbStarted = 0;
+
+    if (!p_config || !p_config->sink) {
+        return NULL;
+    }
+    p_ingest = calloc(1, sizeof(uncompress_ingest_t));
+    if (!p_ingest) {
+        return NULL;
+    }
+    p_ingest->config = *p_config;
+    if (!p_ingest->config.nbWorkers) {
+        long nbCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        p_ingest->config.nbWorkers = (nbCpus > 0) ? nbCpus : 1;
+    }
+    if (p_ingest->config.nbWorkers > INGEST_MAX_WORKERS) {
+        p_ingest->config.nbWorkers = INGEST_MAX_WORKERS;
+    }
+    while (queueSize < p_ingest->config.queueSize) {
+        queueSize <<= 1;
+    }
+    // frames are indexed by seq % reorderWindow, which only stays contiguous when the counter
+    // wraps around if reorderWindow divides 2^32
+    while ((reorderWindow < p_ingest->config.reorderWindow) && (reorderWindow < UNCOMPRESS_INGEST_MAX_REORDER_WINDOW)) {
+        reorderWindow <<= 1;
+    }
+    p_ingest->config.reorderWindow = reorderWindow;
+    if (!p_ingest->config.batchSize) {
+        p_ingest->config.batchSize = UNCOMPRESS_INGEST_DEFAULT_BATCH_SIZE;
+    }
+
+    if (posix_memalign((void **)&p_ingest->workers, INGEST_CACHE_LINE,
+                       p_ingest->config.nbWorkers * sizeof(def_ingest_worker_t))) {
+        free(p_ingest);
+        return NULL;
+    }
+    memset(p_ingest->workers, 0, p_ingest->config.nbWorkers * sizeof(def_ingest_worker_t));
+    for (uint16_t w = 0; w < p_ingest->config.nbWorkers; w++) {
+        def_ingest_worker_t *p_worker = &p_ingest->workers[w];
+        p_worker->p_ingest = p_ingest;
+        p_worker->id = w;
+        p_worker->mask = queueSize - 1;
+        p_worker->cells = malloc(queueSize * sizeof(def_ingest_cell_t));
+        p_worker->p_samples = malloc(sizeof(samples_t));
+        p_worker->nbBuckets = INGEST_MIN_BUCKETS;
+        p_worker->buckets = calloc(p_worker->nbBuckets, sizeof(def_ingest_session_t *));
+        pthread_mutex_init(&p_worker->lock, NULL);
+        pthread_cond_init(&p_worker->wakeup, NULL);
+        if (!p_worker->cells || !p_worker->p_samples || !p_worker->buckets) {
+            break;
+        }
+        for (uint32_t i = 0; i < queueSize; i++) {
+            p_worker->cells[i].seq = i;
+        }
+        if (pthread_create(&p_worker->thread, NULL, ingest_worker, p_worker)) {
+            break;
+        }
+        nbStarted++;
+#ifdef __linux__
+        if (p_ingest->config.pinWorkers) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(w % CPU_SETSIZE, &cpus);
+            pthread_setaffinity_np(p_worker->thread, sizeof(cpus), &cpus);
+        }
+#endif
+    }
+    if (nbStarted < p_ingest->config.nbWorkers) {
+        NRF_LOG_ERROR("Cannot start ingest worker %u", nbStarted);
+        p_ingest->config.nbWorkers = nbStarted;     // only stop the started ones
+        free(p_ingest->workers[nbStarted].cells);
+        free(p_ingest->workers[nbStarted].p_samples);
+        free(p_ingest->workers[nbStarted].buckets);
+        lib_uncompress_ingest_stop(p_ingest, NULL);
+        return NULL;
+    }
+    return p_ingest;
+}
+
+//****************************************************************************
+/**
+ * Bounded queue from D. Vyukov: each cell has a sequence number telling whether it can be written
+ * (seq == position) or read (seq == position+1). Producers reserve a position with a CAS on enqueuePos.
+ */
+uint8_t lib_uncompress_ingest_push(uncompress_ingest_t *p_ingest, uint32_t deviceId, uint32_t seq,
+                                   const uint8_t *frame, uint8_t len)
+{
+    def_ingest_worker_t *p_worker;
+    def_ingest_cell_t *p_cell;
+    uint32_t pos;
+
+    if (!p_ingest || !frame || !len) {
+        return 0;
+    }
+    p_worker = ingest_worker_of(p_ingest, deviceId);
+    pos = __atomic_load_n(&p_worker->enqueuePos, __ATOMIC_RELAXED);
+    for (;;) {
+        int32_t diff;
+        p_cell = &p_worker->cells[pos & p_worker->mask];
+        diff = (int32_t)(__atomic_load_n(&p_cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&p_worker->enqueuePos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&p_worker->nbFull, 1, __ATOMIC_RELAXED);
+            return 0;
+        } else {
+            pos = __atomic_load_n(&p_worker->enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+    p_cell->deviceId = deviceId;
+    p_cell->frameSeq = seq;
+    p_cell->len = len;
+    memcpy(p_cell->data, frame, len);
+    __atomic_store_n(&p_cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // wake the worker up if it is waiting (it sets sleeping then checks the queue again)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&p_worker->sleeping, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&p_worker->lock);
+        pthread_cond_signal(&p_worker->wakeup);
+        pthread_mutex_unlock(&p_worker->lock);
+    }
+    return 1;
+}
+
+//****************************************************************************
+static void *ingest_worker(void *arg)
+{
+    def_ingest_worker_t *p_worker = arg;
+    uncompress_ingest_t *p_ingest = p_worker->p_ingest;
+    uint32_t nbEmpty = 0;
+
+    for (;;) {
+        def_ingest_cell_t *p_cell = &p_worker->cells[p_worker->dequeuePos & p_worker->mask];
+        uint32_t seq = __atomic_load_n(&p_cell->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == p_worker->dequeuePos + 1) {
+            ingest_handle(p_worker, p_cell);
+            __atomic_store_n(&p_cell->seq, p_worker->dequeuePos + p_worker->mask + 1, __ATOMIC_RELEASE);
+            p_worker->dequeuePos++;
+            nbEmpty = 0;
+            continue;
+        }
+        // queue empty
+        if (__atomic_load_n(&p_ingest->stopping, __ATOMIC_ACQUIRE)) {
+            // stopping is set after the last push, check the queue once more
+            if (__atomic_load_n(&p_cell->seq, __ATOMIC_ACQUIRE) != p_worker->dequeuePos + 1) {
+                break;
+            }
+            continue;
+        }
+        if (nbEmpty == 0) {
+            ingest_idle(p_worker);
+        }
+        if (++nbEmpty < INGEST_SPIN_COUNT) {
+            sched_yield();
+            continue;
+        }
+        // sleep until a push, the stop, or the next reorder timeout check
+        pthread_mutex_lock(&p_worker->lock);
+        __atomic_store_n(&p_worker->sleeping, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((__atomic_load_n(&p_cell->seq, __ATOMIC_ACQUIRE) != p_worker->dequeuePos + 1)
+            && !__atomic_load_n(&p_ingest->stopping, __ATOMIC_ACQUIRE)) {
+            struct timespec ts;
+            uint32_t waitMs = p_ingest->config.reorderTimeoutMs ? p_ingest->config.reorderTimeoutMs / 2 + 1 : 1000;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += waitMs / 1000;
+            ts.tv_nsec += (waitMs % 1000) * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&p_worker->wakeup, &p_worker->lock, &ts);
+        }
+        __atomic_store_n(&p_worker->sleeping, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&p_worker->lock);
+        nbEmpty = 0;
+    }
+    ingest_close_sessions(p_worker);
+    return NULL;
+}
+
+//****************************************************************************
+static def_ingest_session_t *ingest_get_session(def_ingest_worker_t *p_worker, uint32_t deviceId)
+{
+    uncompress_ingest_t *p_ingest = p_worker->p_ingest;
+    uint32_t bucket = deviceId & (p_worker->nbBuckets - 1);
+    def_ingest_session_t *p_session;
+
+    for (p_session = p_worker->buckets[bucket]; p_session; p_session = p_session->next) {
+        if (p_session->deviceId == deviceId) {
+            return p_session;
+        }
+    }
+
+    if (p_worker->nbSessions >= p_worker->nbBuckets) {
+        // keep chains short: double the buckets
+        uint32_t nbBuckets = p_worker->nbBuckets * 2;
+        def_ingest_session_t **buckets = calloc(nbBuckets, sizeof(def_ingest_session_t *));
+        if (buckets) {
+            for (uint32_t i = 0; i < p_worker->nbBuckets; i++) {
+                while (p_worker->buckets[i]) {
+                    def_ingest_session_t *p_moved = p_worker->buckets[i];
+                    p_worker->buckets[i] = p_moved->next;
+                    p_moved->next = buckets[p_moved->deviceId & (nbBuckets - 1)];
+                    buckets[p_moved->deviceId & (nbBuckets - 1)] = p_moved;
+                }
+            }
+            free(p_worker->buckets);
+            p_worker->buckets = buckets;
+            p_worker->nbBuckets = nbBuckets;
+            bucket = deviceId & (nbBuckets - 1);
+        }
+    }
+
+    p_session = calloc(1, sizeof(def_ingest_session_t));
+    if (!p_session) {
+        return NULL;
+    }
+    p_session->window = calloc(p_ingest->config.reorderWindow, sizeof(def_ingest_frame_t));
+    p_session->batch = malloc(p_ingest->config.batchSize * sizeof(record_t));
+    if (!p_session->window || !p_session->batch) {
+        free(p_session->window);
+        free(p_session->batch);
+        free(p_session);
+        return NULL;
+    }
+    p_session->deviceId = deviceId;
+    lib_uncompress_state_init(&p_session->state);
+    p_session->next = p_worker->buckets[bucket];
+    p_worker->buckets[bucket] = p_session;
+    __atomic_store_n(&p_worker->nbSessions, p_worker->nbSessions + 1, __ATOMIC_RELAXED);
+    return p_session;
+}
+
+//****************************************************************************
+// Keep a frame in the reorder window of the session. Returns 0 if it is already there.
+static uint8_t ingest_keep(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session, const def_ingest_cell_t *p_cell)
+{
+    def_ingest_frame_t *p_frame = &p_session->window[p_cell->frameSeq % p_worker->p_ingest->config.reorderWindow];
+
+    if (p_frame->used) {
+        __atomic_fetch_add(&p_worker->stats.nbDuplicates, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    p_frame->used = 1;
+    p_frame->seq = p_cell->frameSeq;
+    p_frame->len = p_cell->len;
+    p_frame->arrivalMs = ingest_now_ms();
+    memcpy(p_frame->data, p_cell->data, p_cell->len);
+    p_session->nbPending++;
+    if ((int32_t)(p_cell->frameSeq - p_session->maxSeq) > 0) {
+        p_session->maxSeq = p_cell->frameSeq;
+    }
+    return 1;
+}
+
+//****************************************************************************
+// Start decoding a new session from the oldest frame received
+static void ingest_start(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session)
+{
+    p_session->started = 1;
+    ingest_drain(p_worker, p_session);
+}
+
+//****************************************************************************
+// The counter of the device went back: it restarted, the frames received next are a new stream
+static void ingest_restart(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session)
+{
+    NRF_LOG_WARNING("Device %u: counter gone back after %u, new stream", p_session->deviceId, p_session->maxSeq);
+    if (p_session->nbPending) {
+        ingest_give_up(p_worker, p_session, p_session->maxSeq + 1);
+    }
+    __atomic_fetch_add(&p_worker->stats.nbRestarts, 1, __ATOMIC_RELAXED);
+    p_session->started = 0;
+    lib_uncompress_state_init(&p_session->state);
+}
+
+//****************************************************************************
+static void ingest_handle(def_ingest_worker_t *p_worker, const def_ingest_cell_t *p_cell)
+{
+    uint16_t window = p_worker->p_ingest->config.reorderWindow;
+    def_ingest_session_t *p_session = ingest_get_session(p_worker, p_cell->deviceId);
+    int32_t ahead;
+
+    if (!p_session) {
+        NRF_LOG_ERROR("No memory for device %u", p_cell->deviceId);
+        __atomic_fetch_add(&p_worker->stats.nbLost, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (!p_session->started) {
+        // The first frames of a device are only kept: the first counter is not known, an older frame may
+        // still come. Decoding starts when half of the window is used, or after reorderTimeoutMs.
+        if (!p_session->nbPending) {
+            p_session->nextSeq = p_session->maxSeq = p_cell->frameSeq;
+        } else if (((int32_t)(p_cell->frameSeq - p_session->nextSeq) < 0)
+                   && (p_session->maxSeq - p_cell->frameSeq < window)) {
+            p_session->nextSeq = p_cell->frameSeq;
+        }
+        ahead = (int32_t)(p_cell->frameSeq - p_session->nextSeq);
+        if ((ahead >= 0) && (ahead < window)) {
+            if (ingest_keep(p_worker, p_session, p_cell) && (p_session->nbPending > window / 2)) {
+                ingest_start(p_worker, p_session);
+            }
+            return;
+        }
+        ingest_start(p_worker, p_session);
+    }
+
+    ahead = (int32_t)(p_cell->frameSeq - p_session->nextSeq);
+    if (ahead < -(int32_t)window) {
+        // too old for a duplicate: handled as the first frame of the new stream
+        ingest_restart(p_worker, p_session);
+        ingest_handle(p_worker, p_cell);
+        return;
+    }
+    if (ahead < 0) {
+        __atomic_fetch_add(&p_worker->stats.nbDuplicates, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (ahead == 0) {
+        ingest_decode(p_worker, p_session, (uint8_t *)p_cell->data, p_cell->len);
+        p_session->nextSeq++;
+        ingest_drain(p_worker, p_session);
+        return;
+    }
+    // a previous frame is missing, keep this one
+    if (ahead >= window) {
+        ingest_give_up(p_worker, p_session, p_cell->frameSeq - window + 1);
+    }
+    if (ingest_keep(p_worker, p_session, p_cell)) {
+        __atomic_fetch_add(&p_worker->stats.nbReordered, 1, __ATOMIC_RELAXED);
+        if (p_session->nextSeq == p_cell->frameSeq) {
+            // the missing frames were just given up
+            ingest_drain(p_worker, p_session);
+        }
+    }
+}
+
+//****************************************************************************
+static void ingest_decode(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session, uint8_t *data, uint8_t len)
+{
+    uncompress_ingest_t *p_ingest = p_worker->p_ingest;
+    samples_t *p_samples = p_worker->p_samples;
+    uint32_t done = 0;
+
+    lib_uncompress_state_new_frame(&p_session->state);
+    if (p_ingest->config.resync) {
+        lib_uncompress_data_resync(data, len, p_samples, &p_session->state, NULL, NULL);
+    } else if (!lib_uncompress_data_with_state(data, len, p_samples, &p_session->state)) {
+        p_samples->nbSamples = 0;
+    }
+    __atomic_fetch_add(&p_worker->stats.nbFrames, 1, __ATOMIC_RELAXED);
+    while (done < p_samples->nbSamples) {
+        uint32_t nb = p_ingest->config.batchSize - p_session->nbBatch;
+        if (nb > p_samples->nbSamples - done) {
+            nb = p_samples->nbSamples - done;
+        }
+        memcpy(&p_session->batch[p_session->nbBatch], &p_samples->samples[done], nb * sizeof(record_t));
+        p_session->nbBatch += nb;
+        done += nb;
+        if (p_session->nbBatch == p_ingest->config.batchSize) {
+            ingest_flush(p_worker, p_session);
+        }
+    }
+}
+
+//****************************************************************************
+// Decode the frames of the window following nextSeq
+static void ingest_drain(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session)
+{
+    uint16_t window = p_worker->p_ingest->config.reorderWindow;
+
+    while (p_session->nbPending) {
+        def_ingest_frame_t *p_frame = &p_session->window[p_session->nextSeq % window];
+        if (!p_frame->used || (p_frame->seq != p_session->nextSeq)) {
+            break;
+        }
+        ingest_decode(p_worker, p_session, p_frame->data, p_frame->len);
+        p_frame->used = 0;
+        p_session->nbPending--;
+        p_session->nextSeq++;
+    }
+}
+
+//****************************************************************************
+// Stop waiting for the frames before seq: decode the ones received, count the others as lost
+static void ingest_give_up(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session, uint32_t seq)
+{
+    uint16_t window = p_worker->p_ingest->config.reorderWindow;
+    uint32_t nbMissing = seq - p_session->nextSeq;
+    uint32_t nbChecked = (nbMissing < window) ? nbMissing : window;
+
+    // frames before seq are all in the window (at most window frames ahead of nextSeq)
+    for (uint32_t i = 0; i < nbChecked; i++) {
+        def_ingest_frame_t *p_frame = &p_session->window[(p_session->nextSeq + i) % window];
+        if (p_frame->used && (p_frame->seq == p_session->nextSeq + i)) {
+            ingest_decode(p_worker, p_session, p_frame->data, p_frame->len);
+            p_frame->used = 0;
+            p_session->nbPending--;
+            nbMissing--;
+        }
+    }
+    NRF_LOG_WARNING("Device %u: %u frames lost before %u", p_session->deviceId, nbMissing, seq);
+    __atomic_fetch_add(&p_worker->stats.nbLost, nbMissing, __ATOMIC_RELAXED);
+    p_session->nextSeq = seq;
+    ingest_drain(p_worker, p_session);
+}
+
+//****************************************************************************
+static void ingest_flush(def_ingest_worker_t *p_worker, def_ingest_session_t *p_session)
+{
+    uncompress_ingest_t *p_ingest = p_worker->p_ingest;
+
+    if (!p_session->nbBatch) {
+        return;
+    }
+    p_ingest->config.sink(p_ingest->config.p_user, p_session->deviceId, &p_session->p_sinkSession,
+                          p_session->batch, p_session->nbBatch);
+    __atomic_fetch_add(&p_worker->stats.nbSamples, p_session->nbBatch, __ATOMIC_RELAXED);
+    p_session->nbBatch = 0;
+}
+
+//****************************************************************************
+// Called when the queue becomes empty: give the batches to the sink, and give up missing frames too old
+static void ingest_idle(def_ingest_worker_t *p_worker)
+{
+    uncompress_ingest_t *p_ingest = p_worker->p_ingest;
+    uint64_t now = ingest_now_ms();
+    uint8_t checkTimeout = (now - p_worker->lastTimeoutCheckMs) >= p_ingest->config.reorderTimeoutMs / 2;
+    uint16_t window = p_ingest->config.reorderWindow;
+
+    if (checkTimeout) {
+        p_worker->lastTimeoutCheckMs = now;
+    }
+    for (uint32_t b = 0; b < p_worker->nbBuckets; b++) {
+        for (def_ingest_session_t *p_session = p_worker->buckets[b]; p_session; p_session = p_session->next) {
+            if (checkTimeout && !p_session->started && p_session->nbPending) {
+                def_ingest_frame_t *p_first = &p_session->window[p_session->nextSeq % window];
+                if (now - p_first->arrivalMs >= p_ingest->config.reorderTimeoutMs) {
+                    ingest_start(p_worker, p_session);
+                }
+            }
+            if (checkTimeout && p_session->started && p_session->nbPending) {
+                // oldest frame received after the gap
+                for (uint16_t i = 1; i < window; i++) {
+                    def_ingest_frame_t *p_frame = &p_session->window[(p_session->nextSeq + i) % window];
+                    if (p_frame->used && (p_frame->seq == p_session->nextSeq + i)) {
+                        if (now - p_frame->arrivalMs >= p_ingest->config.reorderTimeoutMs) {
+                            ingest_give_up(p_worker, p_session, p_frame->seq);
+                        }
+                        break;
+                    }
+                }
+            }
+            ingest_flush(p_worker, p_session);
+        }
+    }
+}
+
+//****************************************************************************
+static void ingest_close_sessions(def_ingest_worker_t *p_worker)
+{
+    uncompress_ingest_t *p_ingest = p_worker->p_ingest;
+
+    for (uint32_t b = 0; b < p_worker->nbBuckets; b++) {
+        while (p_worker->buckets[b]) {
+            def_ingest_session_t *p_session = p_worker->buckets[b];
+            p_worker->buckets[b] = p_session->next;
+            if (!p_session->started) {
+                ingest_start(p_worker, p_session);
+            }
+            if (p_session->nbPending) {
+                ingest_give_up(p_worker, p_session, p_session->maxSeq + 1);
+            }
+            ingest_flush(p_worker, p_session);
+            p_ingest->config.sink(p_ingest->config.p_user, p_session->deviceId, &p_session->p_sinkSession, NULL, 0);
+            free(p_session->window);
+            free(p_session->batch);
+            free(p_session);
+        }
+    }
+}
+
+//****************************************************************************
+void lib_uncompress_ingest_get_stats(uncompress_ingest_t *p_ingest, uncompress_ingest_stats_t *p_stats)
+{
+    ASSERT(p_ingest);
+    ASSERT(p_stats);
+    memset(p_stats, 0, sizeof(uncompress_ingest_stats_t));
+    for (uint16_t w = 0; w < p_ingest->config.nbWorkers; w++) {
+        def_ingest_worker_t *p_worker = &p_ingest->workers[w];
+        p_stats->nbFrames += __atomic_load_n(&p_worker->stats.nbFrames, __ATOMIC_RELAXED);
+        p_stats->nbSamples += __atomic_load_n(&p_worker->stats.nbSamples, __ATOMIC_RELAXED);
+        p_stats->nbFull += __atomic_load_n(&p_worker->nbFull, __ATOMIC_RELAXED);
+        p_stats->nbDuplicates += __atomic_load_n(&p_worker->stats.nbDuplicates, __ATOMIC_RELAXED);
+        p_stats->nbReordered += __atomic_load_n(&p_worker->stats.nbReordered, __ATOMIC_RELAXED);
+        p_stats->nbLost += __atomic_load_n(&p_worker->stats.nbLost, __ATOMIC_RELAXED);
+        p_stats->nbRestarts += __atomic_load_n(&p_worker->stats.nbRestarts, __ATOMIC_RELAXED);
+        p_stats->nbDevices += __atomic_load_n(&p_worker->nbSessions, __ATOMIC_RELAXED);
+    }
+}
+
+//****************************************************************************
+void lib_uncompress_ingest_stop(uncompress_ingest_t *p_ingest, uncompress_ingest_stats_t *p_stats)
+{
+    if (!p_ingest) {
+        return;
+    }
+    __atomic_store_n(&p_ingest->stopping, 1, __ATOMIC_RELEASE);
+    for (uint16_t w = 0; w < p_ingest->config.nbWorkers; w++) {
+        def_ingest_worker_t *p_worker = &p_ingest->workers[w];
+        pthread_mutex_lock(&p_worker->lock);
+        pthread_cond_signal(&p_worker->wakeup);
+        pthread_mutex_unlock(&p_worker->lock);
+        pthread_join(p_worker->thread, NULL);
+    }
+    if (p_stats) {
+        lib_uncompress_ingest_get_stats(p_ingest, p_stats);
+    }
+    for (uint16_t w = 0; w < p_ingest->config.nbWorkers; w++) {
+        def_ingest_worker_t *p_worker = &p_ingest->workers[w];
+        pthread_mutex_destroy(&p_worker->lock);
+        pthread_cond_destroy(&p_worker->wakeup);
+        free(p_worker->cells);
+        free(p_worker->p_samples);
+        free(p_worker->buckets);
+    }
+    free(p_ingest->workers);
+    free(p_ingest);
+}
@@ -0,0 +1,127 @@
+/**
+  ******************************************************************************
+  * \file lib_uncompress_ingest.h
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Ingest engine decoding frames of many devices in parallel.
+  ******************************************************************************
+  */
+#ifndef _LIB_UNCOMPRESS_INGEST_H
+#define _LIB_UNCOMPRESS_INGEST_H
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_compress_defines.h"
+#include "lib_uncompress.h"
+
+//****************************************************************************
+// extern Defines and enum typedef
+//****************************************************************************
+#define UNCOMPRESS_INGEST_DEFAULT_QUEUE_SIZE        4096    // frames per worker
+#define UNCOMPRESS_INGEST_DEFAULT_REORDER_WINDOW    32      // frames
+#define UNCOMPRESS_INGEST_MAX_REORDER_WINDOW        256
+#define UNCOMPRESS_INGEST_DEFAULT_REORDER_TIMEOUT   2000    // ms
+#define UNCOMPRESS_INGEST_DEFAULT_BATCH_SIZE        4096    // records
+
+//****************************************************************************
+// extern Structures typedef
+//****************************************************************************
+typedef struct uncompress_ingest_s uncompress_ingest_t;  // opaque, allocated by lib_uncompress_ingest_start
+
+/**
+ * Receives the decoded records of a device, in frame order.
+ * p_user is the pointer given in the config. pp_session points to a pointer kept in the device session for the
+ * sink, NULL at the first call. The last call for a device has records NULL and nbRecords 0.
+ * The sink is called from the worker thread of the device: never concurrently for one device, but concurrently
+ * for devices handled by different workers.
+ */
+typedef void (*uncompress_ingest_sink_t)(void *p_user, uint32_t deviceId, void **pp_session,
+                                         const record_t *records, uint32_t nbRecords);
+
+typedef struct {
+    uint16_t    nbWorkers;          // decoding threads, 0 for the number of CPUs
+    uint32_t    queueSize;          // frames waiting per worker, rounded up to a power of 2
+    uint16_t    reorderWindow;      // frames kept per device while a previous one is missing, rounded up to a power of 2
+    uint32_t    reorderTimeoutMs;   // a missing frame is given up after this delay
+    uint32_t    batchSize;          // records given to the sink at once (less when a worker is idle)
+    uint8_t     pinWorkers;         // pin worker i to CPU i (Linux)
+    uint8_t     resync;             // decode with lib_uncompress_data_resync
+    uncompress_ingest_sink_t sink;
+    void        *p_user;
+} uncompress_ingest_config_t;
+
+typedef struct {
+    uint64_t    nbFrames;           // frames decoded
+    uint64_t    nbSamples;          // records given to the sink
+    uint64_t    nbFull;             // frames refused by lib_uncompress_ingest_push, queue full
+    uint64_t    nbDuplicates;       // frames received twice, or after they were given up
+    uint64_t    nbReordered;        // frames received before a previous one
+    uint64_t    nbLost;             // missing frames given up
+    uint64_t    nbRestarts;         // frame counters gone back by more than the window (device restarted)
+    uint32_t    nbDevices;
+} uncompress_ingest_stats_t;
+
+//****************************************************************************
+// extern Variables
+//****************************************************************************
+
+//****************************************************************************
+// extern Functions prototypes
+//****************************************************************************
+
+//****************************************************************************
+/**
+ * \brief Fill an ingest config with the default values (no sink).
+ * \param[out] p_config the config.
+ */
+void lib_uncompress_ingest_config_default(uncompress_ingest_config_t *p_config);
+
+//****************************************************************************
+/**
+ * \brief Create the engine and start its workers.
+ * \param[in] p_config the config, copied.
+ * \retval the engine, NULL on error.
+ * Each device is handled by one worker (chosen from its id), which owns the device session:
+ * decoder state, reorder buffer and output batch. Sessions are created on the first frame.
+ */
+uncompress_ingest_t *lib_uncompress_ingest_start(const uncompress_ingest_config_t *p_config);
+
+//****************************************************************************
+/**
+ * \brief Give a frame to the engine. Can be called from any number of threads, does not lock.
+ * \param[in] p_ingest the engine.
+ * \param[in] deviceId the device which sent the frame.
+ * \param[in] seq frame counter of the device, frames are decoded in this order. A counter more than
+ *            reorderWindow behind the next one expected starts a new stream: the frames pending are
+ *            given up and the device is decoded from a new state, as after its first frame.
+ * \param[in] frame the compressed frame, copied.
+ * \param[in] len len of the frame, in bytes.
+ * \retval 1 on success, 0 if the queue of the worker is full (try again later).
+ */
+uint8_t lib_uncompress_ingest_push(uncompress_ingest_t *p_ingest, uint32_t deviceId, uint32_t seq,
+                                   const uint8_t *frame, uint8_t len);
+
+//****************************************************************************
+/**
+ * \brief Get the engine counters.
+ * \param[in] p_ingest the engine.
+ * \param[out] p_stats the counters.
+ */
+void lib_uncompress_ingest_get_stats(uncompress_ingest_t *p_ingest, uncompress_ingest_stats_t *p_stats);
+
+//****************************************************************************
+/**
+ * \brief Decode the frames pushed, close the sessions and free the engine.
+ * \param[in] p_ingest the engine, may be NULL.
+ * \param[out] p_stats the final counters, may be NULL.
+ * Missing frames are given up, so all the frames received are decoded. No frame must be pushed
+ * during or after this call.
+ */
+void lib_uncompress_ingest_stop(uncompress_ingest_t *p_ingest, uncompress_ingest_stats_t *p_stats);
+
+#endif // _LIB_UNCOMPRESS_INGEST_H
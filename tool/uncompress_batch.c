@@ -0,0 +1,803 @@
+/**
+  ******************************************************************************
+  * \file uncompress_batch.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Linux command line tool converting frame dumps to CSV or columnar files.
+  *       A dump is the list of compressed frames as received from the device,
+  *       each frame prefixed by its length on one byte. Frames are decoded as
+  *       the application does (lib_uncompress_data on each frame, in order).
+  *       Input files are mapped in memory and converted in parallel by a pool
+  *       of threads; each thread owns a queue of files, largest first, and
+  *       steals the smallest files of the other queues when its own is empty.
+  *
+  *       usage: uncompress_batch [-j threads] [-f csv|col] [-o dir] [-r] [-q] input...
+  *       An input is a dump or a directory of dumps. The output of dir/name.bin
+  *       is <dir or -o>/name.csv (or name.col), written to a hidden temporary file
+  *       renamed once complete. Inputs which are outputs (.csv or .col files) are
+  *       skipped, so that the tool can be run again on the same directory. Inputs
+  *       with the same output (same name in two directories with -o, or with two
+  *       extensions) are refused, except the first one.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_uncompress.h"
+#include "lib_uncompress_stats.h"
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define BATCH_OUT_BUFFER_SIZE   (4UL * 1024 * 1024)     // bytes written at once
+#define BATCH_MAX_THREADS       64
+#define BATCH_COL_ROW_GROUP     65536                   // rows per row group in columnar files
+#define BATCH_COL_MAGIC         "BCCL"
+#define BATCH_COL_VERSION       1
+#define BATCH_COL_GROUP_HEADER  16                      // bytes before the values of a row group
+#define BATCH_CSV_SUFFIX        ".csv"
+#define BATCH_COL_SUFFIX        ".col"
+
+typedef enum {
+    BATCH_FORMAT_CSV,   // "time;temperature" lines, as written by the application
+    BATCH_FORMAT_COL,   // columnar, see batch_col_write_group
+} def_batch_format_t;
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+// A file to convert, and its results
+typedef struct {
+    char        *inPath;
+    char        *outPath;
+    char        *outKey;        // outPath in the resolved directory, equal for inputs with the same output
+    char        *tmpPath;       // written, then renamed to outPath
+    uint64_t    size;
+    uint32_t    nbFrames;
+    uint32_t    nbBadFrames;    // frames without any sample
+    uint64_t    nbSamples;
+    uint32_t    nbResyncs;
+    double      seconds;
+    uint8_t     error;
+} def_batch_file_t;
+
+// Queue of files of a worker. The owner takes from head (largest files), thieves from tail.
+typedef struct {
+    pthread_mutex_t lock;
+    uint32_t    *items;         // indexes in files
+    uint32_t    head;
+    uint32_t    tail;           // one past the last item
+} def_batch_queue_t;
+
+typedef struct {
+    def_batch_file_t    *files;
+    uint32_t            nbFiles;
+    uint32_t            maxFiles;   // allocated in files
+    def_batch_queue_t   *queues;
+    uint32_t            nbWorkers;
+    def_batch_format_t  format;
+    uint8_t             resync;     // use lib_uncompress_data_resync
+    uint8_t             quiet;
+    pthread_mutex_t     printLock;
+} def_batch_t;
+
+typedef struct {
+    def_batch_t *p_batch;
+    uint32_t    id;
+    pthread_t   thread;
+    samples_t   *p_samples;     // one frame
+    uint8_t     *out;           // output buffer
+    uint32_t    outLen;
+    int         fd;             // output file
+    uint8_t     writeError;
+    uncompress_writer_t writer; // CSV, formatted in out
+    uint32_t    *times;         // current row group (columnar format)
+    int16_t     *tempes;
+    uint32_t    nbRows;
+    uint8_t     *colBytes;      // row group serialized in little endian
+} def_batch_worker_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static double batch_now(void);
+static int batch_add_input(def_batch_t *p_batch, const char *path, const char *outDir);
+static int batch_has_suffix(const char *name, const char *suffix);
+static int batch_add_file(def_batch_t *p_batch, const char *path, const struct stat *p_st, const char *outDir);
+static int batch_compare_size(const void *a, const void *b);
+static int batch_compare_output(const void *a, const void *b);
+static uint32_t batch_remove_collisions(def_batch_t *p_batch);
+static int batch_take(def_batch_t *p_batch, uint32_t id, uint32_t *p_index);
+static void *batch_worker(void *arg);
+static void batch_convert_file(def_batch_worker_t *p_worker, def_batch_file_t *p_file);
+static int batch_open_output(def_batch_file_t *p_file);
+static void batch_flush(def_batch_worker_t *p_worker);
+static void batch_write(def_batch_worker_t *p_worker, const void *data, uint32_t len);
+static uint8_t batch_writer_flush(void *p_user, const uint8_t *data, uint32_t len);
+static uint8_t *batch_put_u16(uint8_t *p, uint16_t value);
+static uint8_t *batch_put_u32(uint8_t *p, uint32_t value);
+static void batch_col_add(def_batch_worker_t *p_worker, const samples_t *p_samples);
+static void batch_col_write_group(def_batch_worker_t *p_worker);
+static void batch_usage(const char *name);
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+static double batch_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//****************************************************************************
+static int batch_has_suffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name), suffixLen = strlen(suffix);
+    return (len > suffixLen) && !strcmp(name + len - suffixLen, suffix);
+}
+
+//****************************************************************************
+static int batch_add_file(def_batch_t *p_batch, const char *path, const struct stat *p_st, const char *outDir)
+{
+    def_batch_file_t *p_file;
+    const char *base = strrchr(path, '/');
+    const char *ext;
+    size_t dirLen, baseLen;
+    const char *suffix = (p_batch->format == BATCH_FORMAT_CSV) ? BATCH_CSV_SUFFIX : BATCH_COL_SUFFIX;
+    char *realDir, *resolved;
+    struct stat outSt;
+
+    if (batch_has_suffix(path, suffix)) {
+        fprintf(stderr, "%s: skipped, already a %s file\n", path, suffix);
+        return 0;
+    }
+
+    if (p_batch->nbFiles == p_batch->maxFiles) {
+        uint32_t maxFiles = p_batch->maxFiles ? 2 * p_batch->maxFiles : 64;
+        def_batch_file_t *files = realloc(p_batch->files, maxFiles * sizeof(def_batch_file_t));
+        if (!files) {
+            return -1;
+        }
+        p_batch->files = files;
+        p_batch->maxFiles = maxFiles;
+    }
+    base = base ? base + 1 : path;
+    ext = strrchr(base, '.');
+    baseLen = (ext && (ext != base)) ? (size_t)(ext - base) : strlen(base);
+    if (!outDir) {
+        outDir = ".";
+        dirLen = base - path;
+        if (dirLen) {
+            outDir = path;
+            dirLen--;       // without the '/'
+        } else {
+            dirLen = 1;
+        }
+    } else {
+        dirLen = strlen(outDir);
+    }
+
+    p_file = &p_batch->files[p_batch->nbFiles];
+    memset(p_file, 0, sizeof(def_batch_file_t));
+    p_file->inPath = strdup(path);
+    p_file->outPath = malloc(dirLen + 1 + baseLen + strlen(suffix) + 1);
+    realDir = strndup(outDir, dirLen);
+    if (!p_file->inPath || !p_file->outPath || !realDir) {
+        free(p_file->inPath);
+        free(p_file->outPath);
+        free(realDir);
+        return -1;
+    }
+    sprintf(p_file->outPath, "%.*s/%.*s%s", (int)dirLen, outDir, (int)baseLen, base, suffix);
+    // the output would truncate the input while it is mapped
+    if (!stat(p_file->outPath, &outSt) && (outSt.st_dev == p_st->st_dev) && (outSt.st_ino == p_st->st_ino)) {
+        fprintf(stderr, "%s: skipped, it is its own output\n", path);
+        free(p_file->inPath);
+        free(p_file->outPath);
+        free(realDir);
+        return 0;
+    }
+    // "a/x.bin" and "./a/x.txt" have the same output
+    resolved = realpath(realDir, NULL);
+    free(realDir);
+    realDir = resolved ? resolved : strndup(outDir, dirLen);
+    p_file->outKey = realDir ? malloc(strlen(realDir) + 1 + baseLen + strlen(suffix) + 1) : NULL;
+    // hidden, so that a directory scan skips it if it is left by a crash
+    p_file->tmpPath = malloc(dirLen + 2 + baseLen + strlen(suffix) + 8);
+    if (!p_file->outKey || !p_file->tmpPath) {
+        free(p_file->inPath);
+        free(p_file->outPath);
+        free(p_file->outKey);
+        free(p_file->tmpPath);
+        free(realDir);
+        return -1;
+    }
+    sprintf(p_file->outKey, "%s/%.*s%s", realDir, (int)baseLen, base, suffix);
+    free(realDir);
+    sprintf(p_file->tmpPath, "%.*s/.%.*s%s.XXXXXX", (int)dirLen, outDir, (int)baseLen, base, suffix);
+    p_file->size = p_st->st_size;
+    p_batch->nbFiles++;
+    return 0;
+}
+
+//****************************************************************************
+static int batch_add_input(def_batch_t *p_batch, const char *path, const char *outDir)
+{
+    struct stat st;
+    DIR *dir;
+    struct dirent *entry;
+    int ret = 0;
+
+    if (stat(path, &st)) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (S_ISREG(st.st_mode)) {
+        return batch_add_file(p_batch, path, &st, outDir);
+    }
+    if (!S_ISDIR(st.st_mode) || !(dir = opendir(path))) {
+        fprintf(stderr, "%s: not a file or a directory\n", path);
+        return -1;
+    }
+    while (!ret && (entry = readdir(dir))) {
+        char *child;
+        // hidden files, and the outputs of a previous run in either format
+        if ((entry->d_name[0] == '.') || batch_has_suffix(entry->d_name, BATCH_CSV_SUFFIX) ||
+            batch_has_suffix(entry->d_name, BATCH_COL_SUFFIX)) {
+            continue;
+        }
+        child = malloc(strlen(path) + 1 + strlen(entry->d_name) + 1);
+        if (!child) {
+            ret = -1;
+            break;
+        }
+        sprintf(child, "%s/%s", path, entry->d_name);
+        if (!stat(child, &st) && S_ISREG(st.st_mode)) {
+            ret = batch_add_file(p_batch, child, &st, outDir);
+        }
+        free(child);
+    }
+    closedir(dir);
+    return ret;
+}
+
+//****************************************************************************
+static int batch_compare_size(const void *a, const void *b)
+{
+    const def_batch_file_t *fa = a;
+    const def_batch_file_t *fb = b;
+    return (fa->size < fb->size) - (fa->size > fb->size);   // largest first
+}
+
+//****************************************************************************
+static int batch_compare_output(const void *a, const void *b)
+{
+    const def_batch_file_t *fa = *(const def_batch_file_t * const *)a;
+    const def_batch_file_t *fb = *(const def_batch_file_t * const *)b;
+    int ret = strcmp(fa->outKey, fb->outKey);
+    return ret ? ret : (fa > fb) - (fa < fb);   // in the order of the inputs
+}
+
+//****************************************************************************
+/**
+ * An input with the output of a previous one would overwrite it when renamed: it is removed, the others are
+ * converted. Returns the number of inputs removed.
+ */
+static uint32_t batch_remove_collisions(def_batch_t *p_batch)
+{
+    def_batch_file_t **sorted = malloc(p_batch->nbFiles * sizeof(def_batch_file_t *));
+    uint32_t nbRemoved = 0, nbKept = 0, first = 0;
+
+    if (!sorted) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < p_batch->nbFiles; i++) {
+        sorted[i] = &p_batch->files[i];
+    }
+    qsort(sorted, p_batch->nbFiles, sizeof(def_batch_file_t *), batch_compare_output);
+    for (uint32_t i = 1; i < p_batch->nbFiles; i++) {
+        if (strcmp(sorted[i]->outKey, sorted[first]->outKey)) {
+            first = i;
+            continue;
+        }
+        fprintf(stderr, "%s: skipped, same output %s as %s\n", sorted[i]->inPath, sorted[first]->outPath,
+                sorted[first]->inPath);
+        sorted[i]->error = 1;
+        nbRemoved++;
+    }
+    free(sorted);
+    for (uint32_t i = 0; i < p_batch->nbFiles; i++) {
+        def_batch_file_t *p_file = &p_batch->files[i];
+        if (p_file->error) {
+            free(p_file->inPath);
+            free(p_file->outPath);
+            free(p_file->outKey);
+            free(p_file->tmpPath);
+        } else {
+            p_batch->files[nbKept++] = *p_file;
+        }
+    }
+    p_batch->nbFiles = nbKept;
+    return nbRemoved;
+}
+
+//****************************************************************************
+/**
+ * Get the next file to convert: from the head of the own queue, or from the tail of another queue.
+ * Returns 0 when all queues are empty.
+ */
+static int batch_take(def_batch_t *p_batch, uint32_t id, uint32_t *p_index)
+{
+    for (uint32_t i = 0; i < p_batch->nbWorkers; i++) {
+        def_batch_queue_t *p_queue = &p_batch->queues[(id + i) % p_batch->nbWorkers];
+        int found = 0;
+        pthread_mutex_lock(&p_queue->lock);
+        if (p_queue->head < p_queue->tail) {
+            *p_index = (i == 0) ? p_queue->items[p_queue->head++] : p_queue->items[--p_queue->tail];
+            found = 1;
+        }
+        pthread_mutex_unlock(&p_queue->lock);
+        if (found) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+static void batch_flush(def_batch_worker_t *p_worker)
+{
+    uint32_t done = 0;
+    while (done < p_worker->outLen) {
+        ssize_t n = write(p_worker->fd, p_worker->out + done, p_worker->outLen - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            p_worker->writeError = 1;
+            break;
+        }
+        done += n;
+    }
+    p_worker->outLen = 0;
+}
+
+//****************************************************************************
+static void batch_write(def_batch_worker_t *p_worker, const void *data, uint32_t len)
+{
+    while (len) {
+        uint32_t n = BATCH_OUT_BUFFER_SIZE - p_worker->outLen;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(p_worker->out + p_worker->outLen, data, n);
+        p_worker->outLen += n;
+        data = (const uint8_t *)data + n;
+        len -= n;
+        if (p_worker->outLen == BATCH_OUT_BUFFER_SIZE) {
+            batch_flush(p_worker);
+        }
+    }
+}
+
+//****************************************************************************
+// The writer formats in the output buffer, which is then written as in batch_flush
+static uint8_t batch_writer_flush(void *p_user, const uint8_t *data, uint32_t len)
+{
+    def_batch_worker_t *p_worker = p_user;
+
+    (void)data;
+    p_worker->outLen = len;
+    batch_flush(p_worker);
+    return !p_worker->writeError;
+}
+
+//****************************************************************************
+static uint8_t *batch_put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    return p + 2;
+}
+
+//****************************************************************************
+static uint8_t *batch_put_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return p + 4;
+}
+
+//****************************************************************************
+/**
+ * Columnar file: the header BATCH_COL_MAGIC, uint16_t version, uint16_t number of columns (2),
+ * then row groups of at most BATCH_COL_ROW_GROUP rows:
+ *   uint32_t nbRows, uint32_t minTime, uint32_t maxTime, int16_t minTempe, int16_t maxTempe,
+ *   nbRows uint32_t times, nbRows int16_t temperatures, padding to 4 bytes.
+ * min/max only use valid values (UINT32_MAX/0 and INT16_MAX/INT16_MIN if none).
+ * The file ends with a row group of 0 rows. Values are little endian whatever the host, each one is
+ * serialized in colBytes.
+ */
+static void batch_col_write_group(def_batch_worker_t *p_worker)
+{
+    uint32_t minTime = UINT32_MAX, maxTime = 0;
+    int16_t minTempe = INT16_MAX, maxTempe = INT16_MIN;
+    uint8_t *p = p_worker->colBytes + BATCH_COL_GROUP_HEADER;
+    uint8_t *header;
+
+    for (uint32_t i = 0; i < p_worker->nbRows; i++) {
+        uint32_t time = p_worker->times[i];
+        if (time != UNCOMPRESS_INVALID_TIME) {
+            minTime = (time < minTime) ? time : minTime;
+            maxTime = (time > maxTime) ? time : maxTime;
+        }
+        p = batch_put_u32(p, time);
+    }
+    for (uint32_t i = 0; i < p_worker->nbRows; i++) {
+        int16_t tempe = p_worker->tempes[i];
+        if ((tempe != INVALID_TEMPERATURE) && (tempe != UNCOMPRESS_UNRECEIVED_TEMPERATURE)) {
+            minTempe = (tempe < minTempe) ? tempe : minTempe;
+            maxTempe = (tempe > maxTempe) ? tempe : maxTempe;
+        }
+        p = batch_put_u16(p, (uint16_t)tempe);
+    }
+    if (p_worker->nbRows & 1) {
+        p = batch_put_u16(p, 0);    // padding
+    }
+    header = batch_put_u32(p_worker->colBytes, p_worker->nbRows);
+    header = batch_put_u32(header, minTime);
+    header = batch_put_u32(header, maxTime);
+    header = batch_put_u16(header, (uint16_t)minTempe);
+    batch_put_u16(header, (uint16_t)maxTempe);
+    batch_write(p_worker, p_worker->colBytes, (uint32_t)(p - p_worker->colBytes));
+    p_worker->nbRows = 0;
+}
+
+//****************************************************************************
+static void batch_col_add(def_batch_worker_t *p_worker, const samples_t *p_samples)
+{
+    for (uint32_t i = 0; i < p_samples->nbSamples; i++) {
+        p_worker->times[p_worker->nbRows] = p_samples->samples[i].time;
+        p_worker->tempes[p_worker->nbRows] = p_samples->samples[i].tempe;
+        if (++p_worker->nbRows == BATCH_COL_ROW_GROUP) {
+            batch_col_write_group(p_worker);
+        }
+    }
+}
+
+//****************************************************************************
+static void batch_convert_file(def_batch_worker_t *p_worker, def_batch_file_t *p_file)
+{
+    def_batch_t *p_batch = p_worker->p_batch;
+    uncompress_state_t state;
+    uncompress_resync_report_t report;
+    uint8_t *data = NULL;
+    uint64_t offset = 0;
+    double start = batch_now();
+    int fd;
+
+    fd = open(p_file->inPath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", p_file->inPath, strerror(errno));
+        p_file->error = 1;
+        return;
+    }
+    if (p_file->size) {
+        data = mmap(NULL, p_file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "%s: %s\n", p_file->inPath, strerror(errno));
+            close(fd);
+            p_file->error = 1;
+            return;
+        }
+        madvise(data, p_file->size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    p_worker->fd = batch_open_output(p_file);
+    if (p_worker->fd < 0) {
+        if (data) {
+            munmap(data, p_file->size);
+        }
+        p_file->error = 1;
+        return;
+    }
+    p_worker->outLen = 0;
+    p_worker->writeError = 0;
+    p_worker->nbRows = 0;
+    lib_uncompress_writer_init(&p_worker->writer, p_worker->out, BATCH_OUT_BUFFER_SIZE, batch_writer_flush, p_worker, NULL);
+    if (p_batch->format == BATCH_FORMAT_COL) {
+        uint8_t header[8];
+        memcpy(header, BATCH_COL_MAGIC, 4);
+        batch_put_u16(batch_put_u16(&header[4], BATCH_COL_VERSION), 2);
+        batch_write(p_worker, header, sizeof(header));
+    }
+
+    lib_uncompress_state_init(&state);
+    while (offset < p_file->size) {
+        uint8_t len = data[offset];
+        uint8_t ret;
+        if (offset + 1 + len > p_file->size) {
+            fprintf(stderr, "%s: truncated frame at offset %llu\n", p_file->inPath, (unsigned long long)offset);
+            p_file->nbBadFrames++;
+            break;
+        }
+        lib_uncompress_state_new_frame(&state);
+        p_file->nbFrames++;
+        if (!p_batch->resync && (p_batch->format == BATCH_FORMAT_CSV)) {
+            // decoded and formatted in a single pass
+            uint64_t nbRecords = p_worker->writer.nbRecords;
+            if (!lib_uncompress_data_to_writer(&data[offset+1], len, &state, &p_worker->writer)) {
+                p_file->nbBadFrames++;
+            }
+            p_file->nbSamples += p_worker->writer.nbRecords - nbRecords;
+            offset += 1 + len;
+            continue;
+        }
+        if (p_batch->resync) {
+            ret = lib_uncompress_data_resync(&data[offset+1], len, p_worker->p_samples, &state, NULL, &report);
+            p_file->nbResyncs += report.nbResyncs;
+        } else {
+            ret = lib_uncompress_data_with_state(&data[offset+1], len, p_worker->p_samples, &state);
+        }
+        offset += 1 + len;
+        if (!ret) {
+            p_file->nbBadFrames++;
+            continue;
+        }
+        p_file->nbSamples += p_worker->p_samples->nbSamples;
+        if (p_batch->format == BATCH_FORMAT_CSV) {
+            lib_uncompress_writer_add(&p_worker->writer, p_worker->p_samples->samples, p_worker->p_samples->nbSamples);
+        } else {
+            batch_col_add(p_worker, p_worker->p_samples);
+        }
+    }
+    if (p_batch->format == BATCH_FORMAT_COL) {
+        if (p_worker->nbRows) {
+            batch_col_write_group(p_worker);
+        }
+        batch_col_write_group(p_worker);    // end marker
+        batch_flush(p_worker);
+    } else {
+        lib_uncompress_writer_flush(&p_worker->writer);
+    }
+    if (close(p_worker->fd) || p_worker->writeError) {
+        fprintf(stderr, "%s: write error\n", p_file->outPath);
+        p_file->error = 1;
+        unlink(p_file->tmpPath);
+    } else if (rename(p_file->tmpPath, p_file->outPath)) {
+        fprintf(stderr, "%s: %s\n", p_file->outPath, strerror(errno));
+        p_file->error = 1;
+        unlink(p_file->tmpPath);
+    }
+    if (data) {
+        munmap(data, p_file->size);
+    }
+    p_file->seconds = batch_now() - start;
+
+    if (!p_batch->quiet) {
+        double seconds = (p_file->seconds > 0) ? p_file->seconds : 1e-9;
+        pthread_mutex_lock(&p_batch->printLock);
+        printf("%s: %u frames (%u bad), %llu samples, %.3f s, %.1f MB/s, %.1f Msamples/s%s\n",
+               p_file->inPath, p_file->nbFrames, p_file->nbBadFrames, (unsigned long long)p_file->nbSamples,
+               p_file->seconds, p_file->size / seconds / 1e6, p_file->nbSamples / seconds / 1e6,
+               p_file->nbResyncs ? ", resynced" : "");
+        pthread_mutex_unlock(&p_batch->printLock);
+    }
+}
+
+//****************************************************************************
+// A new temporary file next to the output, tmpPath is set to its name. Returns the fd, -1 on error.
+static int batch_open_output(def_batch_file_t *p_file)
+{
+    int fd = mkstemp(p_file->tmpPath);
+
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", p_file->tmpPath, strerror(errno));
+        return -1;
+    }
+    if (fchmod(fd, 0644)) {
+        fprintf(stderr, "%s: %s\n", p_file->tmpPath, strerror(errno));
+        close(fd);
+        unlink(p_file->tmpPath);
+        return -1;
+    }
+    return fd;
+}
+
+//****************************************************************************
+static void *batch_worker(void *arg)
+{
+    def_batch_worker_t *p_worker = arg;
+    uint32_t index;
+
+    while (batch_take(p_worker->p_batch, p_worker->id, &index)) {
+        batch_convert_file(p_worker, &p_worker->p_batch->files[index]);
+    }
+    return NULL;
+}
+
+//****************************************************************************
+static void batch_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-j threads] [-f csv|col] [-o dir] [-r] [-q] input...\n"
+            "  input        a frame dump (frames prefixed by their length on one byte), or a directory of dumps\n"
+            "  -j threads   number of threads, default: number of CPUs\n"
+            "  -f format    csv (time;temperature lines) or col (columnar binary), default: csv\n"
+            "  -o dir       output directory, default: the directory of each input\n"
+            "  -r           skip corrupted parts of the frames (lib_uncompress_data_resync)\n"
+            "  -q           do not print per file throughput\n", name);
+}
+
+//****************************************************************************
+int main(int argc, char **argv)
+{
+    def_batch_t batch;
+    def_batch_worker_t *workers;
+    const char *outDir = NULL;
+    long nbThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t totalSize = 0, totalSamples = 0;
+    uint32_t nbErrors = 0;
+    double start, seconds;
+    int opt;
+
+    memset(&batch, 0, sizeof(batch));
+    batch.format = BATCH_FORMAT_CSV;
+    while ((opt = getopt(argc, argv, "j:f:o:rqh")) != -1) {
+        switch (opt) {
+        case 'j':
+            nbThreads = strtol(optarg, NULL, 10);
+            break;
+        case 'f':
+            if (!strcmp(optarg, "csv")) {
+                batch.format = BATCH_FORMAT_CSV;
+            } else if (!strcmp(optarg, "col")) {
+                batch.format = BATCH_FORMAT_COL;
+            } else {
+                batch_usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'o':
+            outDir = optarg;
+            break;
+        case 'r':
+            batch.resync = 1;
+            break;
+        case 'q':
+            batch.quiet = 1;
+            break;
+        default:
+            batch_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        batch_usage(argv[0]);
+        return 2;
+    }
+    if (outDir && mkdir(outDir, 0755) && (errno != EEXIST)) {
+        fprintf(stderr, "%s: %s\n", outDir, strerror(errno));
+        return 1;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (batch_add_input(&batch, argv[i], outDir)) {
+            nbErrors++;
+        }
+    }
+    nbErrors += batch_remove_collisions(&batch);
+    if (!batch.nbFiles) {
+        fprintf(stderr, "no input file\n");
+        return 1;
+    }
+
+    // Largest files first, dealt round robin so that each queue is sorted too
+    qsort(batch.files, batch.nbFiles, sizeof(def_batch_file_t), batch_compare_size);
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+    if (nbThreads > BATCH_MAX_THREADS) {
+        nbThreads = BATCH_MAX_THREADS;
+    }
+    if (nbThreads > batch.nbFiles) {
+        nbThreads = batch.nbFiles;
+    }
+    batch.nbWorkers = nbThreads;
+    batch.queues = calloc(batch.nbWorkers, sizeof(def_batch_queue_t));
+    workers = calloc(batch.nbWorkers, sizeof(def_batch_worker_t));
+    if (!batch.queues || !workers) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    pthread_mutex_init(&batch.printLock, NULL);
+    for (uint32_t w = 0; w < batch.nbWorkers; w++) {
+        def_batch_queue_t *p_queue = &batch.queues[w];
+        pthread_mutex_init(&p_queue->lock, NULL);
+        p_queue->items = malloc(((batch.nbFiles / batch.nbWorkers) + 1) * sizeof(uint32_t));
+        for (uint32_t i = w; i < batch.nbFiles; i += batch.nbWorkers) {
+            p_queue->items[p_queue->tail++] = i;
+        }
+        workers[w].p_batch = &batch;
+        workers[w].id = w;
+        workers[w].p_samples = malloc(sizeof(samples_t));
+        workers[w].out = malloc(BATCH_OUT_BUFFER_SIZE);
+        if (batch.format == BATCH_FORMAT_COL) {
+            workers[w].times = malloc(BATCH_COL_ROW_GROUP * sizeof(uint32_t));
+            workers[w].tempes = malloc(BATCH_COL_ROW_GROUP * sizeof(int16_t));
+            workers[w].colBytes = malloc(BATCH_COL_GROUP_HEADER + BATCH_COL_ROW_GROUP * (sizeof(uint32_t) + sizeof(int16_t)));
+            if (!workers[w].times || !workers[w].tempes || !workers[w].colBytes) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        if (!p_queue->items || !workers[w].p_samples || !workers[w].out) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+
+    start = batch_now();
+    for (uint32_t w = 0; w < batch.nbWorkers; w++) {
+        if (pthread_create(&workers[w].thread, NULL, batch_worker, &workers[w])) {
+            fprintf(stderr, "cannot create thread\n");
+            return 1;
+        }
+    }
+    for (uint32_t w = 0; w < batch.nbWorkers; w++) {
+        pthread_join(workers[w].thread, NULL);
+    }
+    seconds = batch_now() - start;
+    if (seconds <= 0) {
+        seconds = 1e-9;
+    }
+
+    for (uint32_t i = 0; i < batch.nbFiles; i++) {
+        totalSize += batch.files[i].size;
+        totalSamples += batch.files[i].nbSamples;
+        nbErrors += batch.files[i].error;
+        free(batch.files[i].inPath);
+        free(batch.files[i].outPath);
+        free(batch.files[i].outKey);
+        free(batch.files[i].tmpPath);
+    }
+    printf("%u files, %llu bytes, %llu samples in %.3f s with %u threads: %.1f MB/s, %.1f Msamples/s\n",
+           batch.nbFiles, (unsigned long long)totalSize, (unsigned long long)totalSamples, seconds,
+           batch.nbWorkers, totalSize / seconds / 1e6, totalSamples / seconds / 1e6);
+
+    for (uint32_t w = 0; w < batch.nbWorkers; w++) {
+        free(batch.queues[w].items);
+        free(workers[w].p_samples);
+        free(workers[w].out);
+        free(workers[w].times);
+        free(workers[w].tempes);
+        free(workers[w].colBytes);
+    }
+    free(batch.queues);
+    free(workers);
+    free(batch.files);
+    return nbErrors ? 1 : 0;
+}
@@ -0,0 +1,790 @@
+/**
+  ******************************************************************************
+  * \file uncompress_bench.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Golden output and performance suite of the decoder.
+  *       A fixed set of corpora is decoded (see lib_uncompress_corpus.h): the slots
+  *       of the example application (parsed from example/lib/slots_data.dart), their
+  *       concatenation repeated into a large dump, and synthetic dumps made with
+  *       lib_bitStream_set_bits that stress each path of the decoder. The CSV of each corpus, as written
+  *       by the application, is checked against the golden file (number of samples,
+  *       number of bytes and FNV-1a 64 of the bytes). It is made with lib_uncompress_data,
+  *       the API used by the application, and must be the same with
+  *       lib_uncompress_data_with_state and with lib_uncompress_data_to_writer.
+  *       See bench/README.md for how the golden outputs were derived.
+  *       Then each corpus is decoded again in a loop, and the best of several runs
+  *       gives ns per sample and input bytes per second. They are compared to the
+  *       baseline file, which is recorded when it does not exist yet: the suite
+  *       fails when the throughput of a mode, geometric mean over the corpora, is
+  *       lower than the baseline by more than the tolerance.
+  *       With -x, the corpora are also converted by uncompress_batch, to CSV and to
+  *       columnar files, which must give the golden outputs too.
+  *
+  *       usage: uncompress_bench -s slots_data.dart -g golden [-b baseline] [-t percent]
+  *                               [-m seconds] [-n runs] [-c] [-u] [-o dir] [-x uncompress_batch]
+  *       golden and baseline files are lines of fields separated by ';', '#' for comments.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_uncompress.h"
+#include "lib_uncompress_stats.h"
+#include "lib_uncompress_corpus.h"
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define BENCH_WRITER_SIZE       (256 * 1024)
+#define BENCH_DEFAULT_TOLERANCE 10.0        // percent
+#define BENCH_DEFAULT_SECONDS   0.2         // per run
+#define BENCH_DEFAULT_RUNS      5
+#define BENCH_CALIBRATE_SECONDS 0.02
+#define BENCH_LINE_LEN          256
+#define BENCH_FNV_OFFSET        0xcbf29ce484222325ULL
+#define BENCH_FNV_PRIME         0x100000001b3ULL
+#define BENCH_COL_MAGIC         "BCCL"      // columnar files of uncompress_batch
+#define BENCH_COL_VERSION       1
+#define BENCH_COL_GROUP_HEADER  16
+
+typedef enum {
+    BENCH_API_DATA,         // lib_uncompress_data, the global state set before the corpus: golden output
+    BENCH_API_STATE,        // lib_uncompress_data_with_state
+    BENCH_API_WRITER,       // lib_uncompress_data_to_writer
+    BENCH_NB_APIS
+} def_bench_api_t;
+
+typedef enum {
+    BENCH_MODE_DECODE,      // lib_uncompress_data_with_state, samples_t filled
+    BENCH_MODE_CSV,         // lib_uncompress_data_to_writer, CSV formatted and dropped
+    BENCH_NB_MODES
+} def_bench_mode_t;
+
+typedef enum {
+    BENCH_BATCH_CSV,        // uncompress_batch -f csv, compared as is
+    BENCH_BATCH_COL,        // uncompress_batch -f col, read and written as CSV
+    BENCH_NB_BATCH_FORMATS
+} def_bench_batch_format_t;
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+
+// Output of a corpus, compared to the golden file
+typedef struct {
+    uint64_t    nbSamples;
+    uint64_t    nbBytes;
+    uint64_t    hash;
+} def_bench_golden_t;
+
+// Throughput of a corpus in one mode, compared to the baseline file
+typedef struct {
+    uint64_t    nbSamples;      // per decoding of the corpus
+    uint32_t    nbBytes;        // input bytes
+    double      nsPerSample;
+    double      bytesPerSecond;
+} def_bench_perf_t;
+
+// Sink of a writer: hash of the output, and copy to a file if set
+typedef struct {
+    uint64_t    hash;
+    FILE        *p_file;
+} def_bench_sink_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static double bench_now(void);
+static uint64_t bench_fnv(uint64_t hash, const uint8_t *data, uint32_t len);
+static uint8_t bench_sink_flush(void *p_user, const uint8_t *data, uint32_t len);
+static uint8_t bench_null_flush(void *p_user, const uint8_t *data, uint32_t len);
+static int bench_output(const uncompress_corpus_t *p_corpus, def_bench_api_t api, const char *outDir, def_bench_golden_t *p_golden);
+static uint64_t bench_decode(const uncompress_corpus_t *p_corpus, def_bench_mode_t mode, uint32_t nbLoops);
+static void bench_measure(const uncompress_corpus_t *p_corpus, def_bench_mode_t mode, double seconds, uint32_t nbRuns, def_bench_perf_t *p_perf);
+static uint32_t bench_get_u32(const uint8_t *p);
+static int bench_read_csv(const char *path, def_bench_golden_t *p_golden);
+static int bench_read_col(const char *path, def_bench_golden_t *p_golden);
+static int bench_run(const char *tool, char **args);
+static int bench_batch(const char *batchPath, def_bench_golden_t outputs[][BENCH_NB_BATCH_FORMATS]);
+static int bench_check_golden(const char *path, const char *outDir, uint8_t update, const char *batchPath);
+static int bench_check_perf(const char *path, double tolerance, double seconds, uint32_t nbRuns, uint8_t update);
+static void bench_usage(const char *name);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+static uncompress_corpus_t corpora[UNCOMPRESS_CORPUS_MAX];
+static uint32_t nbCorpora;
+static samples_t samples;
+static uint8_t writerBuffer[BENCH_WRITER_SIZE];
+static const char *modeNames[BENCH_NB_MODES] = { "decode", "csv" };
+static const char *apiNames[BENCH_NB_APIS] = { "lib_uncompress_data", "lib_uncompress_data_with_state", "lib_uncompress_data_to_writer" };
+static const char *apiSuffixes[BENCH_NB_APIS] = { "", "_state", "_writer" };
+static const char *batchFormats[BENCH_NB_BATCH_FORMATS] = { "csv", "col" };
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//****************************************************************************
+static uint64_t bench_fnv(uint64_t hash, const uint8_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= BENCH_FNV_PRIME;
+    }
+    return hash;
+}
+
+
+//****************************************************************************
+static uint8_t bench_sink_flush(void *p_user, const uint8_t *data, uint32_t len)
+{
+    def_bench_sink_t *p_sink = p_user;
+
+    p_sink->hash = bench_fnv(p_sink->hash, data, len);
+    return !p_sink->p_file || (fwrite(data, 1, len, p_sink->p_file) == len);
+}
+
+//****************************************************************************
+static uint8_t bench_null_flush(void *p_user, const uint8_t *data, uint32_t len)
+{
+    (void)p_user;
+    (void)data;
+    (void)len;
+    return 1;
+}
+
+//****************************************************************************
+// CSV of a corpus, as the application writes it: frame by frame, the timestamp state reset before each one
+static int bench_output(const uncompress_corpus_t *p_corpus, def_bench_api_t api, const char *outDir, def_bench_golden_t *p_golden)
+{
+    uncompress_state_t state;
+    uncompress_writer_t writer;
+    def_bench_sink_t sink = { BENCH_FNV_OFFSET, NULL };
+    uint32_t idx = 0;
+    int ret = 0;
+
+    if (outDir) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s%s.csv", outDir, p_corpus->name, apiSuffixes[api]);
+        sink.p_file = fopen(path, "wb");
+        if (!sink.p_file) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return -1;
+        }
+    }
+    lib_uncompress_state_init(&state);
+    if (api == BENCH_API_DATA) {
+        // no temperature reference before the first frame, as for the other APIs
+        lib_uncompress_set_state(&state);
+    }
+    lib_uncompress_writer_init(&writer, writerBuffer, sizeof(writerBuffer), bench_sink_flush, &sink, NULL);
+    while (idx < p_corpus->len) {
+        uint8_t len = p_corpus->data[idx++];
+        if (idx + len > p_corpus->len) {
+            fprintf(stderr, "%s: truncated frame at %u\n", p_corpus->name, idx - 1);
+            ret = -1;
+            break;
+        }
+        lib_uncompress_state_new_frame(&state);
+        if (api == BENCH_API_WRITER) {
+            lib_uncompress_data_to_writer(&p_corpus->data[idx], len, &state, &writer);
+        } else if ((api == BENCH_API_DATA) ? lib_uncompress_data(&p_corpus->data[idx], len, &samples) :
+                   lib_uncompress_data_with_state(&p_corpus->data[idx], len, &samples, &state)) {
+            lib_uncompress_writer_add(&writer, samples.samples, samples.nbSamples);
+        }
+        idx += len;
+    }
+    if (!lib_uncompress_writer_flush(&writer)) {
+        ret = -1;
+    }
+    if (sink.p_file && fclose(sink.p_file)) {
+        ret = -1;
+    }
+    p_golden->nbSamples = writer.nbRecords;
+    p_golden->nbBytes = writer.nbBytes;
+    p_golden->hash = sink.hash;
+    return ret;
+}
+
+//****************************************************************************
+// Decode a corpus nbLoops times, return the number of samples decoded
+static uint64_t bench_decode(const uncompress_corpus_t *p_corpus, def_bench_mode_t mode, uint32_t nbLoops)
+{
+    uncompress_state_t state;
+    uncompress_writer_t writer;
+    uint64_t nbSamples = 0;
+
+    for (uint32_t loop = 0; loop < nbLoops; loop++) {
+        uint32_t idx = 0;
+        lib_uncompress_state_init(&state);
+        lib_uncompress_writer_init(&writer, writerBuffer, sizeof(writerBuffer), bench_null_flush, NULL, NULL);
+        while (idx < p_corpus->len) {
+            uint8_t len = p_corpus->data[idx++];
+            lib_uncompress_state_new_frame(&state);
+            if (mode == BENCH_MODE_CSV) {
+                lib_uncompress_data_to_writer(&p_corpus->data[idx], len, &state, &writer);
+            } else if (lib_uncompress_data_with_state(&p_corpus->data[idx], len, &samples, &state)) {
+                nbSamples += samples.nbSamples;
+            }
+            idx += len;
+        }
+        lib_uncompress_writer_flush(&writer);
+        nbSamples += writer.nbRecords;
+    }
+    return nbSamples;
+}
+
+//****************************************************************************
+// Best of nbRuns runs of about seconds each
+static void bench_measure(const uncompress_corpus_t *p_corpus, def_bench_mode_t mode, double seconds, uint32_t nbRuns, def_bench_perf_t *p_perf)
+{
+    uint32_t nbLoops = 1;
+    double elapsed, best = 0;
+    uint64_t nbSamples = 0;
+
+    // calibrate the number of loops of one run
+    for (;;) {
+        double start = bench_now();
+        bench_decode(p_corpus, mode, nbLoops);
+        elapsed = bench_now() - start;
+        if ((elapsed >= BENCH_CALIBRATE_SECONDS) || (nbLoops >= (1U << 30))) {
+            break;
+        }
+        nbLoops *= 2;
+    }
+    if (elapsed > 0) {
+        double loops = nbLoops * seconds / elapsed;
+        nbLoops = (loops < 1) ? 1 : (loops > (1U << 30)) ? (1U << 30) : (uint32_t)loops;
+    }
+    for (uint32_t run = 0; run < nbRuns; run++) {
+        double start = bench_now();
+        nbSamples = bench_decode(p_corpus, mode, nbLoops);
+        elapsed = bench_now() - start;
+        if (!run || (elapsed < best)) {
+            best = elapsed;
+        }
+    }
+    if (best <= 0) {
+        best = 1e-9;
+    }
+    p_perf->nbSamples = nbSamples / nbLoops;
+    p_perf->nbBytes = p_corpus->len;
+    p_perf->nsPerSample = nbSamples ? best * 1e9 / nbSamples : 0;
+    p_perf->bytesPerSecond = (double)p_corpus->len * nbLoops / best;
+}
+
+//****************************************************************************
+static uint32_t bench_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//****************************************************************************
+// Lines, bytes and hash of a CSV file
+static int bench_read_csv(const char *path, def_bench_golden_t *p_golden)
+{
+    FILE *p_file = fopen(path, "rb");
+    size_t len;
+
+    if (!p_file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    memset(p_golden, 0, sizeof(def_bench_golden_t));
+    p_golden->hash = BENCH_FNV_OFFSET;
+    while ((len = fread(writerBuffer, 1, sizeof(writerBuffer), p_file)) > 0) {
+        p_golden->hash = bench_fnv(p_golden->hash, writerBuffer, (uint32_t)len);
+        p_golden->nbBytes += len;
+        for (size_t i = 0; i < len; i++) {
+            p_golden->nbSamples += (writerBuffer[i] == '\n');
+        }
+    }
+    fclose(p_file);
+    return 0;
+}
+
+//****************************************************************************
+// Records of a columnar file written as CSV by the default writer, row groups checked (see uncompress_batch.c)
+static int bench_read_col(const char *path, def_bench_golden_t *p_golden)
+{
+    static uint8_t csvBuffer[BENCH_WRITER_SIZE];
+    def_bench_sink_t sink = { BENCH_FNV_OFFSET, NULL };
+    uncompress_writer_t writer;
+    FILE *p_file = fopen(path, "rb");
+    uint8_t *data = NULL;
+    const char *error = NULL;
+    long size = -1;
+    uint32_t offset = 8;
+
+    if (p_file && !fseek(p_file, 0, SEEK_END)) {
+        size = ftell(p_file);
+    }
+    if ((size >= 0) && !fseek(p_file, 0, SEEK_SET)) {
+        data = malloc(size + 1);
+    }
+    if (!data || (fread(data, 1, size, p_file) != (size_t)size)) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        free(data);
+        if (p_file) {
+            fclose(p_file);
+        }
+        return -1;
+    }
+    fclose(p_file);
+
+    lib_uncompress_writer_init(&writer, csvBuffer, sizeof(csvBuffer), bench_sink_flush, &sink, NULL);
+    if ((size < 8) || memcmp(data, BENCH_COL_MAGIC, 4) || (data[4] != BENCH_COL_VERSION) || data[5] || (data[6] != 2) || data[7]) {
+        error = "bad header";
+    }
+    while (!error) {
+        uint32_t nbRows, minTime = UINT32_MAX, maxTime = 0;
+        int16_t minTempe = INT16_MAX, maxTempe = INT16_MIN;
+        const uint8_t *times, *tempes;
+
+        if (offset + BENCH_COL_GROUP_HEADER > (uint32_t)size) {
+            error = "truncated row group";
+            break;
+        }
+        nbRows = bench_get_u32(&data[offset]);
+        if (!nbRows) {
+            offset += BENCH_COL_GROUP_HEADER;
+            error = (offset == (uint32_t)size) ? NULL : "data after the last row group";
+            break;
+        }
+        times = &data[offset + BENCH_COL_GROUP_HEADER];
+        tempes = times + 4 * (uint64_t)nbRows;
+        if (offset + BENCH_COL_GROUP_HEADER + (6 * (uint64_t)nbRows + 3) / 4 * 4 > (uint64_t)size) {
+            error = "truncated row group";
+            break;
+        }
+        for (uint32_t i = 0; i < nbRows; i++) {
+            record_t record;
+            record.time = bench_get_u32(&times[4 * i]);
+            record.tempe = (int16_t)(tempes[2 * i] | (tempes[2 * i + 1] << 8));
+            if (record.time != UNCOMPRESS_INVALID_TIME) {
+                minTime = (record.time < minTime) ? record.time : minTime;
+                maxTime = (record.time > maxTime) ? record.time : maxTime;
+            }
+            if ((record.tempe != INVALID_TEMPERATURE) && (record.tempe != UNCOMPRESS_UNRECEIVED_TEMPERATURE)) {
+                minTempe = (record.tempe < minTempe) ? record.tempe : minTempe;
+                maxTempe = (record.tempe > maxTempe) ? record.tempe : maxTempe;
+            }
+            lib_uncompress_writer_add_one(&writer, &record);
+        }
+        if ((bench_get_u32(&data[offset + 4]) != minTime) || (bench_get_u32(&data[offset + 8]) != maxTime)
+            || ((int16_t)(data[offset + 12] | (data[offset + 13] << 8)) != minTempe)
+            || ((int16_t)(data[offset + 14] | (data[offset + 15] << 8)) != maxTempe)) {
+            error = "bad min/max in a row group";
+        }
+        offset += BENCH_COL_GROUP_HEADER + (6 * nbRows + 3) / 4 * 4;
+    }
+    free(data);
+    if (!lib_uncompress_writer_flush(&writer)) {
+        error = "write error";
+    }
+    if (error) {
+        fprintf(stderr, "%s: %s at offset %u\n", path, error, offset);
+        return -1;
+    }
+    p_golden->nbSamples = writer.nbRecords;
+    p_golden->nbBytes = writer.nbBytes;
+    p_golden->hash = sink.hash;
+    return 0;
+}
+
+//****************************************************************************
+// Run tool with args (args[0] is its name), without its stdout. Returns its exit status, -1 on error.
+static int bench_run(const char *tool, char **args)
+{
+    pid_t pid = fork();
+    int status;
+
+    if (pid == 0) {
+        int fd = open("/dev/null", O_WRONLY);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+        }
+        execv(tool, args);
+        fprintf(stderr, "%s: %s\n", tool, strerror(errno));
+        _exit(127);
+    }
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid)) {
+        fprintf(stderr, "%s: %s\n", tool, strerror(errno));
+        return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+//****************************************************************************
+/**
+ * Write the corpora as dumps in a temporary directory and convert them with uncompress_batch,
+ * in each format. outputs gets the CSV of each output, compared to the golden outputs.
+ */
+static int bench_batch(const char *batchPath, def_bench_golden_t outputs[][BENCH_NB_BATCH_FORMATS])
+{
+    const char *tmpDir = getenv("TMPDIR");
+    static const char *suffixes[] = { "bin", "csv", "col" };
+    char dir[1024], path[1024 + UNCOMPRESS_CORPUS_NAME_LEN + 8];
+    int ret = 0;
+
+    snprintf(dir, sizeof(dir), "%s/uncompress_bench_batch.XXXXXX", tmpDir ? tmpDir : "/tmp");
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "%s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    for (uint32_t c = 0; (c < nbCorpora) && !ret; c++) {
+        FILE *p_file;
+        snprintf(path, sizeof(path), "%s/%.*s.bin", dir, UNCOMPRESS_CORPUS_NAME_LEN, corpora[c].name);
+        p_file = fopen(path, "wb");
+        if (!p_file || (fwrite(corpora[c].data, 1, corpora[c].len, p_file) != corpora[c].len) | fclose(p_file)) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            ret = -1;
+        }
+    }
+    for (uint32_t f = 0; (f < BENCH_NB_BATCH_FORMATS) && !ret; f++) {
+        char *args[] = { "uncompress_batch", "-q", "-f", (char *)batchFormats[f], dir, NULL };
+        if (bench_run(batchPath, args)) {
+            fprintf(stderr, "%s -f %s failed\n", batchPath, batchFormats[f]);
+            ret = -1;
+        }
+        for (uint32_t c = 0; (c < nbCorpora) && !ret; c++) {
+            snprintf(path, sizeof(path), "%s/%.*s.%s", dir, UNCOMPRESS_CORPUS_NAME_LEN, corpora[c].name, batchFormats[f]);
+            ret = (f == BENCH_BATCH_CSV) ? bench_read_csv(path, &outputs[c][f]) : bench_read_col(path, &outputs[c][f]);
+        }
+    }
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        for (uint32_t s = 0; s < sizeof(suffixes) / sizeof(suffixes[0]); s++) {
+            snprintf(path, sizeof(path), "%s/%.*s.%s", dir, UNCOMPRESS_CORPUS_NAME_LEN, corpora[c].name, suffixes[s]);
+            unlink(path);
+        }
+    }
+    rmdir(dir);
+    return ret;
+}
+
+//****************************************************************************
+// Golden file lines: corpus;frames;samples;bytes;fnv1a64
+static int bench_check_golden(const char *path, const char *outDir, uint8_t update, const char *batchPath)
+{
+    def_bench_golden_t golden[UNCOMPRESS_CORPUS_MAX];
+    def_bench_golden_t batchOutputs[UNCOMPRESS_CORPUS_MAX][BENCH_NB_BATCH_FORMATS];
+    uint8_t found[UNCOMPRESS_CORPUS_MAX] = { 0 };
+    char line[BENCH_LINE_LEN];
+    uint32_t nbErrors = 0;
+    FILE *p_file;
+
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        if (bench_output(&corpora[c], BENCH_API_DATA, NULL, &golden[c])) {
+            return -1;
+        }
+        for (uint32_t api = BENCH_API_DATA + 1; api < BENCH_NB_APIS; api++) {
+            def_bench_golden_t other;
+            if (bench_output(&corpora[c], (def_bench_api_t)api, NULL, &other)) {
+                return -1;
+            }
+            if (memcmp(&golden[c], &other, sizeof(other))) {
+                fprintf(stderr, "%s: %s output differs from %s\n", corpora[c].name, apiNames[api], apiNames[BENCH_API_DATA]);
+                nbErrors++;
+            }
+        }
+    }
+
+    if (update) {
+        p_file = fopen(path, "w");
+        if (!p_file) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        fprintf(p_file, "# uncompress_bench golden outputs: CSV as written by the application, see README.md\n");
+        fprintf(p_file, "# corpus;frames;samples;bytes;fnv1a64\n");
+        for (uint32_t c = 0; c < nbCorpora; c++) {
+            fprintf(p_file, "%s;%u;%llu;%llu;%016llx\n", corpora[c].name, corpora[c].nbFrames,
+                    (unsigned long long)golden[c].nbSamples, (unsigned long long)golden[c].nbBytes,
+                    (unsigned long long)golden[c].hash);
+        }
+        if (fclose(p_file)) {
+            return -1;
+        }
+        printf("golden outputs written to %s\n", path);
+        return nbErrors ? 1 : 0;
+    }
+
+    if (batchPath && bench_batch(batchPath, batchOutputs)) {
+        return -1;
+    }
+    p_file = fopen(path, "r");
+    if (!p_file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    while (fgets(line, sizeof(line), p_file)) {
+        char name[UNCOMPRESS_CORPUS_NAME_LEN];
+        unsigned int nbFrames;
+        unsigned long long nbSamples, nbBytes, hash;
+        uint32_t c;
+
+        if ((line[0] == '#') || (line[0] == '\n')) {
+            continue;
+        }
+        if (sscanf(line, "%31[^;];%u;%llu;%llu;%llx", name, &nbFrames, &nbSamples, &nbBytes, &hash) != 5) {
+            fprintf(stderr, "%s: bad line: %s", path, line);
+            nbErrors++;
+            continue;
+        }
+        for (c = 0; (c < nbCorpora) && strcmp(corpora[c].name, name); c++) {
+        }
+        if (c == nbCorpora) {
+            fprintf(stderr, "%s: unknown corpus %s\n", path, name);
+            nbErrors++;
+            continue;
+        }
+        found[c] = 1;
+        if ((nbFrames != corpora[c].nbFrames) || (nbSamples != golden[c].nbSamples) ||
+            (nbBytes != golden[c].nbBytes) || (hash != golden[c].hash)) {
+            fprintf(stderr, "%s: output differs: %u frames, %llu samples, %llu bytes, %016llx instead of %u, %llu, %llu, %016llx\n",
+                    name, corpora[c].nbFrames, (unsigned long long)golden[c].nbSamples,
+                    (unsigned long long)golden[c].nbBytes, (unsigned long long)golden[c].hash,
+                    nbFrames, nbSamples, nbBytes, hash);
+            nbErrors++;
+            if (outDir) {
+                // the outputs of all the APIs, to be compared with the ones of a build of the reference version
+                for (uint32_t api = 0; api < BENCH_NB_APIS; api++) {
+                    bench_output(&corpora[c], (def_bench_api_t)api, outDir, &golden[c]);
+                }
+            }
+        } else {
+            printf("%-18s %6u frames %9llu samples %10llu bytes  ok\n", name, nbFrames, nbSamples, nbBytes);
+        }
+        for (uint32_t f = 0; batchPath && (f < BENCH_NB_BATCH_FORMATS); f++) {
+            const def_bench_golden_t *p_batch = &batchOutputs[c][f];
+            if ((nbSamples != p_batch->nbSamples) || (nbBytes != p_batch->nbBytes) || (hash != p_batch->hash)) {
+                fprintf(stderr, "%s: uncompress_batch -f %s output differs: %llu samples, %llu bytes, %016llx "
+                        "instead of %llu, %llu, %016llx\n", name, batchFormats[f],
+                        (unsigned long long)p_batch->nbSamples, (unsigned long long)p_batch->nbBytes,
+                        (unsigned long long)p_batch->hash, nbSamples, nbBytes, hash);
+                nbErrors++;
+            }
+        }
+    }
+    fclose(p_file);
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        if (!found[c]) {
+            fprintf(stderr, "%s: no golden output for %s\n", path, corpora[c].name);
+            nbErrors++;
+        }
+    }
+    return nbErrors ? 1 : 0;
+}
+
+//****************************************************************************
+// Baseline file lines: corpus;mode;samples;bytes;ns_per_sample;bytes_per_second
+static int bench_check_perf(const char *path, double tolerance, double seconds, uint32_t nbRuns, uint8_t update)
+{
+    def_bench_perf_t perfs[UNCOMPRESS_CORPUS_MAX][BENCH_NB_MODES];
+    double baseline[UNCOMPRESS_CORPUS_MAX][BENCH_NB_MODES] = { { 0 } };
+    double sumLog[BENCH_NB_MODES] = { 0 };
+    uint32_t nbCompared[BENCH_NB_MODES] = { 0 };
+    char line[BENCH_LINE_LEN];
+    uint32_t nbErrors = 0;
+    FILE *p_file = NULL;
+
+    if (!update) {
+        p_file = fopen(path, "r");
+        if (!p_file) {
+            printf("no baseline in %s, recording it\n", path);
+            update = 1;
+        }
+    }
+    while (p_file && fgets(line, sizeof(line), p_file)) {
+        char name[UNCOMPRESS_CORPUS_NAME_LEN], mode[UNCOMPRESS_CORPUS_NAME_LEN];
+        unsigned long long nbSamples;
+        unsigned int nbBytes;
+        double nsPerSample, bytesPerSecond;
+
+        if ((line[0] == '#') || (line[0] == '\n')) {
+            continue;
+        }
+        if (sscanf(line, "%31[^;];%31[^;];%llu;%u;%lf;%lf", name, mode, &nbSamples, &nbBytes, &nsPerSample, &bytesPerSecond) != 6) {
+            fprintf(stderr, "%s: bad line: %s", path, line);
+            nbErrors++;
+            continue;
+        }
+        for (uint32_t c = 0; c < nbCorpora; c++) {
+            for (uint32_t m = 0; m < BENCH_NB_MODES; m++) {
+                if (!strcmp(corpora[c].name, name) && !strcmp(modeNames[m], mode) && (nbBytes == corpora[c].len)) {
+                    baseline[c][m] = bytesPerSecond;
+                }
+            }
+        }
+    }
+    if (p_file) {
+        fclose(p_file);
+    }
+
+    printf("%-18s %-6s %12s %10s %10s %8s\n", "corpus", "mode", "samples", "ns/sample", "MB/s", "change");
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        for (uint32_t m = 0; m < BENCH_NB_MODES; m++) {
+            def_bench_perf_t *p_perf = &perfs[c][m];
+            bench_measure(&corpora[c], (def_bench_mode_t)m, seconds, nbRuns, p_perf);
+            printf("%-18s %-6s %12llu %10.2f %10.2f", corpora[c].name, modeNames[m],
+                   (unsigned long long)p_perf->nbSamples, p_perf->nsPerSample, p_perf->bytesPerSecond / 1e6);
+            if (!update && (baseline[c][m] > 0)) {
+                double ratio = p_perf->bytesPerSecond / baseline[c][m];
+                printf(" %+7.1f%%", (ratio - 1) * 100);
+                sumLog[m] += log(ratio);
+                nbCompared[m]++;
+            } else if (!update) {
+                printf(" %8s", "new");
+            }
+            printf("\n");
+        }
+    }
+    // A single corpus is too short to be stable on a loaded machine: the geometric mean
+    // of the changes of all the corpora of a mode is compared to the tolerance
+    for (uint32_t m = 0; m < BENCH_NB_MODES; m++) {
+        if (nbCompared[m]) {
+            double change = (exp(sumLog[m] / nbCompared[m]) - 1) * 100;
+            printf("%-18s %-6s %34s %+7.1f%%%s\n", "all", modeNames[m], "", change,
+                   (change < -tolerance) ? "  REGRESSION" : "");
+            if (change < -tolerance) {
+                nbErrors++;
+            }
+        }
+    }
+
+    if (update) {
+        p_file = fopen(path, "w");
+        if (!p_file) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        fprintf(p_file, "# uncompress_bench baseline\n");
+        fprintf(p_file, "# corpus;mode;samples;bytes;ns_per_sample;bytes_per_second\n");
+        for (uint32_t c = 0; c < nbCorpora; c++) {
+            for (uint32_t m = 0; m < BENCH_NB_MODES; m++) {
+                fprintf(p_file, "%s;%s;%llu;%u;%.3f;%.0f\n", corpora[c].name, modeNames[m],
+                        (unsigned long long)perfs[c][m].nbSamples, perfs[c][m].nbBytes,
+                        perfs[c][m].nsPerSample, perfs[c][m].bytesPerSecond);
+            }
+        }
+        if (fclose(p_file)) {
+            return -1;
+        }
+        printf("baseline written to %s\n", path);
+    } else if (nbErrors) {
+        fprintf(stderr, "throughput dropped by more than %.1f%% from %s\n", tolerance, path);
+    }
+    return nbErrors ? 1 : 0;
+}
+
+//****************************************************************************
+static void bench_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s -s slots_data.dart -g golden [-b baseline] [-t percent] [-m seconds] [-n runs] [-c] [-u] [-o dir]\n"
+            "          [-x uncompress_batch]\n"
+            "  -s file      slot data of the example application (example/lib/slots_data.dart)\n"
+            "  -g file      golden outputs of the corpora\n"
+            "  -b file      throughput baseline, recorded if it does not exist\n"
+            "  -t percent   throughput drop from the baseline (mean over the corpora) making the suite fail, default: %.0f\n"
+            "  -m seconds   duration of one run, default: %.1f\n"
+            "  -n runs      runs per corpus, the best one is kept, default: %u\n"
+            "  -c           check the golden outputs only\n"
+            "  -u           write the golden outputs and the baseline instead of checking them\n"
+            "  -o dir       write the CSV of the corpora whose output differs in dir\n"
+            "  -x file      uncompress_batch: check its CSV and columnar outputs of the corpora against the golden outputs\n",
+            name, BENCH_DEFAULT_TOLERANCE, BENCH_DEFAULT_SECONDS, BENCH_DEFAULT_RUNS);
+}
+
+//****************************************************************************
+int main(int argc, char **argv)
+{
+    const char *slotsPath = NULL, *goldenPath = NULL, *baselinePath = NULL, *outDir = NULL, *batchPath = NULL;
+    double tolerance = BENCH_DEFAULT_TOLERANCE, seconds = BENCH_DEFAULT_SECONDS;
+    uint32_t nbRuns = BENCH_DEFAULT_RUNS;
+    uint8_t checkOnly = 0, update = 0;
+    int ret, opt;
+
+    while ((opt = getopt(argc, argv, "s:g:b:t:m:n:cuo:x:h")) != -1) {
+        switch (opt) {
+        case 's':
+            slotsPath = optarg;
+            break;
+        case 'g':
+            goldenPath = optarg;
+            break;
+        case 'b':
+            baselinePath = optarg;
+            break;
+        case 't':
+            tolerance = strtod(optarg, NULL);
+            break;
+        case 'm':
+            seconds = strtod(optarg, NULL);
+            break;
+        case 'n':
+            nbRuns = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'c':
+            checkOnly = 1;
+            break;
+        case 'u':
+            update = 1;
+            break;
+        case 'o':
+            outDir = optarg;
+            break;
+        case 'x':
+            batchPath = optarg;
+            break;
+        default:
+            bench_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!slotsPath || !goldenPath || (optind < argc) || (nbRuns < 1) || (seconds <= 0)) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+    if (outDir && mkdir(outDir, 0755) && (errno != EEXIST)) {
+        fprintf(stderr, "%s: %s\n", outDir, strerror(errno));
+        return 2;
+    }
+
+    if (lib_uncompress_corpus_make_all(slotsPath, corpora, &nbCorpora)) {
+        return 2;
+    }
+
+    ret = bench_check_golden(goldenPath, outDir, update, update ? NULL : batchPath);
+    if (!ret && !checkOnly && baselinePath) {
+        ret = bench_check_perf(baselinePath, tolerance, seconds, nbRuns, update);
+    }
+    lib_uncompress_corpus_free(corpora, nbCorpora);
+    return (ret < 0) ? 2 : ret;
+}
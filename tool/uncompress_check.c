@@ -0,0 +1,2284 @@
+/**
+  ******************************************************************************
+  * \file uncompress_check.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Functional checks of the decoder and of the libraries built on it.
+  *       Each check decodes the corpora of uncompress_bench (see lib_uncompress_corpus.h)
+  *       and compares a library with a plain reference: a scalar version of the
+  *       computation, or the samples given by lib_uncompress_data_with_state.
+  *       Handmade frames cover the cases the corpora do not reach.
+  *
+  *       usage: uncompress_check -s slots_data.dart [-i uncompress_ingest] [-k check]
+  *       without -k, all the checks are run. The replay and socket inputs of
+  *       uncompress_ingest are only checked with -i.
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_uncompress.h"
+#include "lib_uncompress_stats.h"
+#include "lib_uncompress_aggregate.h"
+#include "lib_uncompress_fill.h"
+#include "lib_uncompress_cache.h"
+#include "lib_uncompress_session.h"
+#include "lib_uncompress_archive.h"
+#include "lib_uncompress_corpus.h"
+#include "lib_uncompress_ingest.h"
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define CHECK_TIME              1600000020  // multiple of 60, start of the handmade frames
+#define CHECK_TEMPE             3700
+#define CHECK_NAME_LEN          (UNCOMPRESS_CORPUS_NAME_LEN + 64)  // name of a check, its corpus and frame in the messages
+#define CHECK_CACHE_MAX_BYTES   (256UL * 1024 * 1024)   // no compaction with any corpus
+#define CHECK_CACHE_SMALL_BYTES (64UL * 1024)
+#define CHECK_SESSION_NB_CACHED 4           // frames decoded again on most accesses
+#define CHECK_SESSION_MAX_READ  3000        // samples
+#define CHECK_SESSION_NB_RANDOM 2000
+#define CHECK_STATE_CORRUPT_EVERY   97      // frames, bits of the blob flipped one by one
+#define CHECK_RESYNC_PERIOD     60
+#define CHECK_ARCHIVE_NB_DAMAGES    2048    // bits flipped and truncations tried per corpus
+#define CHECK_ARCHIVE_DAMAGED_RECORDS   (4 * UNCOMPRESS_ARCHIVE_BLOCK_RECORDS)  // first records of a corpus, damaged
+#define CHECK_STATS_NB_RANDOM   500         // random series
+#define CHECK_STATS_MAX_RANDOM  5000        // samples in a random series
+#define CHECK_STATS_OFFSET      7           // first sample of a series not aligned on a block
+#define CHECK_STATS_MASK_FILL   0xA5A5A5A5  // mask words before the computation
+#define CHECK_INGEST_WINDOW     64          // reorder window, a power of 2
+#define CHECK_INGEST_MAX_FRAMES 3000        // first frames of a corpus sent by a device
+#define CHECK_INGEST_SHUFFLE    8           // max distance of a frame from its place, in the frames of its device
+#define CHECK_INGEST_DUPLICATE_EVERY    19  // frames, on average
+#define CHECK_INGEST_DROP_EVERY 37          // frames, and a run longer than the window
+#define CHECK_INGEST_PAUSE      256         // frames of the other devices between the two streams of a restart
+#define CHECK_INGEST_SKEW       16          // max frames between the fastest and the slowest producer
+#define CHECK_INGEST_NB_PRODUCERS   4
+#define CHECK_INGEST_NB_CLIENTS 3           // socket clients, each sending all the frames of some devices
+#define CHECK_INGEST_RECORD_LEN (9 + UINT8_MAX)     // replay record: deviceId, counter, len, frame
+#define CHECK_INGEST_TIMEOUT_MS 100         // reorder timeout of the timeout check
+#define CHECK_INGEST_WAIT_MS    20000       // for the reorder timeouts and the ingest tool
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+typedef struct {
+    const char  *name;
+    int         (*run)(void);   // number of errors
+} def_check_t;
+
+// Aggregation parameters compared to the reference
+typedef struct {
+    uint32_t    width;
+    uint32_t    nbBuckets;
+} def_check_agg_config_t;
+
+// A corrupted frame and what lib_uncompress_data_resync must recover from it, decoded after lib_uncompress_state_init
+typedef struct {
+    const char      *name;
+    const uint32_t  *codes;
+    uint16_t        nbCodes;
+    uint16_t        firstBit;       // the only skipped range
+    uint16_t        nbBits;
+    uint32_t        nbDropped;
+    uint32_t        nbSamples;
+    uint32_t        nbRecovered;    // last samples, from the anchor: anchorTime + k * CHECK_RESYNC_PERIOD, anchorTempe
+    uint32_t        anchorTime;
+    int16_t         anchorTempe;
+} def_check_resync_frame_t;
+
+// What a device of the ingest check does with its frame counter
+typedef enum {
+    CHECK_INGEST_PLAIN = 0,
+    CHECK_INGEST_WRAP,          // counter wraps around in the middle
+    CHECK_INGEST_DROP,          // frames never sent
+    CHECK_INGEST_RESTART,       // counter back to 0 after a third of the frames
+} def_check_ingest_role_t;
+
+// A frame sent to the ingest engine
+typedef struct {
+    uint64_t    key;            // place in the frames of the device, then index
+    uint32_t    deviceId;
+    uint32_t    seq;
+    const uint8_t *frame;       // in the corpus
+    uint8_t     len;
+    uint16_t    device;         // index in def_check_ingest_t
+} def_check_ingest_event_t;
+
+typedef struct {
+    uint32_t    id;
+    def_check_ingest_role_t role;
+    def_check_ingest_event_t *events;   // in the order sent
+    uint32_t    nbEvents;
+    uint32_t    restartAt;      // events of the first stream
+    uint32_t    nbFrames;       // frames sent, duplicates excepted
+    uint32_t    nbDuplicates;
+    uint32_t    nbLost;
+    record_t    *ref;           // decoded in sequence
+    uint32_t    nbRef;
+    uint32_t    refSize;
+    record_t    *records;       // given to the sink
+    uint32_t    nbRecords;
+    uint32_t    size;
+    uint32_t    nbClosed;       // calls of the sink without records
+    uint8_t     error;
+} def_check_ingest_device_t;
+
+typedef struct {
+    def_check_ingest_device_t devices[UNCOMPRESS_CORPUS_MAX];
+    uint16_t    nbDevices;
+    def_check_ingest_event_t *events;   // frames of all the devices, in the order sent
+    uint32_t    nbEvents;
+} def_check_ingest_t;
+
+typedef struct {
+    uncompress_ingest_t *p_ingest;
+    const def_check_ingest_t *p_check;
+    uint32_t    id;
+    uint32_t    *progress;      // next event of each producer (atomic)
+    const char  *path;          // socket, for the clients of the ingest tool
+    int         error;
+    pthread_t   thread;
+} def_check_ingest_producer_t;
+
+// Compares the bytes given to a writer with a file
+typedef struct {
+    FILE        *file;
+    uint64_t    offset;
+} def_check_file_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static int check_decode(void);
+static uint16_t check_period_of(const samples_t *p_samples, uint32_t idx);
+static void check_ref_aggregate(uncompress_bucket_t *buckets, uint32_t nbBuckets, uint32_t width, uint32_t *p_origin,
+                                uint32_t *p_lastTime, uint32_t *p_nbDropped, const samples_t *p_samples);
+static int check_compare_buckets(const char *name, const uncompress_aggregate_t *p_agg, const uncompress_bucket_t *ref,
+                                 uint32_t origin, uint32_t nbDropped);
+static int check_decode_period_gap(const char *name);
+static int check_aggregate_frame(void);
+static int check_aggregate_m4(void);
+static int check_aggregate(void);
+static uint32_t check_ref_fill(record_t *records, uint32_t first, uint32_t nb, const samples_t *p_samples,
+                               uint32_t *p_lastTime, uint8_t *filled);
+static uint32_t check_fill_part(uncompress_fill_t *p_fill, record_t *records, uint32_t first, uint32_t nb,
+                                const samples_t *p_samples, uint32_t *mask);
+static int check_fill_frame(void);
+static int check_fill(void);
+static int check_compare_samples(const char *name, const samples_t *p_samples, const samples_t *p_ref);
+static int check_compare_state(const char *name, const uncompress_state_t *p_state, const uncompress_state_t *p_ref);
+static int check_temp_path(char *path, uint32_t size, const char *name);
+static int check_cache_corpus(uncompress_cache_t *p_cache, const uncompress_corpus_t *p_corpus, uint32_t maxBytes,
+                              uncompress_cache_stats_t *p_stats);
+static int check_cache(void);
+static uint32_t check_decode_corpus(const uncompress_corpus_t *p_corpus, record_t **pp_records);
+static int check_session_read(const char *name, uncompress_session_t *p_session, const record_t *ref, uint32_t nbRef,
+                              uint32_t first, uint32_t nb, record_t *output);
+static int check_session(void);
+static int check_state_blob(void);
+static int check_state_corrupted(const uint8_t *blob);
+static int check_state(void);
+static int check_resync_corpus(const uncompress_corpus_t *p_corpus, const uncompress_resync_config_t *p_config);
+static int check_resync_frame(const def_check_resync_frame_t *p_frame);
+static int check_resync(void);
+static int check_compare_records(const char *name, const record_t *records, const record_t *ref, uint32_t nb);
+static int check_archive_damaged(const char *name, const uint8_t *archive, uint32_t len, uint32_t nbRecords, record_t *records);
+static int check_archive(void);
+static void check_ref_stats(const record_t *records, uint32_t nb, uncompress_stats_t *p_stats, uint32_t *mask);
+static int check_stats_records(const char *name, const record_t *records, uint32_t nb, const samples_t *p_samples);
+static void check_stats_random(record_t *records, uint32_t nb, uint32_t level, uint32_t *p_seed);
+static int check_stats(void);
+static int check_ingest_append(record_t **pp_records, uint32_t *p_nb, uint32_t *p_size, const record_t *records, uint32_t nb);
+static int check_ingest_compare_events(const void *a, const void *b);
+static int check_ingest_device(def_check_ingest_device_t *p_device, uint16_t idx, const uncompress_corpus_t *p_corpus,
+                               def_check_ingest_role_t role, uint32_t *p_seed);
+static int check_ingest_merge(def_check_ingest_t *p_check);
+static void check_ingest_sink(void *p_user, uint32_t deviceId, void **pp_session, const record_t *records, uint32_t nbRecords);
+static void *check_ingest_producer(void *arg);
+static int check_ingest_compare_device(const char *name, def_check_ingest_device_t *p_device);
+static int check_ingest_run(def_check_ingest_t *p_check);
+static int check_ingest_wait_stats(uncompress_ingest_t *p_ingest, uint64_t nbFrames, uint64_t nbLost);
+static int check_ingest_timeout(void);
+static uint32_t check_ingest_record(uint8_t *p, const def_check_ingest_event_t *p_event);
+static uint8_t check_file_flush(void *p_user, const uint8_t *data, uint32_t len);
+static int check_ingest_compare_csv(const char *name, const char *path, const record_t *records, uint32_t nb);
+static int check_ingest_compare_dir(const char *name, const char *dir, const def_check_ingest_t *p_check);
+static pid_t check_ingest_spawn(char **args);
+static int check_ingest_wait_tool(const char *name, pid_t pid);
+static int check_temp_dir(char *path, uint32_t size, const char *name);
+static int check_ingest_replay(const def_check_ingest_t *p_check);
+static int check_ingest_send(int fd, const uint8_t *data, uint32_t len);
+static void *check_ingest_client(void *arg);
+static int check_ingest_socket(const def_check_ingest_t *p_check);
+static int check_ingest(void);
+static void check_usage(const char *name);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+static uncompress_corpus_t corpora[UNCOMPRESS_CORPUS_MAX];
+static uint32_t nbCorpora;
+static samples_t samples;
+static samples_t refSamples;
+static const char *ingestToolPath;     // uncompress_ingest, -i
+static const def_check_t checks[] = {
+    { "decode", check_decode },
+    { "aggregate", check_aggregate },
+    { "fill", check_fill },
+    { "cache", check_cache },
+    { "session", check_session },
+    { "state", check_state },
+    { "resync", check_resync },
+    { "archive", check_archive },
+    { "stats", check_stats },
+    { "ingest", check_ingest },
+};
+// A gap with a change of period in the middle
+static const uint32_t periodGapCodes[] = {
+    CT_NEW_PERIOD_PREFIX_VALUE, CT_NEW_PERIOD_PREFIX_NB_BITS, 60, CT_NEW_PERIOD_NB_BITS,
+    CT_DIRECT_PREFIX_VALUE, CT_DIRECT_PREFIX_NB_BITS, CHECK_TIME, CT_DIRECT_NB_BITS,
+    C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, CHECK_TEMPE, C9_DIRECT_NB_BITS,
+    CT_INVALID_VALUE, CT_INVALID_NB_BITS,
+    C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, CHECK_TEMPE + 1, C9_DIRECT_NB_BITS,
+    CT_NEW_PERIOD_PREFIX_VALUE, CT_NEW_PERIOD_PREFIX_NB_BITS, 120, CT_NEW_PERIOD_NB_BITS,
+    CT_INVALID_VALUE, CT_INVALID_NB_BITS,
+    C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, CHECK_TEMPE + 2, C9_DIRECT_NB_BITS,
+    CT_DIFF_UNCHANGED_VALUE, CT_DIFF_UNCHANGED_NB_BITS,
+    C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, CHECK_TEMPE + 3, C9_DIRECT_NB_BITS,
+};
+// Codes of the handmade corrupted frames
+#define CHECK_DIRECT(time)      CT_DIRECT_PREFIX_VALUE, CT_DIRECT_PREFIX_NB_BITS, (time), CT_DIRECT_NB_BITS
+#define CHECK_TEMPE_DIRECT(t)   C9_DIRECT_PREFIX_VALUE, C9_DIRECT_PREFIX_NB_BITS, (t), C9_DIRECT_NB_BITS
+#define CHECK_RESERVED          CT_RESERVED_VALUE, CT_RESERVED_NB_BITS
+#define CHECK_UNCHANGED         CT_DIFF_UNCHANGED_VALUE, CT_DIFF_UNCHANGED_NB_BITS, 3, 3    // time and temperature
+// Two samples, a reserved code at bit 80, then an anchor whose sample is followed by a reserved code
+// (false, dropped), and the right anchor at bit 144 with two samples
+static const uint32_t resyncFalseAnchorCodes[] = {
+    CT_NEW_PERIOD_PREFIX_VALUE, CT_NEW_PERIOD_PREFIX_NB_BITS, CHECK_RESYNC_PERIOD, CT_NEW_PERIOD_NB_BITS,
+    CHECK_DIRECT(CHECK_TIME), CHECK_TEMPE_DIRECT(CHECK_TEMPE), CHECK_UNCHANGED,
+    CHECK_RESERVED,
+    CHECK_DIRECT(CHECK_TIME + 600), CHECK_TEMPE_DIRECT(CHECK_TEMPE + 1), CHECK_RESERVED,
+    CHECK_DIRECT(CHECK_TIME + 1200), CHECK_TEMPE_DIRECT(CHECK_TEMPE + 2), CHECK_UNCHANGED, CHECK_UNCHANGED,
+};
+// No time reference: a reserved code first, an anchor before 2020 (not tried), an anchor whose
+// temperature is differential (no reference), and the right anchor at bit 79 ending the frame
+static const uint32_t resyncNoReferenceCodes[] = {
+    CHECK_RESERVED,
+    CHECK_DIRECT(1000),
+    CHECK_DIRECT(0xF0000000), 3, 3,
+    CHECK_DIRECT(CHECK_TIME), CHECK_TEMPE_DIRECT(CHECK_TEMPE),
+};
+// An anchor followed by more samples without time than allowed, then the right anchor at bit 80
+static const uint32_t resyncUnconfirmedCodes[] = {
+    CHECK_RESERVED,
+    CHECK_DIRECT(CHECK_TIME), CHECK_TEMPE_DIRECT(CHECK_TEMPE),
+    CT_UNRECEIVED_PREFIX_VALUE, CT_UNRECEIVED_PREFIX_NB_BITS, CT_UNRECEIVED_COUNTER_MAX, CT_UNRECEIVED_COUNTER_NB_BITS,
+    CT_UNRECEIVED_PREFIX_VALUE, CT_UNRECEIVED_PREFIX_NB_BITS, CT_UNRECEIVED_COUNTER_MAX, CT_UNRECEIVED_COUNTER_NB_BITS,
+    CHECK_DIRECT(CHECK_TIME + 3600), CHECK_TEMPE_DIRECT(CHECK_TEMPE),
+};
+#define CHECK_RESYNC_FRAME(codes)   #codes, codes, sizeof(codes) / sizeof(codes[0])
+static const def_check_resync_frame_t resyncFrames[] = {
+    { CHECK_RESYNC_FRAME(resyncFalseAnchorCodes), 80, 64, 1, 5, 3, CHECK_TIME + 1200, CHECK_TEMPE + 2 },
+    { CHECK_RESYNC_FRAME(resyncNoReferenceCodes), 0, 79, 0, 1, 1, CHECK_TIME, CHECK_TEMPE },
+    { CHECK_RESYNC_FRAME(resyncUnconfirmedCodes), 0, 80, 1 + 2 * CT_UNRECEIVED_COUNTER_MAX, 1, 1, CHECK_TIME + 3600, CHECK_TEMPE },
+};
+static const def_check_agg_config_t aggConfigs[] = {
+    { 3600, 4096 },     // hours, over about 6 months
+    { 7, 1 << 18 },     // not a divisor of the periods, over about 3 weeks
+};
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+// lib_uncompress_data, which keeps its state between the frames, gives the samples and the state of
+// lib_uncompress_data_with_state, frame by frame on every corpus
+static int check_decode(void)
+{
+    int nbErrors = 0;
+
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        uncompress_state_t state, globalState;
+        uint32_t idx = 0, nbFrames = 0;
+        uint8_t *frame, len;
+
+        lib_uncompress_state_init(&state);
+        lib_uncompress_set_state(&state);
+        while (lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            uint8_t ok = lib_uncompress_data(frame, len, &samples);
+            uint8_t same;
+
+            lib_uncompress_state_new_frame(&state);
+            same = (ok == lib_uncompress_data_with_state(frame, len, &refSamples, &state))
+                   && (samples.nbSamples == refSamples.nbSamples);
+            for (uint32_t i = 0; same && (i < samples.nbSamples); i++) {
+                same = (samples.samples[i].time == refSamples.samples[i].time)
+                       && (samples.samples[i].tempe == refSamples.samples[i].tempe);
+            }
+            lib_uncompress_get_state(&globalState);
+            if (!same || (globalState.lastValidTime != state.lastValidTime) || (globalState.currentPeriod != state.currentPeriod)
+                || (globalState.nbPeriodToAdd != state.nbPeriodToAdd) || (globalState.lastValidTempe != state.lastValidTempe)) {
+                fprintf(stderr, "decode: %s: frame %u: %u samples instead of %u, or another state\n",
+                        corpora[c].name, nbFrames, samples.nbSamples, refSamples.nbSamples);
+                nbErrors++;
+                break;
+            }
+            nbFrames++;
+        }
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Period of a sample, by a linear search from the first change
+static uint16_t check_period_of(const samples_t *p_samples, uint32_t idx)
+{
+    uint16_t period = UINT16_MAX;
+    for (uint16_t i = 0; i < p_samples->nbPeriods; i++) {
+        if (p_samples->periods[i].firstSample <= idx) {
+            period = p_samples->periods[i].period;
+        }
+    }
+    return period;
+}
+
+//****************************************************************************
+// Scalar reference of lib_uncompress_aggregate_add: time of each sample, then its bucket
+static void check_ref_aggregate(uncompress_bucket_t *buckets, uint32_t nbBuckets, uint32_t width, uint32_t *p_origin,
+                                uint32_t *p_lastTime, uint32_t *p_nbDropped, const samples_t *p_samples)
+{
+    for (uint32_t i = 0; i < p_samples->nbSamples; i++) {
+        const record_t *p_record = &p_samples->samples[i];
+        uint16_t period = check_period_of(p_samples, i);
+        uint64_t time;
+
+        if (p_record->time != UNCOMPRESS_INVALID_TIME) {
+            time = p_record->time;
+        } else if ((*p_lastTime == UNCOMPRESS_INVALID_TIME) || (period == 0) || (period == UINT16_MAX) ||
+                   ((uint64_t)*p_lastTime + period >= UNCOMPRESS_INVALID_TIME)) {
+            *p_lastTime = UNCOMPRESS_INVALID_TIME;
+            (*p_nbDropped)++;
+            continue;
+        } else {
+            time = (uint64_t)*p_lastTime + period;
+        }
+        *p_lastTime = (uint32_t)time;
+        if (*p_origin == UNCOMPRESS_AGGREGATE_AUTO_ORIGIN) {
+            *p_origin = (uint32_t)(time - time % width);
+        }
+        if ((time < *p_origin) || ((time - *p_origin) / width >= nbBuckets)) {
+            (*p_nbDropped)++;
+            continue;
+        }
+        uncompress_bucket_t *p_bucket = &buckets[(time - *p_origin) / width];
+        if ((p_record->tempe == INVALID_TEMPERATURE) || (p_record->tempe == UNCOMPRESS_UNRECEIVED_TEMPERATURE)) {
+            p_bucket->nbGaps++;
+            continue;
+        }
+        if (!p_bucket->count || (p_record->tempe < p_bucket->minTempe)) {
+            p_bucket->minTempe = p_record->tempe;
+        }
+        if (!p_bucket->count || (p_record->tempe > p_bucket->maxTempe)) {
+            p_bucket->maxTempe = p_record->tempe;
+        }
+        p_bucket->sumTempe += p_record->tempe;
+        p_bucket->count++;
+    }
+}
+
+//****************************************************************************
+static int check_compare_buckets(const char *name, const uncompress_aggregate_t *p_agg, const uncompress_bucket_t *ref,
+                                 uint32_t origin, uint32_t nbDropped)
+{
+    if ((p_agg->origin != origin) || (p_agg->nbDropped != nbDropped)) {
+        fprintf(stderr, "%s: origin %u, %u dropped instead of %u, %u\n", name, p_agg->origin, p_agg->nbDropped, origin, nbDropped);
+        return 1;
+    }
+    for (uint32_t b = 0; b < p_agg->nbBuckets; b++) {
+        const uncompress_bucket_t *p_bucket = &p_agg->buckets[b];
+        if ((p_bucket->count != ref[b].count) || (p_bucket->nbGaps != ref[b].nbGaps) || (p_bucket->sumTempe != ref[b].sumTempe) ||
+            (p_bucket->count && ((p_bucket->minTempe != ref[b].minTempe) || (p_bucket->maxTempe != ref[b].maxTempe)))) {
+            fprintf(stderr, "%s: bucket %u: %u samples, %u gaps, sum %lld instead of %u, %u, %lld\n", name, b,
+                    p_bucket->count, p_bucket->nbGaps, (long long)p_bucket->sumTempe,
+                    ref[b].count, ref[b].nbGaps, (long long)ref[b].sumTempe);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+// Decode periodGapCodes in samples
+static int check_decode_period_gap(const char *name)
+{
+    uncompress_state_t state;
+    uint8_t frame[UINT8_MAX];
+    uint8_t len = lib_uncompress_corpus_frame(frame, periodGapCodes, sizeof(periodGapCodes) / sizeof(periodGapCodes[0]));
+
+    lib_uncompress_state_init(&state);
+    if (!len || !lib_uncompress_data_with_state(frame, len, &samples, &state) || (samples.nbSamples != 4) ||
+        (samples.nbPeriods != 2) || (samples.periods[0].period != 60) ||
+        (samples.periods[1].firstSample != 2) || (samples.periods[1].period != 120) ||
+        (samples.samples[3].time != CHECK_TIME + 3 * 120)) {
+        fprintf(stderr, "%s: handmade frame: bad decoding, %u samples, %u periods\n", name, samples.nbSamples, samples.nbPeriods);
+        return 1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// A gap with a change of period in the middle: each sample is placed with its own period
+static int check_aggregate_frame(void)
+{
+    // samples at CHECK_TIME, +60, +60+120, and +3*120 as decoded
+    const uint32_t expected[] = { 0, 1, 3, 6 };
+    uncompress_bucket_t buckets[8];
+    uncompress_aggregate_t agg;
+    int nbErrors = 0;
+
+    if (check_decode_period_gap("aggregate")) {
+        return 1;
+    }
+    lib_uncompress_aggregate_init(&agg, buckets, 8, UNCOMPRESS_AGGREGATE_AUTO_ORIGIN, 60);
+    lib_uncompress_aggregate_add_samples(&agg, &samples);
+    for (uint32_t s = 0; s < 4; s++) {
+        if ((buckets[expected[s]].count != 1) || (buckets[expected[s]].minTempe != CHECK_TEMPE + (int16_t)s)) {
+            fprintf(stderr, "aggregate: handmade frame: sample %u not in bucket %u\n", s, expected[s]);
+            nbErrors++;
+        }
+    }
+    if ((agg.origin != CHECK_TIME) || agg.nbDropped) {
+        fprintf(stderr, "aggregate: handmade frame: origin %u, %u dropped\n", agg.origin, agg.nbDropped);
+        nbErrors++;
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Every corpus added frame by frame to lib_uncompress_m4_t, against lib_uncompress_downsample_m4 on all its samples
+static int check_aggregate_m4(void)
+{
+    const uint32_t nbPixels[] = { 1, 7, 320, 4096 };
+    record_t *output = malloc(2 * UNCOMPRESS_M4_MAX_RECORDS(4096) * sizeof(record_t));
+    int nbErrors = 0;
+
+    if (!output) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        uncompress_m4_t *p_m4 = lib_uncompress_m4_create();
+        uncompress_state_t state;
+        record_t *all = NULL;
+        uint32_t idx = 0, nbAll = 0;
+        uint8_t *frame, len;
+
+        lib_uncompress_state_init(&state);
+        while (p_m4 && lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            lib_uncompress_state_new_frame(&state);
+            if (!lib_uncompress_data_with_state(frame, len, &samples, &state)) {
+                continue;
+            }
+            record_t *records = realloc(all, (nbAll + samples.nbSamples) * sizeof(record_t));
+            if (!records || !lib_uncompress_m4_add_samples(p_m4, &samples)) {
+                lib_uncompress_m4_free(p_m4);
+                p_m4 = NULL;
+                all = records ? records : all;
+                break;
+            }
+            all = records;
+            memcpy(&all[nbAll], samples.samples, samples.nbSamples * sizeof(record_t));
+            nbAll += samples.nbSamples;
+        }
+        if (!p_m4) {
+            fprintf(stderr, "out of memory\n");
+            free(all);
+            nbErrors++;
+            break;
+        }
+        for (uint32_t p = 0; p < sizeof(nbPixels) / sizeof(nbPixels[0]); p++) {
+            record_t *ref = &output[UNCOMPRESS_M4_MAX_RECORDS(4096)];
+            uint32_t nb = lib_uncompress_m4_finish(p_m4, nbPixels[p], output);
+            uint32_t nbRef = lib_uncompress_downsample_m4(all, nbAll, nbPixels[p], ref);
+            if ((nb != nbRef) || memcmp(output, ref, nb * sizeof(record_t))) {
+                fprintf(stderr, "aggregate: %s, M4 on %u pixels: %u records, %u expected, or different records\n",
+                        corpora[c].name, nbPixels[p], nb, nbRef);
+                nbErrors++;
+            }
+        }
+        lib_uncompress_m4_free(p_m4);
+        free(all);
+    }
+    free(output);
+    return nbErrors;
+}
+
+//****************************************************************************
+// Every corpus, frame by frame, against the scalar reference
+static int check_aggregate(void)
+{
+    int nbErrors = check_aggregate_frame() + check_aggregate_m4();
+
+    for (uint32_t k = 0; k < sizeof(aggConfigs) / sizeof(aggConfigs[0]); k++) {
+        uint32_t nbBuckets = aggConfigs[k].nbBuckets, width = aggConfigs[k].width;
+        uncompress_bucket_t *buckets = malloc(nbBuckets * sizeof(uncompress_bucket_t));
+        uncompress_bucket_t *ref = calloc(nbBuckets, sizeof(uncompress_bucket_t));
+
+        if (!buckets || !ref) {
+            fprintf(stderr, "out of memory\n");
+            free(buckets);
+            free(ref);
+            return nbErrors + 1;
+        }
+        for (uint32_t c = 0; c < nbCorpora; c++) {
+            uncompress_aggregate_t agg;
+            uncompress_state_t state;
+            uint32_t idx = 0, origin = UNCOMPRESS_AGGREGATE_AUTO_ORIGIN, lastTime = UNCOMPRESS_INVALID_TIME, nbDropped = 0;
+            uint8_t *frame, len;
+            char name[CHECK_NAME_LEN];
+
+            memset(ref, 0, nbBuckets * sizeof(uncompress_bucket_t));
+            lib_uncompress_aggregate_init(&agg, buckets, nbBuckets, UNCOMPRESS_AGGREGATE_AUTO_ORIGIN, width);
+            lib_uncompress_state_init(&state);
+            while (lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+                lib_uncompress_state_new_frame(&state);
+                if (lib_uncompress_data_with_state(frame, len, &samples, &state)) {
+                    lib_uncompress_aggregate_add_samples(&agg, &samples);
+                    check_ref_aggregate(ref, nbBuckets, width, &origin, &lastTime, &nbDropped, &samples);
+                }
+            }
+            snprintf(name, sizeof(name), "aggregate: %s, width %u", corpora[c].name, width);
+            if (check_compare_buckets(name, &agg, ref, origin, nbDropped)) {
+                nbErrors++;
+            }
+        }
+        free(buckets);
+        free(ref);
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Scalar reference of lib_uncompress_fill_times, on nb samples from first: times and mask of the filled samples
+static uint32_t check_ref_fill(record_t *records, uint32_t first, uint32_t nb, const samples_t *p_samples,
+                               uint32_t *p_lastTime, uint8_t *filled)
+{
+    uint32_t nbFilled = 0;
+
+    for (uint32_t i = first; i < first + nb; i++) {
+        uint16_t period = check_period_of(p_samples, i);
+
+        filled[i] = 0;
+        if (records[i].time != UNCOMPRESS_INVALID_TIME) {
+            *p_lastTime = records[i].time;
+        } else if ((*p_lastTime == UNCOMPRESS_INVALID_TIME) || (period == 0) || (period == UINT16_MAX) ||
+                   ((uint64_t)*p_lastTime + period >= UNCOMPRESS_INVALID_TIME)) {
+            *p_lastTime = UNCOMPRESS_INVALID_TIME;
+        } else {
+            *p_lastTime += period;
+            records[i].time = *p_lastTime;
+            filled[i] = 1;
+            nbFilled++;
+        }
+    }
+    return nbFilled;
+}
+
+//****************************************************************************
+// Fill samples from first with lib_uncompress_fill_times, the periods given from this sample
+static uint32_t check_fill_part(uncompress_fill_t *p_fill, record_t *records, uint32_t first, uint32_t nb,
+                                const samples_t *p_samples, uint32_t *mask)
+{
+    uncompress_period_t periods[UNCOMPRESS_NB_MAX_PERIODS];
+    uint16_t nbPeriods = 1;
+
+    periods[0].firstSample = 0;
+    periods[0].period = check_period_of(p_samples, first);
+    for (uint16_t i = 0; i < p_samples->nbPeriods; i++) {
+        if (p_samples->periods[i].firstSample > first) {
+            periods[nbPeriods].firstSample = p_samples->periods[i].firstSample - first;
+            periods[nbPeriods++].period = p_samples->periods[i].period;
+        }
+    }
+    return lib_uncompress_fill_times(p_fill, &records[first], nb, periods, nbPeriods, mask);
+}
+
+//****************************************************************************
+// The gap of periodGapCodes is filled with the period of each sample
+static int check_fill_frame(void)
+{
+    const uint32_t expected[] = { CHECK_TIME, CHECK_TIME + 60, CHECK_TIME + 60 + 120, CHECK_TIME + 3 * 120 };
+    uncompress_fill_t fill;
+    uint32_t mask = 0;
+    int nbErrors = 0;
+
+    if (check_decode_period_gap("fill")) {
+        return 1;
+    }
+    lib_uncompress_fill_init(&fill);
+    if ((lib_uncompress_fill_samples(&fill, &samples, &mask) != 2) || (mask != 0x6)) {
+        fprintf(stderr, "fill: handmade frame: mask %08x\n", mask);
+        nbErrors++;
+    }
+    for (uint32_t s = 0; s < 4; s++) {
+        if (samples.samples[s].time != expected[s]) {
+            fprintf(stderr, "fill: handmade frame: sample %u at %u instead of %u\n", s, samples.samples[s].time, expected[s]);
+            nbErrors++;
+        }
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Every corpus, frame by frame, against the scalar reference. Each frame is filled in two calls,
+// cut in the middle of a block, to check the gaps and the periods across calls.
+static int check_fill(void)
+{
+    record_t *ref = malloc(SRV_UNCOMPRESS_NB_MAX_SAMPLES * sizeof(record_t));
+    uint8_t *filled = malloc(SRV_UNCOMPRESS_NB_MAX_SAMPLES);
+    uint32_t *mask = malloc(UNCOMPRESS_STATS_MASK_WORDS(SRV_UNCOMPRESS_NB_MAX_SAMPLES) * sizeof(uint32_t));
+    int nbErrors = check_fill_frame();
+
+    if (!ref || !filled || !mask) {
+        fprintf(stderr, "out of memory\n");
+        free(ref);
+        free(filled);
+        free(mask);
+        return nbErrors + 1;
+    }
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        uncompress_fill_t fill;
+        uncompress_state_t state;
+        uint32_t idx = 0, lastTime = UNCOMPRESS_INVALID_TIME, nbFilled = 0, nbRefFilled = 0, nbFrame = 0;
+        uint8_t *frame, len;
+
+        lib_uncompress_fill_init(&fill);
+        lib_uncompress_state_init(&state);
+        while (lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            uint32_t nb, cut;
+
+            lib_uncompress_state_new_frame(&state);
+            if (!lib_uncompress_data_with_state(frame, len, &samples, &state)) {
+                continue;
+            }
+            nb = samples.nbSamples;
+            cut = (nb / 3) | 1;     // odd, not a block boundary
+            if (cut > nb) {
+                cut = nb;
+            }
+            memcpy(ref, samples.samples, nb * sizeof(record_t));
+            nbRefFilled += check_ref_fill(ref, 0, nb, &samples, &lastTime, filled);
+            nbFilled += check_fill_part(&fill, samples.samples, 0, cut, &samples, mask);
+            for (uint32_t i = 0; i < cut; i++) {
+                if (((mask[i >> 5] >> (i & 31)) & 1) != filled[i]) {
+                    fprintf(stderr, "fill: %s: frame %u: sample %u: bad mask\n", corpora[c].name, nbFrame, i);
+                    nbErrors++;
+                    break;
+                }
+            }
+            nbFilled += check_fill_part(&fill, samples.samples, cut, nb - cut, &samples, mask);
+            for (uint32_t i = cut; i < nb; i++) {
+                if (((mask[(i - cut) >> 5] >> ((i - cut) & 31)) & 1) != filled[i]) {
+                    fprintf(stderr, "fill: %s: frame %u: sample %u: bad mask\n", corpora[c].name, nbFrame, i);
+                    nbErrors++;
+                    break;
+                }
+            }
+            for (uint32_t i = 0; i < nb; i++) {
+                if (samples.samples[i].time != ref[i].time) {
+                    fprintf(stderr, "fill: %s: frame %u: sample %u at %u instead of %u\n", corpora[c].name, nbFrame, i,
+                            samples.samples[i].time, ref[i].time);
+                    nbErrors++;
+                    break;
+                }
+            }
+            nbFrame++;
+        }
+        if (nbFilled != nbRefFilled) {
+            fprintf(stderr, "fill: %s: %u samples filled instead of %u\n", corpora[c].name, nbFilled, nbRefFilled);
+            nbErrors++;
+        }
+    }
+    free(ref);
+    free(filled);
+    free(mask);
+    return nbErrors;
+}
+
+//****************************************************************************
+// Same samples and periods
+static int check_compare_samples(const char *name, const samples_t *p_samples, const samples_t *p_ref)
+{
+    if ((p_samples->nbSamples != p_ref->nbSamples) || (p_samples->nbPeriods != p_ref->nbPeriods)) {
+        fprintf(stderr, "%s: %u samples, %u periods instead of %u, %u\n", name, p_samples->nbSamples, p_samples->nbPeriods,
+                p_ref->nbSamples, p_ref->nbPeriods);
+        return 1;
+    }
+    for (uint32_t i = 0; i < p_ref->nbSamples; i++) {
+        if ((p_samples->samples[i].time != p_ref->samples[i].time) || (p_samples->samples[i].tempe != p_ref->samples[i].tempe)) {
+            fprintf(stderr, "%s: sample %u: %u;%d instead of %u;%d\n", name, i, p_samples->samples[i].time,
+                    p_samples->samples[i].tempe, p_ref->samples[i].time, p_ref->samples[i].tempe);
+            return 1;
+        }
+    }
+    for (uint16_t i = 0; i < p_ref->nbPeriods; i++) {
+        if ((p_samples->periods[i].firstSample != p_ref->periods[i].firstSample) ||
+            (p_samples->periods[i].period != p_ref->periods[i].period)) {
+            fprintf(stderr, "%s: period %u: %u from sample %u instead of %u from %u\n", name, i, p_samples->periods[i].period,
+                    p_samples->periods[i].firstSample, p_ref->periods[i].period, p_ref->periods[i].firstSample);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+static int check_compare_state(const char *name, const uncompress_state_t *p_state, const uncompress_state_t *p_ref)
+{
+    if ((p_state->lastValidTime != p_ref->lastValidTime) || (p_state->currentPeriod != p_ref->currentPeriod) ||
+        (p_state->nbPeriodToAdd != p_ref->nbPeriodToAdd) || (p_state->lastValidTempe != p_ref->lastValidTempe)) {
+        fprintf(stderr, "%s: state %u, %u, %u, %d instead of %u, %u, %u, %d\n", name, p_state->lastValidTime,
+                p_state->currentPeriod, p_state->nbPeriodToAdd, p_state->lastValidTempe, p_ref->lastValidTime,
+                p_ref->currentPeriod, p_ref->nbPeriodToAdd, p_ref->lastValidTempe);
+        return 1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// A new empty file, in TMPDIR
+static int check_temp_path(char *path, uint32_t size, const char *name)
+{
+    const char *dir = getenv("TMPDIR");
+    int fd;
+
+    if (!dir) {
+        dir = "/tmp";
+    }
+    if (snprintf(path, size, "%s/uncompress_check_%s.XXXXXX", dir, name) >= (int)size) {
+        fprintf(stderr, "%s: path too long in %s\n", name, dir);
+        return -1;
+    }
+    fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+//****************************************************************************
+// A new empty directory, in TMPDIR
+static int check_temp_dir(char *path, uint32_t size, const char *name)
+{
+    const char *dir = getenv("TMPDIR");
+
+    if (!dir) {
+        dir = "/tmp";
+    }
+    if (snprintf(path, size, "%s/uncompress_check_%s.XXXXXX", dir, name) >= (int)size) {
+        fprintf(stderr, "%s: path too long in %s\n", name, dir);
+        return -1;
+    }
+    if (!mkdtemp(path)) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// Decode a corpus through the cache, compare with lib_uncompress_data_with_state.
+// Returns the number of errors, p_stats the counters of the cache at the end.
+static int check_cache_corpus(uncompress_cache_t *p_cache, const uncompress_corpus_t *p_corpus, uint32_t maxBytes,
+                              uncompress_cache_stats_t *p_stats)
+{
+    uncompress_state_t state, refState;
+    uint32_t idx = 0, nbFrame = 0;
+    uint8_t *frame, len;
+    char name[CHECK_NAME_LEN];
+
+    lib_uncompress_state_init(&state);
+    lib_uncompress_state_init(&refState);
+    while (lib_uncompress_corpus_next_frame(p_corpus, &idx, &frame, &len)) {
+        uint8_t ret, refRet;
+
+        lib_uncompress_state_new_frame(&state);
+        lib_uncompress_state_new_frame(&refState);
+        refRet = lib_uncompress_data_with_state(frame, len, &refSamples, &refState);
+        ret = lib_uncompress_cache_uncompress_data_with_state(p_cache, frame, len, &samples, &state);
+        snprintf(name, sizeof(name), "cache: %s: frame %u", p_corpus->name, nbFrame);
+        if ((ret != refRet) || check_compare_samples(name, &samples, &refSamples) || check_compare_state(name, &state, &refState)) {
+            return 1;
+        }
+        lib_uncompress_cache_get_stats(p_cache, p_stats);
+        if (p_stats->fileSize > maxBytes) {
+            fprintf(stderr, "%s: file of %u bytes, max %u\n", name, p_stats->fileSize, maxBytes);
+            return 1;
+        }
+        nbFrame++;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// Put and get across a reopen of the file, compaction, truncated file
+static int check_cache(void)
+{
+    uncompress_cache_stats_t stats;
+    uncompress_cache_t *p_cache;
+    uint32_t nbEntries = 0;
+    char path[256];
+    int nbErrors = 0;
+
+    if (check_temp_path(path, sizeof(path), "cache")) {
+        return 1;
+    }
+    // every corpus decoded twice, the second time from the reopened file: only hits
+    for (uint32_t c = 0; (c < nbCorpora) && !nbErrors; c++) {
+        for (uint32_t pass = 0; (pass < 2) && !nbErrors; pass++) {
+            if (!pass && truncate(path, 0)) {
+                nbErrors++;
+                break;
+            }
+            p_cache = lib_uncompress_cache_open(path, CHECK_CACHE_MAX_BYTES);
+            if (!p_cache) {
+                fprintf(stderr, "cache: cannot open %s\n", path);
+                nbErrors++;
+                break;
+            }
+            nbErrors += check_cache_corpus(p_cache, &corpora[c], CHECK_CACHE_MAX_BYTES, &stats);
+            if ((stats.nbHits + stats.nbMisses != corpora[c].nbFrames) || stats.nbCompactions ||
+                (pass && (stats.nbMisses || (stats.nbEntries != nbEntries)))) {
+                fprintf(stderr, "cache: %s: pass %u: %u hits, %u misses, %u entries, %u compactions\n", corpora[c].name,
+                        pass, stats.nbHits, stats.nbMisses, stats.nbEntries, stats.nbCompactions);
+                nbErrors++;
+            }
+            nbEntries = stats.nbEntries;
+            lib_uncompress_cache_close(p_cache);
+        }
+    }
+
+    // a small file: the least recently used entries are evicted, the last ones survive a reopen
+    for (uint32_t c = 0; (c < nbCorpora) && !nbErrors; c++) {
+        uncompress_state_t state;
+        uint64_t keys[2] = { 0, 0 };    // of the two last frames
+        uint32_t idx = 0;
+        uint8_t *frame, len;
+
+        if (strcmp(corpora[c].name, "synth_direct")) {
+            continue;
+        }
+        if (truncate(path, 0) || !(p_cache = lib_uncompress_cache_open(path, CHECK_CACHE_SMALL_BYTES))) {
+            nbErrors++;
+            break;
+        }
+        nbErrors += check_cache_corpus(p_cache, &corpora[c], CHECK_CACHE_SMALL_BYTES, &stats);
+        if (!stats.nbCompactions) {
+            fprintf(stderr, "cache: %s: no compaction in %u bytes\n", corpora[c].name, stats.fileSize);
+            nbErrors++;
+        }
+        lib_uncompress_cache_close(p_cache);
+        lib_uncompress_state_init(&state);
+        while (lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            lib_uncompress_state_new_frame(&state);
+            keys[0] = keys[1];
+            keys[1] = lib_uncompress_cache_key(frame, len, &state);
+            lib_uncompress_data_with_state(frame, len, &refSamples, &state);
+        }
+        if (!(p_cache = lib_uncompress_cache_open(path, CHECK_CACHE_SMALL_BYTES))) {
+            nbErrors++;
+            break;
+        }
+        if (!lib_uncompress_cache_get(p_cache, keys[1], &samples, NULL) || check_compare_samples("cache: last frame after reopen", &samples, &refSamples)) {
+            fprintf(stderr, "cache: %s: last frame not found after reopen\n", corpora[c].name);
+            nbErrors++;
+        }
+        lib_uncompress_cache_get_stats(p_cache, &stats);
+        nbEntries = stats.nbEntries;
+        lib_uncompress_cache_close(p_cache);
+
+        // crash while writing the last entry: it is dropped, the previous ones are kept
+        if (truncate(path, stats.fileSize - 1) || !(p_cache = lib_uncompress_cache_open(path, CHECK_CACHE_SMALL_BYTES))) {
+            nbErrors++;
+            break;
+        }
+        lib_uncompress_cache_get_stats(p_cache, &stats);
+        if ((stats.nbEntries != nbEntries - 1) || lib_uncompress_cache_get(p_cache, keys[1], &samples, NULL) ||
+            !lib_uncompress_cache_get(p_cache, keys[0], &samples, NULL)) {
+            fprintf(stderr, "cache: %s: truncated file: %u entries instead of %u\n", corpora[c].name, stats.nbEntries, nbEntries - 1);
+            nbErrors++;
+        }
+        lib_uncompress_cache_close(p_cache);
+    }
+    unlink(path);
+    return nbErrors;
+}
+
+//****************************************************************************
+// Samples of a corpus decoded in sequence, as a session appends them. Returns the number of samples, *pp_records to free.
+static uint32_t check_decode_corpus(const uncompress_corpus_t *p_corpus, record_t **pp_records)
+{
+    uncompress_state_t state;
+    record_t *records = NULL;
+    uint32_t idx = 0, nb = 0, size = 0;
+    uint8_t *frame, len;
+
+    lib_uncompress_state_init(&state);
+    while (lib_uncompress_corpus_next_frame(p_corpus, &idx, &frame, &len)) {
+        lib_uncompress_state_new_frame(&state);
+        if (!lib_uncompress_data_with_state(frame, len, &samples, &state)) {
+            continue;
+        }
+        if (nb + samples.nbSamples > size) {
+            record_t *p;
+            size = (size ? size * 2 : 65536) + samples.nbSamples;
+            p = realloc(records, size * sizeof(record_t));
+            if (!p) {
+                free(records);
+                *pp_records = NULL;
+                return 0;
+            }
+            records = p;
+        }
+        memcpy(&records[nb], samples.samples, samples.nbSamples * sizeof(record_t));
+        nb += samples.nbSamples;
+    }
+    *pp_records = records;
+    return nb;
+}
+
+//****************************************************************************
+static int check_session_read(const char *name, uncompress_session_t *p_session, const record_t *ref, uint32_t nbRef,
+                              uint32_t first, uint32_t nb, record_t *output)
+{
+    uint32_t expected = (first >= nbRef) ? 0 : (nb > nbRef - first) ? nbRef - first : nb;
+    uint32_t nbRead = lib_uncompress_session_get_samples(p_session, first, nb, output);
+
+    if (nbRead != expected) {
+        fprintf(stderr, "%s: %u samples read from %u instead of %u\n", name, nbRead, first, expected);
+        return 1;
+    }
+    for (uint32_t i = 0; i < expected; i++) {
+        // not memcmp, the padding of record_t is not set
+        if ((output[i].time != ref[first + i].time) || (output[i].tempe != ref[first + i].tempe)) {
+            fprintf(stderr, "%s: sample %u: %u;%d instead of %u;%d\n", name, first + i, output[i].time, output[i].tempe,
+                    ref[first + i].time, ref[first + i].tempe);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+// Random access, forward and backward reads give the samples of the sequential decoding
+static int check_session(void)
+{
+    record_t *output = malloc(CHECK_SESSION_MAX_READ * sizeof(record_t));
+    int nbErrors = 0;
+
+    if (!output) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        uncompress_session_t *p_session = lib_uncompress_session_create(CHECK_SESSION_NB_CACHED);
+        uncompress_session_stats_t stats;
+        uint32_t idx = 0, nbRef, seed = 0x13579bdf;
+        uint8_t *frame, len;
+        record_t *ref;
+        char name[CHECK_NAME_LEN];
+        int nb = 0;
+
+        snprintf(name, sizeof(name), "session: %s", corpora[c].name);
+        nbRef = check_decode_corpus(&corpora[c], &ref);
+        if (!p_session || !ref) {
+            fprintf(stderr, "out of memory\n");
+            lib_uncompress_session_free(p_session);
+            free(ref);
+            nbErrors++;
+            break;
+        }
+        while (lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            lib_uncompress_session_append(p_session, frame, len);
+        }
+        if (lib_uncompress_session_get_nb_samples(p_session) != nbRef) {
+            fprintf(stderr, "%s: %u samples instead of %u\n", name, lib_uncompress_session_get_nb_samples(p_session), nbRef);
+            nb++;
+        }
+        for (uint32_t first = 0; !nb && (first < nbRef); first += CHECK_SESSION_MAX_READ) {
+            nb += check_session_read(name, p_session, ref, nbRef, first, CHECK_SESSION_MAX_READ, output);
+        }
+        for (uint32_t end = nbRef; !nb && (end > 0); end = (end > CHECK_SESSION_MAX_READ / 3) ? end - CHECK_SESSION_MAX_READ / 3 : 0) {
+            uint32_t first = (end > CHECK_SESSION_MAX_READ / 3) ? end - CHECK_SESSION_MAX_READ / 3 : 0;
+            nb += check_session_read(name, p_session, ref, nbRef, first, end - first, output);
+        }
+        for (uint32_t k = 0; !nb && (k < CHECK_SESSION_NB_RANDOM); k++) {
+            uint32_t first = lib_uncompress_corpus_random(&seed) % (nbRef + 2);
+            uint32_t nbRead = 1 + lib_uncompress_corpus_random(&seed) % CHECK_SESSION_MAX_READ;
+            nb += check_session_read(name, p_session, ref, nbRef, first, nbRead, output);
+        }
+        // chronological slots only: the first valid time at or after the time of a random sample
+        for (uint32_t k = 0; !nb && corpora[c].isSlot && (k < CHECK_SESSION_NB_RANDOM); k++) {
+            uint32_t time = ref[lib_uncompress_corpus_random(&seed) % nbRef].time + k % 3 - 1;
+            uint32_t expected = UNCOMPRESS_SESSION_NOT_FOUND;
+            for (uint32_t i = 0; i < nbRef; i++) {
+                if ((ref[i].time != UNCOMPRESS_INVALID_TIME) && (ref[i].time >= time)) {
+                    expected = i;
+                    break;
+                }
+            }
+            if (lib_uncompress_session_find_time(p_session, time) != expected) {
+                fprintf(stderr, "%s: time %u found at %u instead of %u\n", name, time,
+                        lib_uncompress_session_find_time(p_session, time), expected);
+                nb++;
+            }
+        }
+        lib_uncompress_session_get_stats(p_session, &stats);
+        if (!nb && (stats.nbSamples != nbRef)) {
+            fprintf(stderr, "%s: stats give %u samples instead of %u\n", name, stats.nbSamples, nbRef);
+            nb++;
+        }
+        nbErrors += nb;
+        lib_uncompress_session_free(p_session);
+        free(ref);
+    }
+    free(output);
+    return nbErrors;
+}
+
+//****************************************************************************
+// A known state gives a known blob, in little endian whatever the platform
+static int check_state_blob(void)
+{
+    const uncompress_state_t state = { CHECK_TIME, 300, 2, CHECK_TEMPE + 12 };
+    const uint8_t expected[UNCOMPRESS_STATE_BLOB_SIZE] = {
+        UNCOMPRESS_STATE_BLOB_MAGIC, UNCOMPRESS_STATE_BLOB_VERSION, 0x14, 0x10, 0x5e, 0x5f, 0x2c, 0x01, 0x02, 0x00, 0x80, 0x0e, 0x19
+    };
+    uint8_t blob[UNCOMPRESS_STATE_BLOB_SIZE];
+
+    if ((lib_uncompress_state_save(&state, blob, sizeof(blob)) != UNCOMPRESS_STATE_BLOB_SIZE) || memcmp(blob, expected, sizeof(blob))) {
+        fprintf(stderr, "state: the blob of a known state differs\n");
+        return 1;
+    }
+    if (lib_uncompress_state_save(&state, blob, sizeof(blob) - 1)) {
+        fprintf(stderr, "state: blob saved in a too small buffer\n");
+        return 1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// A blob with a bit flipped, or truncated, is rejected and the state is unchanged
+static int check_state_corrupted(const uint8_t *blob)
+{
+    uncompress_state_t state = { 1, 2, 3, 4 };
+    const uncompress_state_t unchanged = state;
+    uint8_t corrupted[UNCOMPRESS_STATE_BLOB_SIZE];
+
+    for (uint32_t bit = 0; bit < UNCOMPRESS_STATE_BLOB_SIZE * 8; bit++) {
+        memcpy(corrupted, blob, sizeof(corrupted));
+        corrupted[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        if (lib_uncompress_state_restore(&state, corrupted, sizeof(corrupted)) || check_compare_state("state: corrupted blob", &state, &unchanged)) {
+            fprintf(stderr, "state: blob with bit %u flipped accepted\n", bit);
+            return 1;
+        }
+    }
+    if (lib_uncompress_state_restore(&state, blob, UNCOMPRESS_STATE_BLOB_SIZE - 1) || check_compare_state("state: truncated blob", &state, &unchanged)) {
+        fprintf(stderr, "state: truncated blob accepted\n");
+        return 1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// The state before each frame of every corpus is saved and restored: same state, and the frame
+// decoded from the restored state gives the same samples
+static int check_state(void)
+{
+    int nbErrors = check_state_blob();
+
+    for (uint32_t c = 0; (c < nbCorpora) && !nbErrors; c++) {
+        uncompress_state_t state, restored;
+        uint32_t idx = 0, nbFrame = 0;
+        uint8_t *frame, len;
+        char name[CHECK_NAME_LEN];
+
+        lib_uncompress_state_init(&state);
+        while (!nbErrors && lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            uint8_t blob[UNCOMPRESS_STATE_BLOB_SIZE];
+
+            snprintf(name, sizeof(name), "state: %s: frame %u", corpora[c].name, nbFrame++);
+            lib_uncompress_state_new_frame(&state);
+            memset(&restored, 0, sizeof(restored));
+            if (!lib_uncompress_state_save(&state, blob, sizeof(blob)) || !lib_uncompress_state_restore(&restored, blob, sizeof(blob))) {
+                fprintf(stderr, "%s: cannot save and restore the state\n", name);
+                nbErrors++;
+                break;
+            }
+            nbErrors += check_compare_state(name, &restored, &state);
+            if ((nbFrame % CHECK_STATE_CORRUPT_EVERY) == 1) {
+                nbErrors += check_state_corrupted(blob);
+            }
+            lib_uncompress_data_with_state(frame, len, &refSamples, &state);
+            lib_uncompress_data_with_state(frame, len, &samples, &restored);
+            nbErrors += check_compare_samples(name, &samples, &refSamples) || check_compare_state(name, &restored, &state);
+        }
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// A corpus without corrupted frame: same samples and state as lib_uncompress_data_with_state, nothing skipped
+static int check_resync_corpus(const uncompress_corpus_t *p_corpus, const uncompress_resync_config_t *p_config)
+{
+    uncompress_state_t state, refState;
+    uncompress_resync_report_t report;
+    uint32_t idx = 0, nbFrame = 0;
+    uint8_t *frame, len;
+    char name[CHECK_NAME_LEN];
+
+    lib_uncompress_state_init(&state);
+    lib_uncompress_state_init(&refState);
+    while (lib_uncompress_corpus_next_frame(p_corpus, &idx, &frame, &len)) {
+        snprintf(name, sizeof(name), "resync: %s: frame %u", p_corpus->name, nbFrame++);
+        lib_uncompress_state_new_frame(&state);
+        lib_uncompress_state_new_frame(&refState);
+        if (lib_uncompress_data_resync(frame, len, &samples, &state, p_config, &report) !=
+            lib_uncompress_data_with_state(frame, len, &refSamples, &refState)) {
+            fprintf(stderr, "%s: not the same return value\n", name);
+            return 1;
+        }
+        if (report.nbResyncs || report.nbRanges || report.nbSkippedBits || report.nbDroppedSamples) {
+            fprintf(stderr, "%s: %u resyncs, %u bits skipped in a sound frame\n", name, report.nbResyncs, report.nbSkippedBits);
+            return 1;
+        }
+        if (check_compare_samples(name, &samples, &refSamples) || check_compare_state(name, &state, &refState)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+static int check_resync_frame(const def_check_resync_frame_t *p_frame)
+{
+    uncompress_state_t state;
+    uncompress_resync_report_t report;
+    uint8_t frame[UINT8_MAX];
+    uint8_t len = lib_uncompress_corpus_frame(frame, p_frame->codes, p_frame->nbCodes);
+
+    lib_uncompress_state_init(&state);
+    if (!len || !lib_uncompress_data_resync(frame, len, &samples, &state, NULL, &report)) {
+        fprintf(stderr, "resync: %s: no sample recovered\n", p_frame->name);
+        return 1;
+    }
+    if ((report.nbResyncs != 1) || (report.nbRanges != 1) || (report.ranges[0].firstBit != p_frame->firstBit) ||
+        (report.ranges[0].nbBits != p_frame->nbBits) || (report.nbSkippedBits != p_frame->nbBits) ||
+        (report.nbDroppedSamples != p_frame->nbDropped)) {
+        fprintf(stderr, "resync: %s: %u resyncs, %u ranges, first %u+%u, %u dropped instead of 1, 1, %u+%u, %u\n", p_frame->name,
+                report.nbResyncs, report.nbRanges, report.ranges[0].firstBit, report.ranges[0].nbBits, report.nbDroppedSamples,
+                p_frame->firstBit, p_frame->nbBits, p_frame->nbDropped);
+        return 1;
+    }
+    if (samples.nbSamples != p_frame->nbSamples) {
+        fprintf(stderr, "resync: %s: %u samples instead of %u\n", p_frame->name, samples.nbSamples, p_frame->nbSamples);
+        return 1;
+    }
+    for (uint32_t k = 0; k < p_frame->nbRecovered; k++) {
+        const record_t *p_record = &samples.samples[p_frame->nbSamples - p_frame->nbRecovered + k];
+        if ((p_record->time != p_frame->anchorTime + k * CHECK_RESYNC_PERIOD) || (p_record->tempe != p_frame->anchorTempe)) {
+            fprintf(stderr, "resync: %s: recovered sample %u: %u;%d instead of %u;%d\n", p_frame->name, k, p_record->time,
+                    p_record->tempe, p_frame->anchorTime + k * CHECK_RESYNC_PERIOD, p_frame->anchorTempe);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+// The sound corpora decode as without resync: the slots with the default limits, the synthetic corpora,
+// which use the whole range of the format, with no limit (synth_random is corrupted on purpose).
+// Then the handmade corrupted frames give the expected skipped range and samples.
+static int check_resync(void)
+{
+    const uncompress_resync_config_t noLimit = { 0, UINT32_MAX - 1, UINT32_MAX, INT16_MIN, INT16_MAX };
+    int nbErrors = 0;
+
+    for (uint32_t c = 0; c < nbCorpora; c++) {
+        if (strcmp(corpora[c].name, "synth_random")) {
+            nbErrors += check_resync_corpus(&corpora[c], corpora[c].isSlot ? NULL : &noLimit);
+        }
+    }
+    for (uint32_t f = 0; f < sizeof(resyncFrames) / sizeof(resyncFrames[0]); f++) {
+        nbErrors += check_resync_frame(&resyncFrames[f]);
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Field by field, the padding of record_t is not set
+static int check_compare_records(const char *name, const record_t *records, const record_t *ref, uint32_t nb)
+{
+    for (uint32_t i = 0; i < nb; i++) {
+        if ((records[i].time != ref[i].time) || (records[i].tempe != ref[i].tempe)) {
+            fprintf(stderr, "%s: record %u: %u;%d instead of %u;%d\n", name, i, records[i].time, records[i].tempe,
+                    ref[i].time, ref[i].tempe);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+// An archive with a bit flipped, or truncated, is rejected
+static int check_archive_damaged(const char *name, const uint8_t *archive, uint32_t len, uint32_t nbRecords, record_t *records)
+{
+    uint32_t nbBits = len * 8;
+    uint32_t step = (nbBits > CHECK_ARCHIVE_NB_DAMAGES) ? nbBits / CHECK_ARCHIVE_NB_DAMAGES : 1;
+    uint8_t *damaged = malloc(len);
+
+    if (!damaged) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        return 1;
+    }
+    memcpy(damaged, archive, len);
+    for (uint32_t bit = 0; bit < nbBits; bit += step) {
+        damaged[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        if (lib_uncompress_archive_decode(damaged, len, records, nbRecords)) {
+            fprintf(stderr, "%s: archive with bit %u flipped accepted\n", name, bit);
+            free(damaged);
+            return 1;
+        }
+        damaged[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    }
+    free(damaged);
+    step = (len > CHECK_ARCHIVE_NB_DAMAGES) ? len / CHECK_ARCHIVE_NB_DAMAGES : 1;
+    for (uint32_t cut = 0; cut < len; cut += step) {
+        if (lib_uncompress_archive_decode(archive, cut, records, nbRecords)) {
+            fprintf(stderr, "%s: archive truncated to %u bytes of %u accepted\n", name, cut, len);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+// The samples of every corpus, archived then unarchived, are the same records; damaged archives are rejected
+static int check_archive(void)
+{
+    int nbErrors = 0;
+
+    for (uint32_t c = 0; (c < nbCorpora) && !nbErrors; c++) {
+        record_t *ref, *records;
+        uint8_t *archive;
+        uint32_t nbRef = check_decode_corpus(&corpora[c], &ref);
+        uint32_t size = lib_uncompress_archive_max_size(nbRef);
+        uint32_t len, nbRecords = 0;
+        char name[CHECK_NAME_LEN];
+
+        snprintf(name, sizeof(name), "archive: %s", corpora[c].name);
+        archive = malloc(size);
+        records = malloc((nbRef ? nbRef : 1) * sizeof(record_t));
+        if (!ref || !archive || !records) {
+            fprintf(stderr, "%s: out of memory\n", name);
+            nbErrors++;
+        } else if (!(len = lib_uncompress_archive_encode(ref, nbRef, archive, size))) {
+            fprintf(stderr, "%s: %u records not archived\n", name, nbRef);
+            nbErrors++;
+        } else if (!lib_uncompress_archive_get_nb_records(archive, len, &nbRecords) || (nbRecords != nbRef) ||
+                   !lib_uncompress_archive_decode(archive, len, records, nbRecords)) {
+            fprintf(stderr, "%s: archive of %u records not decoded\n", name, nbRef);
+            nbErrors++;
+        } else if (nbRecords && lib_uncompress_archive_decode(archive, len, records, nbRecords - 1)) {
+            fprintf(stderr, "%s: archive decoded in %u records\n", name, nbRecords - 1);
+            nbErrors++;
+        } else {
+            nbErrors += check_compare_records(name, records, ref, nbRef);
+            // the archive of the first records only, a damaged archive is decoded up to the damage
+            nbRecords = (nbRef < CHECK_ARCHIVE_DAMAGED_RECORDS) ? nbRef : CHECK_ARCHIVE_DAMAGED_RECORDS;
+            len = lib_uncompress_archive_encode(ref, nbRecords, archive, size);
+            nbErrors += check_archive_damaged(name, archive, len, nbRecords, records);
+        }
+        free(ref);
+        free(archive);
+        free(records);
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Plain reference of lib_uncompress_stats_compute, sample by sample
+static void check_ref_stats(const record_t *records, uint32_t nb, uncompress_stats_t *p_stats, uint32_t *mask)
+{
+    memset(p_stats, 0, sizeof(uncompress_stats_t));
+    memset(mask, 0, UNCOMPRESS_STATS_MASK_WORDS(nb) * sizeof(uint32_t));
+    p_stats->nbSamples = nb;
+    p_stats->minTempe = INVALID_TEMPERATURE;
+    p_stats->maxTempe = INVALID_TEMPERATURE;
+    p_stats->firstTime = UINT32_MAX;
+    for (uint32_t i = 0; i < nb; i++) {
+        uint32_t time = records[i].time;
+        int16_t tempe = records[i].tempe;
+
+        if (time == UNCOMPRESS_INVALID_TIME) {
+            p_stats->nbInvalidTime++;
+        } else {
+            if (time < p_stats->firstTime) {
+                p_stats->firstTime = time;
+            }
+            if (time > p_stats->lastTime) {
+                p_stats->lastTime = time;
+            }
+        }
+        if (tempe == INVALID_TEMPERATURE) {
+            p_stats->nbInvalidTempe++;
+        } else if (tempe == UNCOMPRESS_UNRECEIVED_TEMPERATURE) {
+            if (time == UNCOMPRESS_INVALID_TIME) {
+                p_stats->nbUnreceived++;
+            }
+        } else {
+            if (!p_stats->nbValidTempe || (tempe < p_stats->minTempe)) {
+                p_stats->minTempe = tempe;
+            }
+            if (!p_stats->nbValidTempe || (tempe > p_stats->maxTempe)) {
+                p_stats->maxTempe = tempe;
+            }
+            p_stats->nbValidTempe++;
+            p_stats->sumTempe += tempe;
+            p_stats->sumSqTempe += (uint64_t)((int64_t)tempe * tempe);
+            if (time != UNCOMPRESS_INVALID_TIME) {
+                mask[i / 32] |= 1U << (i % 32);
+            }
+        }
+    }
+    if (p_stats->nbValidTempe) {
+        double mean = (double)p_stats->sumTempe / p_stats->nbValidTempe;
+        double variance = (double)p_stats->sumSqTempe / p_stats->nbValidTempe - mean * mean;
+        p_stats->meanTempe = (float)mean;
+        p_stats->varianceTempe = (float)((variance > 0) ? variance : 0);
+    }
+    if (p_stats->firstTime < p_stats->lastTime) {
+        p_stats->timeSpan = p_stats->lastTime - p_stats->firstTime;
+    }
+}
+
+//****************************************************************************
+// lib_uncompress_stats_compute, or lib_uncompress_stats_compute_samples when p_samples is set, against the
+// reference. The mask is compared word by word, with the word after it which must not be written.
+static int check_stats_records(const char *name, const record_t *records, uint32_t nb, const samples_t *p_samples)
+{
+    uint32_t nbWords = UNCOMPRESS_STATS_MASK_WORDS(nb);
+    uint32_t *mask = malloc((nbWords + 1) * sizeof(uint32_t));
+    uint32_t *refMask = malloc((nbWords + 1) * sizeof(uint32_t));
+    uncompress_stats_t stats, ref;
+    int nbErrors = 0;
+
+    if (!mask || !refMask) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        free(mask);
+        free(refMask);
+        return 1;
+    }
+    for (uint32_t w = 0; w <= nbWords; w++) {
+        mask[w] = CHECK_STATS_MASK_FILL;
+    }
+    refMask[nbWords] = CHECK_STATS_MASK_FILL;
+    check_ref_stats(records, nb, &ref, refMask);
+    if (p_samples) {
+        lib_uncompress_stats_compute_samples(p_samples, &stats, mask);
+    } else {
+        lib_uncompress_stats_compute(records, nb, &stats, mask);
+    }
+    if ((stats.nbSamples != ref.nbSamples) || (stats.nbValidTempe != ref.nbValidTempe) ||
+        (stats.nbInvalidTempe != ref.nbInvalidTempe) || (stats.nbUnreceived != ref.nbUnreceived) ||
+        (stats.nbInvalidTime != ref.nbInvalidTime) || (stats.minTempe != ref.minTempe) || (stats.maxTempe != ref.maxTempe) ||
+        (stats.sumTempe != ref.sumTempe) || (stats.sumSqTempe != ref.sumSqTempe) || (stats.meanTempe != ref.meanTempe) ||
+        (stats.varianceTempe != ref.varianceTempe) || (stats.firstTime != ref.firstTime) || (stats.lastTime != ref.lastTime) ||
+        (stats.timeSpan != ref.timeSpan)) {
+        fprintf(stderr, "%s: %u samples: %u valid, %u invalid, %u unreceived, %u invalid times, %d..%d, sum %lld, %u..%u\n"
+                "  instead of %u valid, %u invalid, %u unreceived, %u invalid times, %d..%d, sum %lld, %u..%u\n",
+                name, nb, stats.nbValidTempe, stats.nbInvalidTempe, stats.nbUnreceived, stats.nbInvalidTime, stats.minTempe,
+                stats.maxTempe, (long long)stats.sumTempe, stats.firstTime, stats.lastTime, ref.nbValidTempe, ref.nbInvalidTempe,
+                ref.nbUnreceived, ref.nbInvalidTime, ref.minTempe, ref.maxTempe, (long long)ref.sumTempe, ref.firstTime, ref.lastTime);
+        nbErrors++;
+    }
+    for (uint32_t w = 0; w <= nbWords; w++) {
+        if (mask[w] != refMask[w]) {
+            fprintf(stderr, "%s: %u samples: mask word %u is %08x instead of %08x\n", name, nb, w, mask[w], refMask[w]);
+            nbErrors++;
+            break;
+        }
+    }
+    free(mask);
+    free(refMask);
+    return nbErrors;
+}
+
+//****************************************************************************
+// Random records, level 0 to 4: the higher, the more invalid times and sentinel temperatures (all at 4)
+static void check_stats_random(record_t *records, uint32_t nb, uint32_t level, uint32_t *p_seed)
+{
+    static const int16_t tempes[] = { INVALID_TEMPERATURE, UNCOMPRESS_UNRECEIVED_TEMPERATURE, INT16_MIN, INVALID_TEMPERATURE - 1 };
+
+    for (uint32_t i = 0; i < nb; i++) {
+        uint32_t r = lib_uncompress_corpus_random(p_seed);
+
+        records[i].time = ((r & 3) < level) ? UNCOMPRESS_INVALID_TIME : lib_uncompress_corpus_random(p_seed) >> 1;
+        if (((r >> 2) & 3) < level) {
+            records[i].tempe = ((r >> 4) & 1) ? UNCOMPRESS_UNRECEIVED_TEMPERATURE : INVALID_TEMPERATURE;
+        } else if (((r >> 5) & 7) == 0) {
+            records[i].tempe = tempes[(r >> 8) & 3];    // extreme values and sentinels with a valid time
+        } else {
+            records[i].tempe = (int16_t)(r >> 16);
+        }
+    }
+}
+
+//****************************************************************************
+// The statistics of every corpus, as a whole, from a sample which is not the first of a block, and frame by
+// frame through samples_t, then of random series of every length, are the ones of the plain reference
+static int check_stats(void)
+{
+    static const uint32_t lengths[] = { 0, 1, 31, 33, 63, 65, 95, 100, 1001 };
+    record_t *records = malloc(CHECK_STATS_MAX_RANDOM * sizeof(record_t));
+    uint32_t seed = 0x5EED;
+    int nbErrors = 0;
+
+    for (uint32_t c = 0; (c < nbCorpora) && !nbErrors; c++) {
+        record_t *decoded;
+        uint32_t nb = check_decode_corpus(&corpora[c], &decoded);
+        uint32_t idx = 0;
+        uint8_t *frame, len;
+        uncompress_state_t state;
+        char name[CHECK_NAME_LEN];
+
+        if (!decoded) {
+            fprintf(stderr, "stats: %s: out of memory\n", corpora[c].name);
+            nbErrors++;
+            break;
+        }
+        snprintf(name, sizeof(name), "stats: %s", corpora[c].name);
+        nbErrors += check_stats_records(name, decoded, nb, NULL);
+        if (nb > 2 * CHECK_STATS_OFFSET) {
+            nbErrors += check_stats_records(name, &decoded[CHECK_STATS_OFFSET], nb - 2 * CHECK_STATS_OFFSET, NULL);
+        }
+        free(decoded);
+        lib_uncompress_state_init(&state);
+        while (!nbErrors && lib_uncompress_corpus_next_frame(&corpora[c], &idx, &frame, &len)) {
+            lib_uncompress_state_new_frame(&state);
+            if (lib_uncompress_data_with_state(frame, len, &samples, &state)) {
+                nbErrors += check_stats_records(name, samples.samples, samples.nbSamples, &samples);
+            }
+        }
+    }
+
+    if (!records) {
+        fprintf(stderr, "stats: out of memory\n");
+        return nbErrors + 1;
+    }
+    for (uint32_t k = 0; (k < CHECK_STATS_NB_RANDOM) && !nbErrors; k++) {
+        // the given lengths, then odd lengths: never a whole number of blocks
+        uint32_t nb = (k < sizeof(lengths) / sizeof(lengths[0])) ? lengths[k] :
+                      ((lib_uncompress_corpus_random(&seed) % CHECK_STATS_MAX_RANDOM) | 1);
+        char name[CHECK_NAME_LEN];
+
+        snprintf(name, sizeof(name), "stats: random series %u, level %u", k, k % 5);
+        check_stats_random(records, nb, k % 5, &seed);
+        nbErrors += check_stats_records(name, records, nb, NULL);
+    }
+    free(records);
+    return nbErrors;
+}
+
+//****************************************************************************
+// Append records to a growing array. Returns 0 on success, -1 out of memory.
+static int check_ingest_append(record_t **pp_records, uint32_t *p_nb, uint32_t *p_size, const record_t *records, uint32_t nb)
+{
+    if (*p_nb + nb > *p_size) {
+        uint32_t size = (*p_size ? *p_size * 2 : 4096) + nb;
+        record_t *p = realloc(*pp_records, size * sizeof(record_t));
+        if (!p) {
+            return -1;
+        }
+        *pp_records = p;
+        *p_size = size;
+    }
+    memcpy(&(*pp_records)[*p_nb], records, nb * sizeof(record_t));
+    *p_nb += nb;
+    return 0;
+}
+
+//****************************************************************************
+static int check_ingest_compare_events(const void *a, const void *b)
+{
+    const def_check_ingest_event_t *p_a = a, *p_b = b;
+
+    return (p_a->key > p_b->key) - (p_a->key < p_b->key);
+}
+
+//****************************************************************************
+/**
+ * The first frames of a corpus, as received from a device by several radios: each frame is sent at most
+ * CHECK_INGEST_SHUFFLE frames from its place, some twice. p_device->ref is what the ingest engine must give:
+ * the frames sent decoded in sequence, from a new state after a restart. Returns the number of errors.
+ */
+static int check_ingest_device(def_check_ingest_device_t *p_device, uint16_t idx, const uncompress_corpus_t *p_corpus,
+                               def_check_ingest_role_t role, uint32_t *p_seed)
+{
+    uint32_t nb = (p_corpus->nbFrames < CHECK_INGEST_MAX_FRAMES) ? p_corpus->nbFrames : CHECK_INGEST_MAX_FRAMES;
+    uint32_t restartAt = (role == CHECK_INGEST_RESTART) ? nb / 3 : nb;
+    uint32_t base = (role == CHECK_INGEST_WRAP) ? UINT32_MAX - nb / 2
+                                                : 1000 + lib_uncompress_corpus_random(p_seed) % 1000000;
+    uint32_t offset = 0;
+    uncompress_state_t state;
+    uint8_t *frame, len;
+
+    memset(p_device, 0, sizeof(def_check_ingest_device_t));
+    p_device->id = 1000 + idx;
+    p_device->role = role;
+    p_device->events = malloc(2 * nb * sizeof(def_check_ingest_event_t));
+    if (!p_device->events) {
+        fprintf(stderr, "ingest: out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; (i < nb) && lib_uncompress_corpus_next_frame(p_corpus, &offset, &frame, &len); i++) {
+        uint32_t stream = (i < restartAt) ? 0 : 1;
+        uint32_t nbCopies = (lib_uncompress_corpus_random(p_seed) % CHECK_INGEST_DUPLICATE_EVERY) ? 1 : 2;
+
+        // single frames and a run longer than the window, not at the ends: they would never be known
+        if ((role == CHECK_INGEST_DROP) && (i >= 2 * CHECK_INGEST_SHUFFLE) && (i + 2 * CHECK_INGEST_SHUFFLE < nb)
+            && (!(i % CHECK_INGEST_DROP_EVERY) || (i - nb / 2 < CHECK_INGEST_WINDOW + 5))) {
+            p_device->nbLost++;
+            continue;
+        }
+        if ((i == 0) || (i == restartAt)) {
+            lib_uncompress_state_init(&state);
+        }
+        lib_uncompress_state_new_frame(&state);
+        if (lib_uncompress_data_with_state(frame, len, &samples, &state)
+            && check_ingest_append(&p_device->ref, &p_device->nbRef, &p_device->refSize, samples.samples, samples.nbSamples)) {
+            fprintf(stderr, "ingest: out of memory\n");
+            return 1;
+        }
+        for (uint32_t c = 0; c < nbCopies; c++) {
+            def_check_ingest_event_t *p_event = &p_device->events[p_device->nbEvents];
+            // the frames of the second stream come after the ones of the first
+            uint32_t place = i + stream * CHECK_INGEST_SHUFFLE + lib_uncompress_corpus_random(p_seed) % CHECK_INGEST_SHUFFLE;
+            p_event->key = ((uint64_t)place << 32) | p_device->nbEvents;
+            p_event->deviceId = p_device->id;
+            p_event->seq = stream ? i - restartAt : base + i;
+            p_event->frame = frame;
+            p_event->len = len;
+            p_event->device = idx;
+            p_device->nbEvents++;
+            if (!stream) {
+                p_device->restartAt = p_device->nbEvents;
+            }
+        }
+        p_device->nbDuplicates += nbCopies - 1;
+        p_device->nbFrames++;
+    }
+    qsort(p_device->events, p_device->nbEvents, sizeof(def_check_ingest_event_t), check_ingest_compare_events);
+    return 0;
+}
+
+//****************************************************************************
+/**
+ * Interleave the frames of the devices, one frame of each device in turn. A restarted device sends nothing
+ * during CHECK_INGEST_PAUSE frames of the others, more than the producers move frames: the two streams are
+ * not mixed. Returns the number of errors.
+ */
+static int check_ingest_merge(def_check_ingest_t *p_check)
+{
+    uint32_t next[UNCOMPRESS_CORPUS_MAX] = { 0 };
+    uint32_t resumeAt[UNCOMPRESS_CORPUS_MAX] = { 0 };
+    uint32_t nbTotal = 0;
+    uint8_t left = 1;
+
+    for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+        nbTotal += p_check->devices[d].nbEvents;
+    }
+    p_check->events = malloc(nbTotal * sizeof(def_check_ingest_event_t));
+    if (!p_check->events) {
+        fprintf(stderr, "ingest: out of memory\n");
+        return 1;
+    }
+    while (left) {
+        uint32_t nbSent = 0;
+        left = 0;
+        for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+            def_check_ingest_device_t *p_device = &p_check->devices[d];
+            if (next[d] == p_device->nbEvents) {
+                continue;
+            }
+            left = 1;
+            if ((p_device->role == CHECK_INGEST_RESTART) && (next[d] == p_device->restartAt) && !resumeAt[d]) {
+                resumeAt[d] = p_check->nbEvents + CHECK_INGEST_PAUSE;
+            }
+            if (p_check->nbEvents < resumeAt[d]) {
+                continue;
+            }
+            p_check->events[p_check->nbEvents++] = p_device->events[next[d]++];
+            nbSent++;
+        }
+        if (left && !nbSent) {
+            // only paused devices are left
+            for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+                if (resumeAt[d] > p_check->nbEvents) {
+                    resumeAt[d] = p_check->nbEvents;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+static void check_ingest_sink(void *p_user, uint32_t deviceId, void **pp_session, const record_t *records, uint32_t nbRecords)
+{
+    def_check_ingest_t *p_check = p_user;
+    def_check_ingest_device_t *p_device = *pp_session;
+
+    if (!p_device) {
+        for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+            if (p_check->devices[d].id == deviceId) {
+                p_device = &p_check->devices[d];
+            }
+        }
+        if (!p_device) {
+            fprintf(stderr, "ingest: records of unknown device %u\n", deviceId);
+            return;
+        }
+        *pp_session = p_device;
+    }
+    if (!records) {
+        p_device->nbClosed++;
+    } else if (check_ingest_append(&p_device->records, &p_device->nbRecords, &p_device->size, records, nbRecords)) {
+        p_device->error = 1;
+    }
+}
+
+//****************************************************************************
+// Producer p pushes the events p, p+CHECK_INGEST_NB_PRODUCERS... at most CHECK_INGEST_SKEW events ahead of the others
+static void *check_ingest_producer(void *arg)
+{
+    def_check_ingest_producer_t *p_producer = arg;
+    const def_check_ingest_t *p_check = p_producer->p_check;
+
+    for (uint32_t e = p_producer->id; e < p_check->nbEvents; e += CHECK_INGEST_NB_PRODUCERS) {
+        const def_check_ingest_event_t *p_event = &p_check->events[e];
+        __atomic_store_n(&p_producer->progress[p_producer->id], e, __ATOMIC_RELEASE);
+        for (uint32_t p = 0; p < CHECK_INGEST_NB_PRODUCERS; p++) {
+            while (__atomic_load_n(&p_producer->progress[p], __ATOMIC_ACQUIRE) + CHECK_INGEST_SKEW < e) {
+                sched_yield();
+            }
+        }
+        while (!lib_uncompress_ingest_push(p_producer->p_ingest, p_event->deviceId, p_event->seq, p_event->frame, p_event->len)) {
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&p_producer->progress[p_producer->id], UINT32_MAX - CHECK_INGEST_SKEW, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+//****************************************************************************
+// The records given to the sink for a device are the expected ones, and the sink was closed once
+static int check_ingest_compare_device(const char *name, def_check_ingest_device_t *p_device)
+{
+    if (p_device->error) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        return 1;
+    }
+    if (p_device->nbClosed != 1) {
+        fprintf(stderr, "%s: sink closed %u times\n", name, p_device->nbClosed);
+        return 1;
+    }
+    if (p_device->nbRecords != p_device->nbRef) {
+        fprintf(stderr, "%s: %u records instead of %u\n", name, p_device->nbRecords, p_device->nbRef);
+        return 1;
+    }
+    return check_compare_records(name, p_device->records, p_device->ref, p_device->nbRef);
+}
+
+//****************************************************************************
+// The events pushed by several threads through small queues: each device gets its records, the counters are exact
+static int check_ingest_run(def_check_ingest_t *p_check)
+{
+    def_check_ingest_producer_t producers[CHECK_INGEST_NB_PRODUCERS];
+    uint32_t progress[CHECK_INGEST_NB_PRODUCERS] = { 0 };
+    uncompress_ingest_stats_t stats, ref;
+    uncompress_ingest_config_t config;
+    uncompress_ingest_t *p_ingest;
+    int nbErrors = 0;
+
+    lib_uncompress_ingest_config_default(&config);
+    config.nbWorkers = 3;
+    config.queueSize = 64;                      // producers often find a full queue
+    config.reorderWindow = CHECK_INGEST_WINDOW;
+    config.reorderTimeoutMs = 10 * CHECK_INGEST_WAIT_MS;    // frames are only given up when the window is full
+    config.batchSize = 1000;
+    config.sink = check_ingest_sink;
+    config.p_user = p_check;
+    p_ingest = lib_uncompress_ingest_start(&config);
+    if (!p_ingest) {
+        fprintf(stderr, "ingest: cannot start the engine\n");
+        return 1;
+    }
+    for (uint32_t p = 0; p < CHECK_INGEST_NB_PRODUCERS; p++) {
+        producers[p].p_ingest = p_ingest;
+        producers[p].p_check = p_check;
+        producers[p].id = p;
+        producers[p].progress = progress;
+        pthread_create(&producers[p].thread, NULL, check_ingest_producer, &producers[p]);
+    }
+    for (uint32_t p = 0; p < CHECK_INGEST_NB_PRODUCERS; p++) {
+        pthread_join(producers[p].thread, NULL);
+    }
+    lib_uncompress_ingest_stop(p_ingest, &stats);
+
+    memset(&ref, 0, sizeof(ref));
+    for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+        def_check_ingest_device_t *p_device = &p_check->devices[d];
+        char name[CHECK_NAME_LEN];
+
+        snprintf(name, sizeof(name), "ingest: device %u", p_device->id);
+        nbErrors += check_ingest_compare_device(name, p_device);
+        ref.nbFrames += p_device->nbFrames;
+        ref.nbSamples += p_device->nbRef;
+        ref.nbDuplicates += p_device->nbDuplicates;
+        ref.nbLost += p_device->nbLost;
+        ref.nbRestarts += (p_device->role == CHECK_INGEST_RESTART);
+    }
+    if ((stats.nbFrames != ref.nbFrames) || (stats.nbSamples != ref.nbSamples) || (stats.nbDuplicates != ref.nbDuplicates)
+        || (stats.nbLost != ref.nbLost) || (stats.nbRestarts != ref.nbRestarts) || (stats.nbDevices != p_check->nbDevices)) {
+        fprintf(stderr, "ingest: frames %llu, samples %llu, duplicates %llu, lost %llu, restarts %llu, devices %u instead of "
+                "%llu, %llu, %llu, %llu, %llu, %u\n", (unsigned long long)stats.nbFrames,
+                (unsigned long long)stats.nbSamples, (unsigned long long)stats.nbDuplicates,
+                (unsigned long long)stats.nbLost, (unsigned long long)stats.nbRestarts, stats.nbDevices,
+                (unsigned long long)ref.nbFrames, (unsigned long long)ref.nbSamples,
+                (unsigned long long)ref.nbDuplicates, (unsigned long long)ref.nbLost,
+                (unsigned long long)ref.nbRestarts, p_check->nbDevices);
+        nbErrors++;
+    }
+    return nbErrors;
+}
+
+//****************************************************************************
+// Wait until the engine has decoded nbFrames frames and given up nbLost. Returns the number of errors.
+static int check_ingest_wait_stats(uncompress_ingest_t *p_ingest, uint64_t nbFrames, uint64_t nbLost)
+{
+    uncompress_ingest_stats_t stats;
+
+    for (uint32_t ms = 0; ms < CHECK_INGEST_WAIT_MS; ms += 10) {
+        lib_uncompress_ingest_get_stats(p_ingest, &stats);
+        if ((stats.nbFrames == nbFrames) && (stats.nbLost == nbLost)) {
+            return 0;
+        }
+        usleep(10000);
+    }
+    fprintf(stderr, "ingest: timeout: %llu frames decoded and %llu lost after %u ms, instead of %llu and %llu\n",
+            (unsigned long long)stats.nbFrames, (unsigned long long)stats.nbLost, CHECK_INGEST_WAIT_MS,
+            (unsigned long long)nbFrames, (unsigned long long)nbLost);
+    return 1;
+}
+
+//****************************************************************************
+// A missing frame is given up after reorderTimeoutMs, then counted as a duplicate when it comes. A device sending
+// less frames than half the window is started after reorderTimeoutMs. At stop, only the missing frames before the
+// last one received are lost.
+static int check_ingest_timeout(void)
+{
+    static const uint32_t seqA[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 11 };
+    static const uint32_t seqB[] = { 0, 1, 3 };
+    def_check_ingest_t *p_check = calloc(1, sizeof(def_check_ingest_t));
+    const uncompress_corpus_t *p_corpus = NULL;
+    uint8_t *frames[12], lens[12];
+    uncompress_ingest_config_t config;
+    uncompress_ingest_stats_t stats;
+    uncompress_ingest_t *p_ingest = NULL;
+    uncompress_state_t state;
+    uint32_t idx = 0;
+    int nbErrors = 0;
+
+    for (uint32_t c = 0; (c < nbCorpora) && !p_corpus; c++) {
+        if (corpora[c].nbFrames >= 12) {
+            p_corpus = &corpora[c];
+        }
+    }
+    if (!p_check || !p_corpus) {
+        fprintf(stderr, "ingest: timeout: %s\n", p_check ? "no corpus of 12 frames" : "out of memory");
+        free(p_check);
+        return 1;
+    }
+    for (uint32_t i = 0; i < 12; i++) {
+        lib_uncompress_corpus_next_frame(p_corpus, &idx, &frames[i], &lens[i]);
+    }
+    // device A: frames 0 to 9 and 11, device B: frames 0, 1 and 3
+    p_check->nbDevices = 2;
+    p_check->devices[0].id = 1;
+    p_check->devices[1].id = 2;
+    lib_uncompress_state_init(&state);
+    for (uint32_t i = 0; (i < sizeof(seqA) / sizeof(seqA[0])) && !nbErrors; i++) {
+        lib_uncompress_state_new_frame(&state);
+        if (lib_uncompress_data_with_state(frames[seqA[i]], lens[seqA[i]], &samples, &state)) {
+            nbErrors += !!check_ingest_append(&p_check->devices[0].ref, &p_check->devices[0].nbRef,
+                                              &p_check->devices[0].refSize, samples.samples, samples.nbSamples);
+        }
+    }
+    lib_uncompress_state_init(&state);
+    for (uint32_t i = 0; (i < sizeof(seqB) / sizeof(seqB[0])) && !nbErrors; i++) {
+        lib_uncompress_state_new_frame(&state);
+        if (lib_uncompress_data_with_state(frames[seqB[i]], lens[seqB[i]], &samples, &state)) {
+            nbErrors += !!check_ingest_append(&p_check->devices[1].ref, &p_check->devices[1].nbRef,
+                                              &p_check->devices[1].refSize, samples.samples, samples.nbSamples);
+        }
+    }
+
+    lib_uncompress_ingest_config_default(&config);
+    config.nbWorkers = 1;
+    config.reorderWindow = 16;
+    config.reorderTimeoutMs = CHECK_INGEST_TIMEOUT_MS;
+    config.sink = check_ingest_sink;
+    config.p_user = p_check;
+    if (!nbErrors) {
+        p_ingest = lib_uncompress_ingest_start(&config);
+    }
+    if (!p_ingest) {
+        fprintf(stderr, "ingest: timeout: cannot start the engine\n");
+        nbErrors++;
+    } else {
+        for (uint32_t i = 0; i < sizeof(seqA) / sizeof(seqA[0]); i++) {
+            lib_uncompress_ingest_push(p_ingest, 1, seqA[i], frames[seqA[i]], lens[seqA[i]]);
+        }
+        nbErrors += check_ingest_wait_stats(p_ingest, 11, 1);
+        lib_uncompress_ingest_push(p_ingest, 1, 10, frames[10], lens[10]);
+        lib_uncompress_ingest_push(p_ingest, 2, 500 + seqB[0], frames[seqB[0]], lens[seqB[0]]);
+        lib_uncompress_ingest_push(p_ingest, 2, 500 + seqB[1], frames[seqB[1]], lens[seqB[1]]);
+        nbErrors += check_ingest_wait_stats(p_ingest, 13, 1);
+        lib_uncompress_ingest_push(p_ingest, 2, 500 + seqB[2], frames[seqB[2]], lens[seqB[2]]);
+        lib_uncompress_ingest_stop(p_ingest, &stats);
+        if ((stats.nbDuplicates != 1) || (stats.nbLost != 2)) {
+            fprintf(stderr, "ingest: timeout: %llu duplicates and %llu lost instead of 1 and 2\n",
+                    (unsigned long long)stats.nbDuplicates, (unsigned long long)stats.nbLost);
+            nbErrors++;
+        }
+        nbErrors += check_ingest_compare_device("ingest: timeout: device 1", &p_check->devices[0]);
+        nbErrors += check_ingest_compare_device("ingest: timeout: device 2", &p_check->devices[1]);
+    }
+    for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+        free(p_check->devices[d].ref);
+        free(p_check->devices[d].records);
+    }
+    free(p_check);
+    return nbErrors;
+}
+
+//****************************************************************************
+// A record of the replay file and of the socket of uncompress_ingest, returns its len
+static uint32_t check_ingest_record(uint8_t *p, const def_check_ingest_event_t *p_event)
+{
+    for (uint32_t b = 0; b < 4; b++) {
+        p[b] = p_event->deviceId >> (8 * b);
+        p[4 + b] = p_event->seq >> (8 * b);
+    }
+    p[8] = p_event->len;
+    memcpy(&p[9], p_event->frame, p_event->len);
+    return 9 + p_event->len;
+}
+
+//****************************************************************************
+static uint8_t check_file_flush(void *p_user, const uint8_t *data, uint32_t len)
+{
+    def_check_file_t *p_file = p_user;
+    uint8_t buffer[4096];
+
+    while (len) {
+        uint32_t nb = (len < sizeof(buffer)) ? len : sizeof(buffer);
+        if ((fread(buffer, 1, nb, p_file->file) != nb) || memcmp(buffer, data, nb)) {
+            return 0;
+        }
+        p_file->offset += nb;
+        data += nb;
+        len -= nb;
+    }
+    return 1;
+}
+
+//****************************************************************************
+// The CSV written by uncompress_ingest is the one of the default writer config
+static int check_ingest_compare_csv(const char *name, const char *path, const record_t *records, uint32_t nb)
+{
+    static uint8_t buffer[64 * 1024];
+    uncompress_writer_t writer;
+    def_check_file_t file = { fopen(path, "rb"), 0 };
+    int ret = 0;
+
+    if (!file.file) {
+        fprintf(stderr, "%s: %s: %s\n", name, path, strerror(errno));
+        return 1;
+    }
+    lib_uncompress_writer_init(&writer, buffer, sizeof(buffer), check_file_flush, &file, NULL);
+    if (!lib_uncompress_writer_add(&writer, records, nb) || !lib_uncompress_writer_flush(&writer)
+        || (fgetc(file.file) != EOF)) {
+        fprintf(stderr, "%s: %s differs from the CSV of the %u records expected, after byte %llu\n", name, path, nb,
+                (unsigned long long)file.offset);
+        ret = 1;
+    }
+    fclose(file.file);
+    return ret;
+}
+
+//****************************************************************************
+// Compare the CSV of each device written by uncompress_ingest in dir, then remove them and dir
+static int check_ingest_compare_dir(const char *name, const char *dir, const def_check_ingest_t *p_check)
+{
+    int nbErrors = 0;
+
+    for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+        const def_check_ingest_device_t *p_device = &p_check->devices[d];
+        char path[4096], deviceName[CHECK_NAME_LEN];
+
+        snprintf(path, sizeof(path), "%s/%u.csv", dir, p_device->id);
+        snprintf(deviceName, sizeof(deviceName), "%s: device %u", name, p_device->id);
+        nbErrors += check_ingest_compare_csv(deviceName, path, p_device->ref, p_device->nbRef);
+        unlink(path);
+    }
+    rmdir(dir);
+    return nbErrors;
+}
+
+//****************************************************************************
+// Start uncompress_ingest with args (args[0] is its name), without its counters on stdout. Returns its pid, -1 on error.
+static pid_t check_ingest_spawn(char **args)
+{
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        int fd = open("/dev/null", O_WRONLY);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+        }
+        execv(ingestToolPath, args);
+        fprintf(stderr, "%s: %s\n", ingestToolPath, strerror(errno));
+        _exit(127);
+    }
+    if (pid < 0) {
+        fprintf(stderr, "ingest: fork: %s\n", strerror(errno));
+    }
+    return pid;
+}
+
+//****************************************************************************
+// Wait for the end of uncompress_ingest, killed after CHECK_INGEST_WAIT_MS. Returns the number of errors.
+static int check_ingest_wait_tool(const char *name, pid_t pid)
+{
+    pid_t ret;
+    int status = 0;
+
+    for (uint32_t ms = 0; (ret = waitpid(pid, &status, WNOHANG)) == 0; ms += 10) {
+        if (ms >= CHECK_INGEST_WAIT_MS) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            fprintf(stderr, "%s: %s killed after %u ms\n", name, ingestToolPath, CHECK_INGEST_WAIT_MS);
+            return 1;
+        }
+        usleep(10000);
+    }
+    if ((ret < 0) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "%s: %s failed, status %d\n", name, ingestToolPath, status);
+        return 1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// The events written to a replay file, replayed by uncompress_ingest with several producers
+static int check_ingest_replay(const def_check_ingest_t *p_check)
+{
+    char replayPath[4096], outDir[4096], window[16];
+    char *args[] = { "uncompress_ingest", "-r", replayPath, "-p", "4", "-j", "3", "-w", window, "-o", outDir, NULL };
+    uint8_t record[CHECK_INGEST_RECORD_LEN];
+    FILE *file;
+    pid_t pid;
+    int nbErrors = 0;
+
+    if (check_temp_path(replayPath, sizeof(replayPath), "ingest_replay")) {
+        return 1;
+    }
+    if (check_temp_dir(outDir, sizeof(outDir), "ingest_replay_out")) {
+        unlink(replayPath);
+        return 1;
+    }
+    snprintf(window, sizeof(window), "%u", CHECK_INGEST_WINDOW);
+    file = fopen(replayPath, "wb");
+    for (uint32_t e = 0; file && (e < p_check->nbEvents); e++) {
+        uint32_t len = check_ingest_record(record, &p_check->events[e]);
+        if (fwrite(record, 1, len, file) != len) {
+            break;
+        }
+    }
+    if (!file || ferror(file)) {
+        fprintf(stderr, "%s: %s\n", replayPath, strerror(errno));
+        nbErrors++;
+    }
+    if (file && fclose(file) && !nbErrors) {
+        fprintf(stderr, "%s: %s\n", replayPath, strerror(errno));
+        nbErrors++;
+    }
+    if (!nbErrors) {
+        pid = check_ingest_spawn(args);
+        nbErrors += (pid < 0) ? 1 : check_ingest_wait_tool("ingest: replay", pid);
+    }
+    if (!nbErrors) {
+        nbErrors += check_ingest_compare_dir("ingest: replay", outDir, p_check);
+    }
+    unlink(replayPath);
+    rmdir(outDir);
+    return nbErrors;
+}
+
+//****************************************************************************
+static int check_ingest_send(int fd, const uint8_t *data, uint32_t len)
+{
+    while (len) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+//****************************************************************************
+// Client c sends all the frames of the devices c, c+CHECK_INGEST_NB_CLIENTS..., in order, then waits until they are read
+static void *check_ingest_client(void *arg)
+{
+    def_check_ingest_producer_t *p_client = arg;
+    const def_check_ingest_t *p_check = p_client->p_check;
+    struct sockaddr_un addr;
+    uint8_t buffer[64 * 1024];
+    uint32_t len = 0;
+    int fd = -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, p_client->path, sizeof(addr.sun_path) - 1);
+    // the tool is starting
+    for (uint32_t ms = 0; fd < 0; ms += 10) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if ((fd >= 0) && connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+            close(fd);
+            fd = -1;
+            if (ms >= CHECK_INGEST_WAIT_MS) {
+                fprintf(stderr, "ingest: socket: %s: %s\n", p_client->path, strerror(errno));
+                p_client->error = 1;
+                return NULL;
+            }
+            usleep(10000);
+        }
+    }
+    for (uint32_t e = 0; (e < p_check->nbEvents) && !p_client->error; e++) {
+        if (p_check->events[e].device % CHECK_INGEST_NB_CLIENTS != p_client->id) {
+            continue;
+        }
+        if (len + CHECK_INGEST_RECORD_LEN > sizeof(buffer)) {
+            p_client->error = check_ingest_send(fd, buffer, len) ? 1 : 0;
+            len = 0;
+        }
+        len += check_ingest_record(&buffer[len], &p_check->events[e]);
+    }
+    if (!p_client->error && check_ingest_send(fd, buffer, len)) {
+        p_client->error = 1;
+    }
+    if (p_client->error) {
+        fprintf(stderr, "ingest: socket: client %u: %s\n", p_client->id, strerror(errno));
+    }
+    // the tool closes the connection when it has read all the frames
+    shutdown(fd, SHUT_WR);
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+    close(fd);
+    return NULL;
+}
+
+//****************************************************************************
+// The events sent by clients of the socket of uncompress_ingest, stopped by SIGINT
+static int check_ingest_socket(const def_check_ingest_t *p_check)
+{
+    def_check_ingest_producer_t clients[CHECK_INGEST_NB_CLIENTS];
+    char socketPath[sizeof(((struct sockaddr_un *)0)->sun_path)], outDir[4096], window[16];
+    char *args[] = { "uncompress_ingest", "-s", socketPath, "-j", "3", "-w", window, "-o", outDir, NULL };
+    pid_t pid;
+    int nbErrors = 0;
+
+    if (check_temp_path(socketPath, sizeof(socketPath), "ingest_socket")) {
+        return 1;
+    }
+    unlink(socketPath);
+    if (check_temp_dir(outDir, sizeof(outDir), "ingest_socket_out")) {
+        return 1;
+    }
+    snprintf(window, sizeof(window), "%u", CHECK_INGEST_WINDOW);
+    pid = check_ingest_spawn(args);
+    if (pid < 0) {
+        rmdir(outDir);
+        return 1;
+    }
+    for (uint32_t c = 0; c < CHECK_INGEST_NB_CLIENTS; c++) {
+        memset(&clients[c], 0, sizeof(def_check_ingest_producer_t));
+        clients[c].p_check = p_check;
+        clients[c].id = c;
+        clients[c].path = socketPath;
+        pthread_create(&clients[c].thread, NULL, check_ingest_client, &clients[c]);
+    }
+    for (uint32_t c = 0; c < CHECK_INGEST_NB_CLIENTS; c++) {
+        pthread_join(clients[c].thread, NULL);
+        nbErrors += clients[c].error;
+    }
+    kill(pid, SIGINT);
+    nbErrors += check_ingest_wait_tool("ingest: socket", pid);
+    if (!nbErrors) {
+        nbErrors += check_ingest_compare_dir("ingest: socket", outDir, p_check);
+    }
+    unlink(socketPath);
+    rmdir(outDir);
+    return nbErrors;
+}
+
+//****************************************************************************
+/**
+ * A device per corpus, sending its first frames out of order and some twice: one with a counter wrapping around,
+ * one losing frames, one restarting. The ingest engine gives each device the records of sequential decoding,
+ * pushed by several threads, from a replay file and from socket clients of uncompress_ingest.
+ */
+static int check_ingest(void)
+{
+    def_check_ingest_t *p_check = calloc(1, sizeof(def_check_ingest_t));
+    def_check_ingest_role_t role = CHECK_INGEST_WRAP;
+    uint32_t seed = 0x1265;
+    int nbErrors = 0;
+
+    if (!p_check) {
+        fprintf(stderr, "ingest: out of memory\n");
+        return 1;
+    }
+    for (uint16_t c = 0; (c < nbCorpora) && !nbErrors; c++) {
+        // the roles go to corpora of several windows of frames
+        uint8_t large = corpora[c].nbFrames >= 4 * CHECK_INGEST_WINDOW;
+        nbErrors += check_ingest_device(&p_check->devices[c], c, &corpora[c], large ? role : CHECK_INGEST_PLAIN, &seed);
+        if (large && (role != CHECK_INGEST_PLAIN)) {
+            role = (role == CHECK_INGEST_RESTART) ? CHECK_INGEST_PLAIN : role + 1;
+        }
+        p_check->nbDevices++;
+    }
+    if (!nbErrors && (role != CHECK_INGEST_PLAIN)) {
+        fprintf(stderr, "ingest: not enough corpora of %u frames\n", 4 * CHECK_INGEST_WINDOW);
+        nbErrors++;
+    }
+    if (!nbErrors) {
+        nbErrors += check_ingest_merge(p_check);
+    }
+    if (!nbErrors) {
+        nbErrors += check_ingest_run(p_check);
+        nbErrors += check_ingest_timeout();
+        if (ingestToolPath) {
+            nbErrors += check_ingest_replay(p_check);
+            nbErrors += check_ingest_socket(p_check);
+        } else {
+            fprintf(stderr, "ingest: no -i, the inputs of uncompress_ingest are not checked\n");
+        }
+    }
+    for (uint16_t d = 0; d < p_check->nbDevices; d++) {
+        free(p_check->devices[d].events);
+        free(p_check->devices[d].ref);
+        free(p_check->devices[d].records);
+    }
+    free(p_check->events);
+    free(p_check);
+    return nbErrors;
+}
+
+//****************************************************************************
+static void check_usage(const char *name)
+{
+    fprintf(stderr, "usage: %s -s slots_data.dart [-i uncompress_ingest] [-k check]\n"
+            "  -s file      slot data of the example application (example/lib/slots_data.dart)\n"
+            "  -i file      the uncompress_ingest tool, to check its replay and socket inputs\n"
+            "  -k check     run only this check:", name);
+    for (uint32_t k = 0; k < sizeof(checks) / sizeof(checks[0]); k++) {
+        fprintf(stderr, " %s", checks[k].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+//****************************************************************************
+int main(int argc, char **argv)
+{
+    const char *slotsPath = NULL, *checkName = NULL;
+    uint32_t nbRun = 0;
+    int nbErrors = 0, opt;
+
+    while ((opt = getopt(argc, argv, "s:i:k:h")) != -1) {
+        switch (opt) {
+        case 's':
+            slotsPath = optarg;
+            break;
+        case 'i':
+            ingestToolPath = optarg;
+            break;
+        case 'k':
+            checkName = optarg;
+            break;
+        default:
+            check_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!slotsPath || (optind < argc)) {
+        check_usage(argv[0]);
+        return 2;
+    }
+    if (lib_uncompress_corpus_make_all(slotsPath, corpora, &nbCorpora)) {
+        return 2;
+    }
+    for (uint32_t k = 0; k < sizeof(checks) / sizeof(checks[0]); k++) {
+        if (!checkName || !strcmp(checkName, checks[k].name)) {
+            int nb = checks[k].run();
+            printf("%-12s %s\n", checks[k].name, nb ? "FAILED" : "ok");
+            nbErrors += nb;
+            nbRun++;
+        }
+    }
+    lib_uncompress_corpus_free(corpora, nbCorpora);
+    if (!nbRun) {
+        check_usage(argv[0]);
+        return 2;
+    }
+    return nbErrors ? 1 : 0;
+}
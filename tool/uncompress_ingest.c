@@ -0,0 +1,447 @@
+/**
+  ******************************************************************************
+  * \file uncompress_ingest.c
+  * \author S.Lejczyk
+  * \copyright 2020 BodyCap S.A.S.
+  * \brief Stand-in input for lib_uncompress_ingest, to run the gateway engine
+  *       without BLE hardware. Frames are read as records:
+  *         uint32_t deviceId, uint32_t frame counter (little endian),
+  *         uint8_t len, len bytes of compressed frame
+  *       from a replay file (split between producer threads) or from the
+  *       clients of a Unix socket (one producer thread per connection).
+  *
+  *       usage: uncompress_ingest [options] -r replay       replay a file
+  *              uncompress_ingest [options] -s path         listen on a Unix socket, until SIGINT
+  *              uncompress_ingest -m replay dump...         make a replay file, one device per dump
+  *       options: -j workers, -p producers (replay), -w reorder window, -o dir (one CSV per device),
+  *                -a (pin workers to CPUs), -x (lib_uncompress_data_resync)
+  */
+//****************************************************************************
+// Standard include files
+//****************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+//****************************************************************************
+// Project include files
+//****************************************************************************
+#include "lib_uncompress_ingest.h"
+
+//****************************************************************************
+// static Defines and enum typedef
+//****************************************************************************
+#define INGEST_RECORD_HEADER    9       // deviceId, counter, len
+#define INGEST_MAX_PRODUCERS    64
+#define INGEST_MAX_CLIENTS      256
+#define INGEST_REPLAY_MAX_SKEW  64      // max records between the fastest and the slowest replay producer
+
+//****************************************************************************
+// static Structures typedef
+//****************************************************************************
+typedef struct {
+    uncompress_ingest_t *p_ingest;
+    const uint8_t   *data;          // replay file
+    uint64_t        size;
+    uint32_t        id;
+    uint32_t        nbProducers;
+    uint32_t        *progress;      // next record of each replay producer (atomic)
+    int             fd;             // socket client
+    pthread_t       thread;
+} def_ingest_producer_t;
+
+//****************************************************************************
+// static Functions prototypes
+//****************************************************************************
+static uint32_t ingest_get_u32(const uint8_t *p);
+static void ingest_push(uncompress_ingest_t *p_ingest, const uint8_t *p_record);
+static void *ingest_replay_producer(void *arg);
+static void *ingest_socket_producer(void *arg);
+static void ingest_csv_sink(void *p_user, uint32_t deviceId, void **pp_session, const record_t *records, uint32_t nbRecords);
+static void ingest_count_sink(void *p_user, uint32_t deviceId, void **pp_session, const record_t *records, uint32_t nbRecords);
+static int ingest_make_replay(const char *path, int nbDumps, char **dumps);
+static int ingest_replay(uncompress_ingest_t *p_ingest, const char *path, uint32_t nbProducers);
+static int ingest_listen(uncompress_ingest_t *p_ingest, const char *path);
+static void ingest_on_signal(int sig);
+
+//****************************************************************************
+// static Variables
+//****************************************************************************
+static volatile sig_atomic_t stopRequested = 0;
+
+//****************************************************************************
+// Functions
+//****************************************************************************
+
+//****************************************************************************
+static uint32_t ingest_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//****************************************************************************
+static void ingest_push(uncompress_ingest_t *p_ingest, const uint8_t *p_record)
+{
+    // a producer is never dropped: wait for room in the queue
+    while (!lib_uncompress_ingest_push(p_ingest, ingest_get_u32(p_record), ingest_get_u32(p_record + 4),
+                                       p_record + INGEST_RECORD_HEADER, p_record[8])) {
+        sched_yield();
+    }
+}
+
+//****************************************************************************
+/**
+ * Producer p pushes the records p, p+nbProducers... so the frames of a device are spread over producers and
+ * arrive out of order, as from several radios. A producer waits when it is INGEST_REPLAY_MAX_SKEW records
+ * ahead of another one, so that frames are not delayed more than in a real gateway.
+ */
+static void *ingest_replay_producer(void *arg)
+{
+    def_ingest_producer_t *p_producer = arg;
+    uint64_t offset = 0;
+    uint32_t index = 0;
+
+    while (offset + INGEST_RECORD_HEADER <= p_producer->size) {
+        const uint8_t *p_record = p_producer->data + offset;
+        uint64_t next = offset + INGEST_RECORD_HEADER + p_record[8];
+        if (next > p_producer->size) {
+            break;
+        }
+        if (p_record[8] && ((index % p_producer->nbProducers) == p_producer->id)) {
+            __atomic_store_n(&p_producer->progress[p_producer->id], index, __ATOMIC_RELEASE);
+            for (uint32_t p = 0; p < p_producer->nbProducers; p++) {
+                while (__atomic_load_n(&p_producer->progress[p], __ATOMIC_ACQUIRE) + INGEST_REPLAY_MAX_SKEW < index) {
+                    sched_yield();
+                }
+            }
+            ingest_push(p_producer->p_ingest, p_record);
+        }
+        index++;
+        offset = next;
+    }
+    __atomic_store_n(&p_producer->progress[p_producer->id], UINT32_MAX - INGEST_REPLAY_MAX_SKEW, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+//****************************************************************************
+static void *ingest_socket_producer(void *arg)
+{
+    def_ingest_producer_t *p_producer = arg;
+    uint8_t buffer[64 * 1024];
+    uint32_t len = 0;
+
+    for (;;) {
+        uint32_t offset = 0;
+        ssize_t n = read(p_producer->fd, buffer + len, sizeof(buffer) - len);
+        if (n <= 0) {
+            if ((n < 0) && (errno == EINTR) && !stopRequested) {
+                continue;
+            }
+            break;
+        }
+        len += n;
+        while ((offset + INGEST_RECORD_HEADER <= len)
+               && (offset + INGEST_RECORD_HEADER + buffer[offset + 8] <= len)) {
+            if (buffer[offset + 8]) {
+                ingest_push(p_producer->p_ingest, buffer + offset);
+            }
+            offset += INGEST_RECORD_HEADER + buffer[offset + 8];
+        }
+        memmove(buffer, buffer + offset, len - offset);
+        len -= offset;
+    }
+    close(p_producer->fd);
+    return NULL;
+}
+
+//****************************************************************************
+// One CSV per device, written by the worker of the device
+static void ingest_csv_sink(void *p_user, uint32_t deviceId, void **pp_session, const record_t *records, uint32_t nbRecords)
+{
+    uncompress_writer_t *p_writer = *pp_session;
+
+    if (!p_writer) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%u.csv", (const char *)p_user, deviceId);
+        p_writer = lib_uncompress_writer_open(path, 0, NULL);
+        if (!p_writer) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return;
+        }
+        *pp_session = p_writer;
+    }
+    if (!records) {
+        if (!lib_uncompress_writer_close(p_writer)) {
+            fprintf(stderr, "device %u: write error\n", deviceId);
+        }
+        *pp_session = NULL;
+        return;
+    }
+    lib_uncompress_writer_add(p_writer, records, nbRecords);
+}
+
+//****************************************************************************
+static void ingest_count_sink(void *p_user, uint32_t deviceId, void **pp_session, const record_t *records, uint32_t nbRecords)
+{
+    (void)p_user;
+    (void)deviceId;
+    (void)pp_session;
+    (void)records;
+    (void)nbRecords;
+}
+
+//****************************************************************************
+// Interleave the frames of the dumps, device i+1 for dump i
+static int ingest_make_replay(const char *path, int nbDumps, char **dumps)
+{
+    FILE *out = fopen(path, "wb");
+    FILE **in = calloc(nbDumps, sizeof(FILE *));
+    uint32_t seq = 0;
+    int nbOpen = 0;
+
+    if (!out || !in) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    for (int i = 0; i < nbDumps; i++) {
+        in[i] = fopen(dumps[i], "rb");
+        if (!in[i]) {
+            fprintf(stderr, "%s: %s\n", dumps[i], strerror(errno));
+        } else {
+            nbOpen++;
+        }
+    }
+    while (nbOpen) {
+        for (int i = 0; i < nbDumps; i++) {
+            uint8_t record[INGEST_RECORD_HEADER + UINT8_MAX];
+            uint32_t deviceId = i + 1;
+            int len;
+            if (!in[i]) {
+                continue;
+            }
+            len = fgetc(in[i]);
+            if ((len == EOF) || (fread(record + INGEST_RECORD_HEADER, 1, len, in[i]) != (size_t)len)) {
+                fclose(in[i]);
+                in[i] = NULL;
+                nbOpen--;
+                continue;
+            }
+            for (int b = 0; b < 4; b++) {
+                record[b] = deviceId >> (8 * b);
+                record[4 + b] = seq >> (8 * b);
+            }
+            record[8] = len;
+            fwrite(record, 1, INGEST_RECORD_HEADER + len, out);
+        }
+        seq++;
+    }
+    free(in);
+    return fclose(out) ? 1 : 0;
+}
+
+//****************************************************************************
+static int ingest_replay(uncompress_ingest_t *p_ingest, const char *path, uint32_t nbProducers)
+{
+    def_ingest_producer_t producers[INGEST_MAX_PRODUCERS];
+    uint32_t progress[INGEST_MAX_PRODUCERS] = { 0 };
+    struct stat st;
+    uint8_t *data;
+    int fd = open(path, O_RDONLY);
+
+    if ((fd < 0) || fstat(fd, &st)) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (!st.st_size) {
+        close(fd);
+        return 0;
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    for (uint32_t p = 0; p < nbProducers; p++) {
+        producers[p].p_ingest = p_ingest;
+        producers[p].data = data;
+        producers[p].size = st.st_size;
+        producers[p].id = p;
+        producers[p].nbProducers = nbProducers;
+        producers[p].progress = progress;
+        pthread_create(&producers[p].thread, NULL, ingest_replay_producer, &producers[p]);
+    }
+    for (uint32_t p = 0; p < nbProducers; p++) {
+        pthread_join(producers[p].thread, NULL);
+    }
+    munmap(data, st.st_size);
+    return 0;
+}
+
+//****************************************************************************
+static int ingest_listen(uncompress_ingest_t *p_ingest, const char *path)
+{
+    def_ingest_producer_t *clients = calloc(INGEST_MAX_CLIENTS, sizeof(def_ingest_producer_t));
+    struct sockaddr_un addr;
+    sigset_t waitMask;
+    uint32_t nbClients = 0;
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (!clients || (server < 0) || bind(server, (struct sockaddr *)&addr, sizeof(addr)) || listen(server, 16)) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        free(clients);
+        return 1;
+    }
+    fprintf(stderr, "listening on %s\n", path);
+    // SIGINT and SIGTERM are blocked in every thread (see main) and only received in pselect,
+    // so a stop request cannot come between the test of stopRequested and the wait
+    pthread_sigmask(SIG_SETMASK, NULL, &waitMask);
+    sigdelset(&waitMask, SIGINT);
+    sigdelset(&waitMask, SIGTERM);
+    while (!stopRequested && (nbClients < INGEST_MAX_CLIENTS)) {
+        fd_set fds;
+        int fd;
+        FD_ZERO(&fds);
+        FD_SET(server, &fds);
+        if (pselect(server + 1, &fds, NULL, NULL, NULL, &waitMask) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        fd = accept(server, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        clients[nbClients].p_ingest = p_ingest;
+        clients[nbClients].fd = fd;
+        if (pthread_create(&clients[nbClients].thread, NULL, ingest_socket_producer, &clients[nbClients])) {
+            close(fd);
+            continue;
+        }
+        nbClients++;
+    }
+    // stop reading: the clients threads end on their next read
+    for (uint32_t c = 0; c < nbClients; c++) {
+        shutdown(clients[c].fd, SHUT_RD);
+    }
+    for (uint32_t c = 0; c < nbClients; c++) {
+        pthread_join(clients[c].thread, NULL);
+    }
+    close(server);
+    unlink(path);
+    free(clients);
+    return 0;
+}
+
+//****************************************************************************
+static void ingest_on_signal(int sig)
+{
+    (void)sig;
+    stopRequested = 1;
+}
+
+//****************************************************************************
+int main(int argc, char **argv)
+{
+    uncompress_ingest_config_t config;
+    uncompress_ingest_stats_t stats;
+    uncompress_ingest_t *p_ingest;
+    const char *replayPath = NULL, *socketPath = NULL, *makePath = NULL, *outDir = NULL;
+    uint32_t nbProducers = 4;
+    struct timespec start, end;
+    double seconds;
+    int opt, ret;
+
+    lib_uncompress_ingest_config_default(&config);
+    while ((opt = getopt(argc, argv, "r:s:m:j:p:w:o:axh")) != -1) {
+        switch (opt) {
+        case 'r': replayPath = optarg; break;
+        case 's': socketPath = optarg; break;
+        case 'm': makePath = optarg; break;
+        case 'j': config.nbWorkers = strtoul(optarg, NULL, 10); break;
+        case 'p': nbProducers = strtoul(optarg, NULL, 10); break;
+        case 'w': config.reorderWindow = strtoul(optarg, NULL, 10); break;
+        case 'o': outDir = optarg; break;
+        case 'a': config.pinWorkers = 1; break;
+        case 'x': config.resync = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-j workers] [-p producers] [-w window] [-o dir] [-a] [-x] -r replay | -s socket\n"
+                            "       %s -m replay dump...\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (makePath) {
+        return ingest_make_replay(makePath, argc - optind, argv + optind);
+    }
+    if (!replayPath == !socketPath) {
+        fprintf(stderr, "one of -r or -s is required\n");
+        return 2;
+    }
+    if ((nbProducers < 1) || (nbProducers > INGEST_MAX_PRODUCERS)) {
+        nbProducers = (nbProducers < 1) ? 1 : INGEST_MAX_PRODUCERS;
+    }
+    if (outDir && mkdir(outDir, 0755) && (errno != EEXIST)) {
+        fprintf(stderr, "%s: %s\n", outDir, strerror(errno));
+        return 1;
+    }
+    config.sink = outDir ? ingest_csv_sink : ingest_count_sink;
+    config.p_user = (void *)outDir;
+
+    if (socketPath) {
+        // inherited by the workers and the clients threads: only the listening thread is woken up by the signals
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    }
+    p_ingest = lib_uncompress_ingest_start(&config);
+    if (!p_ingest) {
+        fprintf(stderr, "cannot start the ingest engine\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (replayPath) {
+        ret = ingest_replay(p_ingest, replayPath, nbProducers);
+    } else {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = ingest_on_signal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        ret = ingest_listen(p_ingest, socketPath);
+    }
+    lib_uncompress_ingest_stop(p_ingest, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    printf("%u devices, %llu frames, %llu samples in %.3f s: %.0f frames/s\n"
+           "reordered %llu, lost %llu, duplicates %llu, restarts %llu, queue full %llu\n",
+           stats.nbDevices, (unsigned long long)stats.nbFrames, (unsigned long long)stats.nbSamples, seconds,
+           stats.nbFrames / (seconds > 0 ? seconds : 1e-9),
+           (unsigned long long)stats.nbReordered, (unsigned long long)stats.nbLost,
+           (unsigned long long)stats.nbDuplicates, (unsigned long long)stats.nbRestarts,
+           (unsigned long long)stats.nbFull);
+    return ret;
+}